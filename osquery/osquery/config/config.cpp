@@ -35,6 +35,7 @@
 #include <osquery/utils/conversions/split.h>
 #include <osquery/utils/conversions/trim.h>
 #include <osquery/utils/conversions/tryto.h>
+#include <osquery/utils/scope_guard.h>
 #include <osquery/utils/system/time.h>
 
 namespace rj = rapidjson;
@@ -170,8 +171,9 @@ class Schedule : private boost::noncopyable {
   /// Remove a pack by name and source.
   void remove(const std::string& pack, const std::string& source);
 
-  /// Remove all packs by source.
-  void removeAll(const std::string& source);
+  /// Move all packs of a source into packs, keyed by source and pack name.
+  void detachAll(const std::string& source,
+                 std::map<std::string, PackRef>& packs);
 
   /// Boost gives us a nice template for maintaining the state of the iterator
   using iterator = boost::filter_iterator<Step, container::iterator>;
@@ -260,17 +262,17 @@ Schedule::getSqlQueriesForSource(const std::string& source) {
   return queries;
 }
 
-void Schedule::removeAll(const std::string& source) {
-  auto new_end =
-      std::remove_if(packs_.begin(), packs_.end(), [source](const PackRef& p) {
-        if (p->getSource() == source) {
-          Config::get().removeFiles(source + FLAGS_pack_delimiter +
-                                    p->getName());
-          return true;
-        }
-        return false;
-      });
-  packs_.erase(new_end, packs_.end());
+void Schedule::detachAll(const std::string& source,
+                         std::map<std::string, PackRef>& packs) {
+  auto it = packs_.begin();
+  while (it != packs_.end()) {
+    if ((*it)->getSource() == source) {
+      packs[source + FLAGS_pack_delimiter + (*it)->getName()] = std::move(*it);
+      it = packs_.erase(it);
+    } else {
+      it++;
+    }
+  }
 }
 
 Schedule::iterator Schedule::begin() {
@@ -367,6 +369,51 @@ Config& Config::get() {
   return instance;
 }
 
+/// Hash the canonical serialization of a pack's JSON content.
+static std::string hashPackContent(const rj::Value& obj) {
+  rj::StringBuffer buffer;
+  rj::Writer<rj::StringBuffer> writer(buffer);
+  obj.Accept(writer);
+
+  Hash hash(HASH_TYPE_SHA1);
+  hash.update(buffer.GetString(), buffer.GetSize());
+  return hash.digest();
+}
+
+bool Config::reusePack(const std::string& pack_source,
+                       const std::string& digest) {
+  RecursiveLock wlock(config_schedule_mutex_);
+  auto detached = detached_packs_.find(pack_source);
+  if (detached == detached_packs_.end()) {
+    pack_hash_.erase(pack_source);
+    return false;
+  }
+
+  auto pack = std::move(detached->second);
+  detached_packs_.erase(detached);
+
+  auto hash = pack_hash_.find(pack_source);
+  if (hash != pack_hash_.end() && hash->second == digest &&
+      pack->shouldPackExecute()) {
+    schedule_->add(std::move(pack));
+    return true;
+  }
+
+  // The pack changed, or stopped executing, remove the old parser state.
+  pack_hash_.erase(pack_source);
+  removeFiles(pack_source);
+  return false;
+}
+
+void Config::dropDetachedPacks() {
+  RecursiveLock wlock(config_schedule_mutex_);
+  for (const auto& detached : detached_packs_) {
+    pack_hash_.erase(detached.first);
+    removeFiles(detached.first);
+  }
+  detached_packs_.clear();
+}
+
 void Config::addPack(const std::string& name,
                      const std::string& source,
                      const rj::Value& obj) {
@@ -375,6 +422,13 @@ void Config::addPack(const std::string& name,
   auto addSinglePack = ([this, &source](const std::string pack_name,
                                         const rj::Value& pack_obj) {
     RecursiveLock wlock(config_schedule_mutex_);
+    auto pack_source = source + FLAGS_pack_delimiter + pack_name;
+    auto digest = hashPackContent(pack_obj);
+    if (reusePack(pack_source, digest)) {
+      // The pack content is unchanged, the parsers already applied it.
+      return;
+    }
+
     try {
       schedule_->add(std::make_unique<Pack>(pack_name, source, pack_obj));
 #ifndef OSQUERY_IS_FUZZING
@@ -383,7 +437,8 @@ void Config::addPack(const std::string& name,
       bool should_pack_execute = true;
 #endif
       if (should_pack_execute) {
-        applyParsers(source + FLAGS_pack_delimiter + pack_name, pack_obj, true);
+        applyParsers(pack_source, pack_obj, true);
+        pack_hash_[pack_source] = std::move(digest);
       }
     } catch (const std::exception& e) {
       LOG(WARNING) << "Error adding pack: " << pack_name << ": " << e.what();
@@ -713,11 +768,14 @@ Status Config::updateSource(const std::string& source,
   auto queries = schedule_->getSqlQueriesForSource(source);
   {
     RecursiveLock lock(config_schedule_mutex_);
-    // Remove all packs from this source.
-    schedule_->removeAll(source);
+    // Detach all packs from this source, unchanged packs are reused.
+    schedule_->detachAll(source, detached_packs_);
     // Remove all files from this source.
     removeFiles(source);
   }
+  // Packs that are not added back are removed, even if parsing fails.
+  auto const drop_detached =
+      scope_guard::create([this]() { dropDetachedPacks(); });
 
   // load the config (source.second) into a JSON object.
   auto doc = JSON::newObject();
@@ -978,8 +1036,29 @@ Status Config::update(const ConfigMap& config) {
     }
   }
 
+  // The backup is only rewritten if a source was added, removed or changed
+  // since the last backup.
   if (FLAGS_config_enable_backup) {
-    backupConfig(config);
+    std::map<std::string, std::string> hashes;
+    {
+      WriteLock lock(config_hash_mutex_);
+      for (const auto& source : config) {
+        hashes[source.first] = hash_[source.first];
+      }
+    }
+
+    bool changed = false;
+    {
+      WriteLock lock(config_backup_mutex_);
+      if (hashes != backup_hash_) {
+        backup_hash_ = std::move(hashes);
+        changed = true;
+      }
+    }
+
+    if (changed) {
+      backupConfig(config);
+    }
   }
 
   return Status::success();
@@ -1046,6 +1125,12 @@ void Config::reset() {
   schedule_ = std::make_unique<Schedule>();
   std::map<std::string, FileCategories>().swap(files_);
   std::map<std::string, std::string>().swap(hash_);
+  std::map<std::string, std::string>().swap(pack_hash_);
+  {
+    WriteLock lock(config_backup_mutex_);
+    std::map<std::string, std::string>().swap(backup_hash_);
+  }
+  detached_packs_.clear();
   valid_ = false;
   loaded_ = false;
   is_first_time_refresh = true;
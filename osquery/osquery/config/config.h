@@ -273,6 +273,23 @@ class Config : private boost::noncopyable {
   /// A step method for Config::update.
   Status updateSource(const std::string& source, const std::string& json);
 
+  /**
+   * @brief Return a pack detached by updateSource to the schedule.
+   *
+   * When a source changes its packs are detached from the schedule instead
+   * of being destroyed. A detached pack whose content hash is unchanged is
+   * moved back into the schedule, keeping its parsed queries, discovery
+   * cache, and the state its config parsers created.
+   *
+   * @param pack_source The pack's source and name joined by the delimiter.
+   * @param digest The content hash of the incoming pack JSON.
+   * @return true if the detached pack was reused.
+   */
+  bool reusePack(const std::string& pack_source, const std::string& digest);
+
+  /// Remove the files and hashes of packs that were not reused.
+  void dropDetachedPacks();
+
   /**
    * @brief Generate pack content from a resource handled by the Plugin.
    *
@@ -338,6 +355,15 @@ class Config : private boost::noncopyable {
   /// A set of hashes for each source of the config.
   std::map<std::string, std::string> hash_;
 
+  /// The hash of each source when the config was last backed up.
+  std::map<std::string, std::string> backup_hash_;
+
+  /// Content hashes of executing packs, keyed by source and pack name.
+  std::map<std::string, std::string> pack_hash_;
+
+  /// Packs detached from the schedule while their source is updated.
+  std::map<std::string, std::unique_ptr<Pack>> detached_packs_;
+
   /// Check if the config received valid/parsable content from a config plugin.
   bool valid_{false};
 
@@ -369,11 +395,13 @@ class Config : private boost::noncopyable {
   friend class WatcherTests;
   FRIEND_TEST(ConfigTests, test_config_backup);
   FRIEND_TEST(ConfigTests, test_config_backup_integrate);
+  FRIEND_TEST(ConfigTests, test_config_backup_unchanged);
   FRIEND_TEST(ConfigTests, test_config_refresh);
   FRIEND_TEST(ConfigTests, test_get_scheduled_queries);
   FRIEND_TEST(ConfigTests, test_nondenylist_query);
   FRIEND_TEST(ConfigTests, test_config_cli_flags);
   FRIEND_TEST(ConfigTests, test_pack_stats);
+  FRIEND_TEST(ConfigTests, test_pack_reuse);
   FRIEND_TEST(OptionsConfigParserPluginTests, test_get_option);
   FRIEND_TEST(OptionsConfigParserPluginTests, test_get_option_first);
   FRIEND_TEST(ViewsConfigParserPluginTests, test_add_view);
@@ -670,6 +670,69 @@ TEST_F(ConfigTests, test_plugin_reconfigure) {
   rf.registry("config_parser")->remove("placebo");
 }
 
+class CountingConfigParserPlugin : public ConfigParserPlugin {
+ public:
+  std::vector<std::string> keys() const override {
+    return {};
+  }
+  Status update(const std::string& source, const ParserConfig&) override {
+    updates[source]++;
+    return Status::success();
+  }
+
+  std::map<std::string, size_t> updates;
+};
+
+TEST_F(ConfigTests, test_pack_reuse) {
+  auto& rf = RegistryFactory::get();
+  auto counter = std::make_shared<CountingConfigParserPlugin>();
+  rf.registry("config_parser")->add("counting", counter);
+
+  auto findPack = [this](const std::string& name) {
+    const Pack* found = nullptr;
+    get().packs(([&found, &name](const Pack& pack) {
+      if (pack.getName() == name) {
+        found = &pack;
+      }
+    }));
+    return found;
+  };
+
+  get().update({{"data", R"({"packs": {
+    "a": {"queries": {"q": {"query": "select 1", "interval": 60}}},
+    "b": {"queries": {"q": {"query": "select 2", "interval": 60}}}}})"}});
+  const auto* pack_a = findPack("a");
+  ASSERT_NE(pack_a, nullptr);
+  EXPECT_EQ(counter->updates["data_a"], 1U);
+  EXPECT_EQ(counter->updates["data_b"], 1U);
+
+  // Only the changed pack is rebuilt and re-parsed.
+  get().update({{"data", R"({"packs": {
+    "a": {"queries": {"q": {"query": "select 1", "interval": 60}}},
+    "b": {"queries": {"q": {"query": "select 3", "interval": 60}}}}})"}});
+  EXPECT_EQ(findPack("a"), pack_a);
+  EXPECT_EQ(counter->updates["data_a"], 1U);
+  EXPECT_EQ(counter->updates["data_b"], 2U);
+  EXPECT_EQ(counter->updates["data"], 2U);
+
+  // Removed packs are not kept.
+  get().update({{"data", R"({"packs": {
+    "a": {"queries": {"q": {"query": "select 1", "interval": 60}}}}})"}});
+  EXPECT_EQ(findPack("a"), pack_a);
+  EXPECT_EQ(findPack("b"), nullptr);
+  EXPECT_TRUE(get().detached_packs_.empty());
+  EXPECT_EQ(get().pack_hash_.count("data_b"), 0U);
+
+  // Re-adding a pack parses it again.
+  get().update({{"data", R"({"packs": {
+    "a": {"queries": {"q": {"query": "select 1", "interval": 60}}},
+    "b": {"queries": {"q": {"query": "select 3", "interval": 60}}}}})"}});
+  EXPECT_EQ(counter->updates["data_a"], 1U);
+  EXPECT_EQ(counter->updates["data_b"], 3U);
+
+  rf.registry("config_parser")->remove("counting");
+}
+
 TEST_F(ConfigTests, test_pack_file_paths) {
   size_t count = 0;
   auto fileCounter = [&count](const std::string& c,
@@ -831,6 +894,35 @@ TEST_F(ConfigTests, test_config_backup_integrate) {
   FLAGS_config_enable_backup = config_enable_backup_saved;
 }
 
+TEST_F(ConfigTests, test_config_backup_unchanged) {
+  const auto config_enable_backup_saved = FLAGS_config_enable_backup;
+  FLAGS_config_enable_backup = true;
+
+  get().reset();
+  const std::string key = "config_persistence.b";
+  EXPECT_TRUE(get().update({{"a", "{}"}, {"b", "{}"}}).ok());
+
+  std::string value;
+  EXPECT_TRUE(getDatabaseValue(kPersistentSettings, key, value).ok());
+  EXPECT_EQ(value, "{}");
+  deleteDatabaseValue(kPersistentSettings, key);
+
+  // Refreshing the same content does not rewrite the backup.
+  EXPECT_TRUE(get().update({{"a", "{}"}, {"b", "{}"}}).ok());
+  value.clear();
+  getDatabaseValue(kPersistentSettings, key, value);
+  EXPECT_TRUE(value.empty());
+
+  // Changed content with the same number of sources does.
+  const std::string changed = "{\"options\":{}}";
+  EXPECT_TRUE(get().update({{"a", "{}"}, {"b", changed}}).ok());
+  EXPECT_TRUE(getDatabaseValue(kPersistentSettings, key, value).ok());
+  EXPECT_EQ(value, changed);
+
+  get().reset();
+  FLAGS_config_enable_backup = config_enable_backup_saved;
+}
+
 TEST_F(ConfigTests, test_config_cli_flags) {
   get().reset();
 
@@ -40,6 +40,7 @@
 #include <osquery/events/eventfactory.h>
 #include <osquery/events/events.h>
 #include <osquery/extensions/extensions.h>
+#include <osquery/extensions/native_modules.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/data_logger.h>
 #include <osquery/numeric_monitoring/numeric_monitoring.h>
@@ -697,6 +698,11 @@ void Initializer::start() const {
       requestShutdown(retcode, "Failed to upgrade database");
       return;
     }
+
+    // Native module tables run in the process executing queries, so the
+    // watchdog limits of the worker apply to them. They must be registered
+    // before the first SQLite connection attaches the table registry.
+    loadNativeModules();
   }
 
   // Bind to an extensions socket and wait for registry additions.
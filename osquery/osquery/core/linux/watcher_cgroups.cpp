@@ -0,0 +1,349 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <osquery/core/linux/watcher_cgroups.h>
+#include <osquery/filesystem/filesystem.h>
+#include <osquery/logger/logger.h>
+#include <osquery/utils/conversions/split.h>
+#include <osquery/utils/conversions/tryto.h>
+
+namespace osquery {
+
+namespace {
+
+/// The cpu.max period, the quota is a share of it.
+const std::uint64_t kCpuPeriodUs{100000};
+
+/// Smallest quota accepted by the kernel.
+const std::uint64_t kCpuMinQuotaUs{1000};
+
+/// Signal when tasks stall on memory for 150ms within a 2s window.
+const std::string kMemoryPressureTrigger{"some 150000 2000000"};
+
+/// How often wait checks for an interruption.
+const std::chrono::milliseconds kWaitSlice{100};
+
+/// Leaf holding the watcher itself, cgroups with children cannot hold tasks.
+const std::string kWatcherLeaf{"watcher"};
+
+Status writeCgroupFile(const std::string& path, const std::string& value) {
+  int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return Status::failure("Cannot open " + path + ": " +
+                           std::string(std::strerror(errno)));
+  }
+
+  auto bytes = ::write(fd, value.data(), value.size());
+  auto error = errno;
+  ::close(fd);
+  if (bytes != static_cast<ssize_t>(value.size())) {
+    return Status::failure("Cannot write " + value + " to " + path + ": " +
+                           std::string(std::strerror(error)));
+  }
+  return Status::success();
+}
+
+Status makeCgroup(const std::string& path) {
+  if (::mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+    return Status::failure("Cannot create cgroup " + path + ": " +
+                           std::string(std::strerror(errno)));
+  }
+  return Status::success();
+}
+
+std::string getLimitValue(std::uint64_t bytes) {
+  return (bytes == 0) ? "max" : std::to_string(bytes);
+}
+
+std::string getCpuMaxValue(std::uint64_t percent) {
+  if (percent == 0 || percent >= 100) {
+    return "max " + std::to_string(kCpuPeriodUs);
+  }
+
+  std::uint64_t cpus = std::max(std::thread::hardware_concurrency(), 1U);
+  auto quota = std::max(percent * kCpuPeriodUs * cpus / 100, kCpuMinQuotaUs);
+  return std::to_string(quota) + " " + std::to_string(kCpuPeriodUs);
+}
+
+} // namespace
+
+WatcherCgroups::WatcherCgroups(std::string root) : root_(std::move(root)) {}
+
+WatcherCgroups::~WatcherCgroups() {
+  std::vector<std::string> names;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& leaf : leaves_) {
+      names.push_back(leaf.first);
+    }
+  }
+
+  for (const auto& name : names) {
+    remove(name);
+  }
+}
+
+Status WatcherCgroups::getProcessCgroup(std::string& path,
+                                        const std::string& mount,
+                                        const std::string& proc_cgroup) {
+  std::string content;
+  auto status = readFile(proc_cgroup, content);
+  if (!status.ok()) {
+    return status;
+  }
+
+  // The unified hierarchy is listed as "0::/path".
+  for (const auto& line : split(content, "\n")) {
+    if (line == "0::/") {
+      return Status::failure("Process is in the root cgroup");
+    }
+
+    if (boost::starts_with(line, "0::/")) {
+      path = mount + line.substr(3);
+
+      if (!pathExists(path + "/cgroup.controllers").ok()) {
+        return Status::failure("No cgroup v2 hierarchy at " + path);
+      }
+      return Status::success();
+    }
+  }
+
+  return Status::failure("Process is not in a cgroup v2 hierarchy");
+}
+
+Status WatcherCgroups::setUp() {
+  auto leaf = root_ + "/" + kWatcherLeaf;
+  auto status = makeCgroup(leaf);
+  if (!status.ok()) {
+    return status;
+  }
+
+  status = writeCgroupFile(leaf + "/cgroup.procs", std::to_string(getpid()));
+  if (!status.ok()) {
+    return status;
+  }
+
+  return writeCgroupFile(root_ + "/cgroup.subtree_control", "+cpu +memory");
+}
+
+Status WatcherCgroups::attach(const std::string& name,
+                              pid_t pid,
+                              const CgroupLimits& limits) {
+  auto path = root_ + "/" + name;
+  auto status = makeCgroup(path);
+  if (!status.ok()) {
+    return status;
+  }
+
+  // Apply the limits before the move, so the process is never unbounded.
+  status =
+      writeCgroupFile(path + "/cpu.max", getCpuMaxValue(limits.cpu_percent));
+  if (status.ok()) {
+    status = writeCgroupFile(path + "/memory.high",
+                             getLimitValue(limits.memory_high));
+  }
+  if (status.ok()) {
+    status =
+        writeCgroupFile(path + "/memory.max", getLimitValue(limits.memory_max));
+  }
+  if (status.ok()) {
+    status = writeCgroupFile(path + "/cgroup.procs", std::to_string(pid));
+  }
+  if (!status.ok()) {
+    return status;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& leaf = leaves_[name];
+  if (leaf.pressure_fd < 0) {
+    // A PSI trigger lives as long as the descriptor it was written to.
+    auto pressure = path + "/memory.pressure";
+    leaf.pressure_fd =
+        ::open(pressure.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (leaf.pressure_fd >= 0 &&
+        ::write(leaf.pressure_fd,
+                kMemoryPressureTrigger.c_str(),
+                kMemoryPressureTrigger.size() + 1) < 0) {
+      VLOG(1) << "Cannot register memory pressure trigger for " << path << ": "
+              << std::strerror(errno);
+      ::close(leaf.pressure_fd);
+      leaf.pressure_fd = -1;
+    }
+  }
+
+  if (leaf.events_fd < 0) {
+    auto events = path + "/memory.events";
+    leaf.events_fd =
+        ::open(events.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (leaf.events_fd >= 0) {
+      // Notifications are raised for changes after the last read.
+      char buffer[256];
+      (void)::pread(leaf.events_fd, buffer, sizeof(buffer), 0);
+    }
+  }
+
+  return Status::success();
+}
+
+Status WatcherCgroups::getStats(const std::string& name,
+                                CgroupStats& stats) const {
+  auto path = root_ + "/" + name;
+
+  std::string content;
+  auto status = readFile(path + "/memory.pressure", content);
+  if (!status.ok()) {
+    return status;
+  }
+  stats.memory_pressure = parsePressure(content);
+
+  status = readFile(path + "/memory.events", content);
+  if (!status.ok()) {
+    return status;
+  }
+  auto events = parseKeyedFile(content);
+  stats.memory_high_events = events["high"];
+  stats.oom_kills = events["oom_kill"];
+
+  status = readFile(path + "/cpu.stat", content);
+  if (!status.ok()) {
+    return status;
+  }
+  stats.cpu_throttled = parseKeyedFile(content)["nr_throttled"];
+  return Status::success();
+}
+
+bool WatcherCgroups::wait(std::chrono::milliseconds timeout,
+                          const std::function<bool()>& interrupted) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!interrupted()) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0) {
+      return false;
+    }
+
+    // Descriptors are only closed with the lock held, keep it while polling.
+    auto slice = std::min(remaining, kWaitSlice);
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<struct pollfd> fds;
+    for (const auto& leaf : leaves_) {
+      for (int fd : {leaf.second.pressure_fd, leaf.second.events_fd}) {
+        if (fd >= 0) {
+          fds.push_back({fd, POLLPRI, 0});
+        }
+      }
+    }
+
+    if (fds.empty()) {
+      lock.unlock();
+      std::this_thread::sleep_for(slice);
+      continue;
+    }
+
+    auto ready =
+        ::poll(fds.data(), fds.size(), static_cast<int>(slice.count()));
+    if (ready <= 0) {
+      continue;
+    }
+
+    for (const auto& fd : fds) {
+      if (fd.revents != 0) {
+        // Rearm memory.events, pressure triggers rearm themselves.
+        char buffer[256];
+        (void)::pread(fd.fd, buffer, sizeof(buffer), 0);
+      }
+    }
+    return true;
+  }
+
+  return false;
+}
+
+void WatcherCgroups::remove(const std::string& name) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto leaf = leaves_.find(name);
+    if (leaf != leaves_.end()) {
+      closeLeaf(leaf->second);
+      leaves_.erase(leaf);
+    }
+  }
+
+  // A leaf still holding a process is left in place.
+  auto path = root_ + "/" + name;
+  if (::rmdir(path.c_str()) != 0 && errno != ENOENT) {
+    VLOG(1) << "Cannot remove cgroup " << path << ": " << std::strerror(errno);
+  }
+}
+
+std::string WatcherCgroups::getLeafName(const std::string& path) {
+  auto slash = path.find_last_of('/');
+  auto base = (slash == std::string::npos) ? path : path.substr(slash + 1);
+
+  std::string name = "extension.";
+  for (const auto c : base) {
+    name += (std::isalnum(static_cast<unsigned char>(c)) || c == '-' ||
+             c == '_' || c == '.')
+                ? c
+                : '_';
+  }
+  return name;
+}
+
+double WatcherCgroups::parsePressure(const std::string& content) {
+  for (const auto& line : split(content, "\n")) {
+    if (!boost::starts_with(line, "some ")) {
+      continue;
+    }
+
+    for (const auto& field : split(line, " ")) {
+      if (boost::starts_with(field, "avg10=")) {
+        return std::strtod(field.c_str() + 6, nullptr);
+      }
+    }
+  }
+  return 0;
+}
+
+std::map<std::string, std::uint64_t> WatcherCgroups::parseKeyedFile(
+    const std::string& content) {
+  std::map<std::string, std::uint64_t> values;
+  for (const auto& line : split(content, "\n")) {
+    auto fields = split(line, " ");
+    if (fields.size() == 2) {
+      values[fields[0]] = tryTo<unsigned long long>(fields[1]).takeOr(0ULL);
+    }
+  }
+  return values;
+}
+
+void WatcherCgroups::closeLeaf(Leaf& leaf) {
+  for (int* fd : {&leaf.pressure_fd, &leaf.events_fd}) {
+    if (*fd >= 0) {
+      ::close(*fd);
+      *fd = -1;
+    }
+  }
+}
+
+} // namespace osquery
@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/utils/status/status.h>
+
+namespace osquery {
+
+/// Resource limits applied to a watched process cgroup.
+struct CgroupLimits {
+  /// CPU bandwidth as a percentage of all CPUs, 0 for unlimited.
+  std::uint64_t cpu_percent{0};
+
+  /// Bytes above which the kernel throttles and reclaims, 0 for unlimited.
+  std::uint64_t memory_high{0};
+
+  /// Bytes above which the kernel OOM-kills the group, 0 for unlimited.
+  std::uint64_t memory_max{0};
+};
+
+/// Pressure and event counters read from a watched process cgroup.
+struct CgroupStats {
+  /// Share of the last 10 seconds some task waited on memory, in percent.
+  double memory_pressure{0};
+
+  /// Number of periods the group was throttled by cpu.max.
+  std::uint64_t cpu_throttled{0};
+
+  /// Number of times the group went over memory.high.
+  std::uint64_t memory_high_events{0};
+
+  /// Number of processes killed by the group's OOM killer.
+  std::uint64_t oom_kills{0};
+};
+
+/**
+ * @brief cgroup v2 subtrees for the watchdog's worker and extensions.
+ *
+ * The watcher moves itself into a "watcher" leaf of the cgroup it was started
+ * in, which must be delegated to it (e.g. systemd's Delegate=yes), enables
+ * the cpu and memory controllers, and places each child in its own leaf.
+ * The kernel then throttles a child at its limits instead of the watchdog
+ * killing it, and memory pressure and memory events are reported through
+ * pollable files.
+ */
+class WatcherCgroups : private boost::noncopyable {
+ public:
+  /// Manage the cgroup directory root (e.g. /sys/fs/cgroup/osqueryd.service).
+  explicit WatcherCgroups(std::string root);
+
+  ~WatcherCgroups();
+
+  /**
+   * @brief Find the cgroup v2 directory of the current process.
+   *
+   * @param path Output, the absolute cgroup directory.
+   * @param mount The cgroup2 filesystem mount point.
+   * @param proc_cgroup The process' cgroup membership file.
+   */
+  static Status getProcessCgroup(
+      std::string& path,
+      const std::string& mount = "/sys/fs/cgroup",
+      const std::string& proc_cgroup = "/proc/self/cgroup");
+
+  /// Move the current process into a leaf and enable cpu and memory control.
+  Status setUp();
+
+  /**
+   * @brief Create or update a leaf cgroup and move a process into it.
+   *
+   * @param name The leaf name, relative to the root.
+   * @param pid The process to move.
+   * @param limits The limits to apply to the leaf.
+   */
+  Status attach(const std::string& name,
+                pid_t pid,
+                const CgroupLimits& limits);
+
+  /// Read the pressure and event counters of a leaf.
+  Status getStats(const std::string& name, CgroupStats& stats) const;
+
+  /**
+   * @brief Wait for a memory pressure trigger or memory event from any leaf.
+   *
+   * @param timeout The longest time to wait.
+   * @param interrupted Checked between short waits, stop when it is true.
+   * @return true if a leaf reported an event.
+   */
+  bool wait(std::chrono::milliseconds timeout,
+            const std::function<bool()>& interrupted);
+
+  /// Stop watching a leaf and remove it if it is empty.
+  void remove(const std::string& name);
+
+  /// Return a leaf name usable for a process path.
+  static std::string getLeafName(const std::string& path);
+
+  /// Parse the "some avg10" value of a PSI pressure file.
+  static double parsePressure(const std::string& content);
+
+  /// Parse a flat keyed file, such as memory.events or cpu.stat.
+  static std::map<std::string, std::uint64_t> parseKeyedFile(
+      const std::string& content);
+
+ private:
+  struct Leaf {
+    /// memory.pressure with a PSI trigger registered, or -1.
+    int pressure_fd{-1};
+
+    /// memory.events, signalled by the kernel on changes, or -1.
+    int events_fd{-1};
+  };
+
+  void closeLeaf(Leaf& leaf);
+
+ private:
+  const std::string root_;
+
+  std::map<std::string, Leaf> leaves_;
+
+  mutable std::mutex mutex_;
+};
+
+} // namespace osquery
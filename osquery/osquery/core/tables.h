@@ -192,6 +192,12 @@ enum class TableAttributes {
 
   /// (Deprecated) This table's data requires an osquery kernel module.
   KERNEL_REQUIRED = 16,
+
+  /// This table is only cheap to generate when its index columns are used.
+  EXPENSIVE = 32,
+
+  /// The rows are generated in ascending order of the 'time' column.
+  TIME_ORDERED = 64,
 };
 
 /// Treat table attributes as a set of flags.
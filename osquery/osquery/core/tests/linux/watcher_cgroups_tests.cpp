@@ -0,0 +1,191 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <thread>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <osquery/core/linux/watcher_cgroups.h>
+#include <osquery/filesystem/filesystem.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+class WatcherCgroupsTests : public testing::Test {
+ public:
+  WatcherCgroupsTests()
+      : root_(fs::temp_directory_path() /
+              fs::unique_path("osquery.cgroups.%%%%.%%%%")) {}
+
+  void SetUp() override {
+    fs::create_directories(root_);
+  }
+
+  void TearDown() override {
+    fs::remove_all(root_);
+  }
+
+ protected:
+  /// Create the interface files of a cgroup, as cgroupfs would.
+  void createCgroup(const fs::path& path) {
+    fs::create_directories(path);
+    for (const auto& file : {"cgroup.controllers",
+                             "cgroup.procs",
+                             "cgroup.subtree_control",
+                             "cpu.max",
+                             "cpu.stat",
+                             "memory.events",
+                             "memory.high",
+                             "memory.max",
+                             "memory.pressure"}) {
+      writeTextFile(path / file, "");
+    }
+  }
+
+  std::string read(const fs::path& path) {
+    std::string content;
+    readFile(path, content);
+    return content;
+  }
+
+ protected:
+  fs::path root_;
+};
+
+TEST_F(WatcherCgroupsTests, test_get_process_cgroup) {
+  auto proc_cgroup = root_ / "cgroup";
+  writeTextFile(proc_cgroup, "0::/system.slice/osqueryd.service\n");
+
+  // Without the cgroup2 interface files this is not a unified hierarchy.
+  std::string path;
+  EXPECT_FALSE(WatcherCgroups::getProcessCgroup(
+                   path, root_.string(), proc_cgroup.string())
+                   .ok());
+
+  createCgroup(root_ / "system.slice" / "osqueryd.service");
+  ASSERT_TRUE(WatcherCgroups::getProcessCgroup(
+                  path, root_.string(), proc_cgroup.string())
+                  .ok());
+  EXPECT_EQ((root_ / "system.slice" / "osqueryd.service").string(), path);
+
+  // The root cgroup is never delegated.
+  writeTextFile(proc_cgroup, "0::/\n");
+  EXPECT_FALSE(WatcherCgroups::getProcessCgroup(
+                   path, root_.string(), proc_cgroup.string())
+                   .ok());
+
+  // A cgroup v1 only system has no unified hierarchy entry.
+  writeTextFile(proc_cgroup, "4:memory:/system.slice\n3:cpu:/system.slice\n");
+  EXPECT_FALSE(WatcherCgroups::getProcessCgroup(
+                   path, root_.string(), proc_cgroup.string())
+                   .ok());
+}
+
+TEST_F(WatcherCgroupsTests, test_set_up) {
+  createCgroup(root_);
+  createCgroup(root_ / "watcher");
+
+  WatcherCgroups cgroups(root_.string());
+  ASSERT_TRUE(cgroups.setUp().ok());
+  EXPECT_EQ(std::to_string(getpid()), read(root_ / "watcher/cgroup.procs"));
+  EXPECT_EQ("+cpu +memory", read(root_ / "cgroup.subtree_control"));
+}
+
+TEST_F(WatcherCgroupsTests, test_attach) {
+  createCgroup(root_ / "worker");
+  createCgroup(root_ / "extension.example");
+
+  WatcherCgroups cgroups(root_.string());
+  CgroupLimits limits;
+  limits.cpu_percent = 10;
+  limits.memory_high = 200 * 1024 * 1024;
+  limits.memory_max = 400 * 1024 * 1024;
+  ASSERT_TRUE(cgroups.attach("worker", 1234, limits).ok());
+
+  auto cpus = std::max(std::thread::hardware_concurrency(), 1U);
+  EXPECT_EQ(std::to_string(10000 * cpus) + " 100000",
+            read(root_ / "worker/cpu.max"));
+  EXPECT_EQ("209715200", read(root_ / "worker/memory.high"));
+  EXPECT_EQ("419430400", read(root_ / "worker/memory.max"));
+  EXPECT_EQ("1234", read(root_ / "worker/cgroup.procs"));
+
+  // Missing limits are written as unlimited.
+  ASSERT_TRUE(cgroups.attach("extension.example", 5678, CgroupLimits()).ok());
+  EXPECT_EQ("max 100000", read(root_ / "extension.example/cpu.max"));
+  EXPECT_EQ("max", read(root_ / "extension.example/memory.high"));
+  EXPECT_EQ("max", read(root_ / "extension.example/memory.max"));
+
+  // Without the interface files the leaf is not a cgroup.
+  EXPECT_FALSE(cgroups.attach("missing", 1234, limits).ok());
+}
+
+TEST_F(WatcherCgroupsTests, test_get_stats) {
+  createCgroup(root_ / "worker");
+  writeTextFile(root_ / "worker/memory.pressure",
+                "some avg10=42.50 avg60=10.00 avg300=1.00 total=123456\n"
+                "full avg10=12.00 avg60=2.00 avg300=0.00 total=23456\n");
+  writeTextFile(root_ / "worker/memory.events",
+                "low 0\nhigh 17\nmax 2\noom 1\noom_kill 1\n");
+  writeTextFile(root_ / "worker/cpu.stat",
+                "usage_usec 1000\nnr_periods 50\nnr_throttled 12\n");
+
+  WatcherCgroups cgroups(root_.string());
+  CgroupStats stats;
+  ASSERT_TRUE(cgroups.getStats("worker", stats).ok());
+  EXPECT_DOUBLE_EQ(42.5, stats.memory_pressure);
+  EXPECT_EQ(17U, stats.memory_high_events);
+  EXPECT_EQ(1U, stats.oom_kills);
+  EXPECT_EQ(12U, stats.cpu_throttled);
+
+  EXPECT_FALSE(cgroups.getStats("missing", stats).ok());
+}
+
+TEST_F(WatcherCgroupsTests, test_parsers) {
+  EXPECT_DOUBLE_EQ(0, WatcherCgroups::parsePressure(""));
+  EXPECT_DOUBLE_EQ(
+      1.25,
+      WatcherCgroups::parsePressure("some avg10=1.25 avg60=0.00 total=1"));
+
+  auto values = WatcherCgroups::parseKeyedFile("high 3\ninvalid\nmax 4\n");
+  EXPECT_EQ(2U, values.size());
+  EXPECT_EQ(3U, values["high"]);
+  EXPECT_EQ(4U, values["max"]);
+
+  EXPECT_EQ("extension.example.ext",
+            WatcherCgroups::getLeafName("/usr/lib/osquery/example.ext"));
+  EXPECT_EQ("extension.my_ext", WatcherCgroups::getLeafName("my ext"));
+}
+
+TEST_F(WatcherCgroupsTests, test_wait) {
+  createCgroup(root_ / "worker");
+
+  WatcherCgroups cgroups(root_.string());
+  ASSERT_TRUE(cgroups.attach("worker", 1234, CgroupLimits()).ok());
+
+  // Plain files never report a priority event, the wait times out.
+  EXPECT_FALSE(
+      cgroups.wait(std::chrono::milliseconds(150), []() { return false; }));
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(
+      cgroups.wait(std::chrono::seconds(10), []() { return true; }));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+  // A removed leaf is no longer watched.
+  cgroups.remove("worker");
+  EXPECT_TRUE(fs::exists(root_ / "worker"));
+}
+
+} // namespace osquery
@@ -24,6 +24,9 @@
 #include <osquery/core/shutdown.h>
 #include <osquery/core/sql/query_data.h>
 #include <osquery/core/watcher.h>
+#ifdef __linux__
+#include <osquery/core/linux/watcher_cgroups.h>
+#endif
 #include <osquery/extensions/extensions.h>
 #include <osquery/filesystem/fileops.h>
 #include <osquery/filesystem/filesystem.h>
@@ -143,6 +146,17 @@ CLI_FLAG(bool,
          false,
          "Enable logging of CPU and memory footprint of watched processes");
 
+CLI_FLAG(bool,
+         enable_watchdog_cgroups,
+         false,
+         "Enforce watchdog limits with cgroup v2 controllers (Linux)");
+
+CLI_FLAG(uint64,
+         watchdog_cgroups_pressure_limit,
+         60,
+         "Percent of memory stall time a cgroup-managed process may sustain "
+         "(0 to disable)");
+
 DECLARE_uint64(alarm_timeout);
 
 UNSIGNED_BIGINT_LITERAL PerformanceChange::cpuUtilizationTimeLimit() {
@@ -163,6 +177,8 @@ void Watcher::resetWorkerCounters(uint64_t respawn_time) {
   state_.user_time = 0;
   state_.system_time = 0;
   state_.last_respawn_time = respawn_time;
+  state_.cgroup.clear();
+  state_.pressure_start_time = 0;
 }
 
 void Watcher::resetExtensionCounters(const std::string& extension,
@@ -172,6 +188,8 @@ void Watcher::resetExtensionCounters(const std::string& extension,
   state.user_time = 0;
   state.system_time = 0;
   state.last_respawn_time = respawn_time;
+  state.cgroup.clear();
+  state.pressure_start_time = 0;
 }
 
 std::string Watcher::getExtensionPath(const PlatformProcess& child) {
@@ -272,6 +290,8 @@ void WatcherRunner::start() {
   watcher_->resetWorkerCounters(0);
   PerformanceState watcher_state;
 
+  setUpCgroups();
+
   // Enter the watch loop.
   do {
     if (use_worker_ && !watch(watcher_->getWorker())) {
@@ -320,10 +340,93 @@ void WatcherRunner::start() {
       // A test harness can end the thread immediately.
       break;
     }
-    pause(std::chrono::seconds(getWorkerLimit(WatchdogLimitType::INTERVAL)));
+    waitInterval();
   } while (!interrupted() && ok());
 }
 
+void WatcherRunner::setUpCgroups() {
+  if (!FLAGS_enable_watchdog_cgroups) {
+    return;
+  }
+
+#ifdef __linux__
+  std::string root;
+  auto status = WatcherCgroups::getProcessCgroup(root);
+  if (status.ok()) {
+    auto cgroups = std::make_shared<WatcherCgroups>(root);
+    status = cgroups->setUp();
+    if (status.ok()) {
+      VLOG(1) << "osqueryd watcher enforcing limits with cgroups in " << root;
+      cgroups_ = cgroups;
+      return;
+    }
+  }
+
+  LOG(WARNING) << "Cannot enforce watchdog limits with cgroups, polling "
+                  "process limits instead: "
+               << status.getMessage();
+#else
+  LOG(WARNING) << "Watchdog cgroups are only supported on Linux";
+#endif
+}
+
+void WatcherRunner::attachCgroup(const PlatformProcess& child,
+                                 const std::string& extension,
+                                 PerformanceState& state) {
+#ifdef __linux__
+  if (cgroups_ == nullptr) {
+    return;
+  }
+
+  auto name =
+      extension.empty() ? "worker" : WatcherCgroups::getLeafName(extension);
+
+  // The kernel throttles CPU and reclaims memory at the limits, the hard
+  // memory limit leaves room for reclaim before the OOM killer is involved.
+  CgroupLimits limits;
+  limits.cpu_percent = getWorkerLimit(WatchdogLimitType::UTILIZATION_LIMIT);
+  limits.memory_high =
+      getWorkerLimit(WatchdogLimitType::MEMORY_LIMIT) * 1024 * 1024;
+  limits.memory_max = limits.memory_high * 2;
+
+  auto status = cgroups_->attach(name, child.pid(), limits);
+  if (!status.ok()) {
+    LOG(WARNING) << "Cannot place process (" << child.pid() << ") in cgroup "
+                 << name << ", polling its limits instead: "
+                 << status.getMessage();
+    return;
+  }
+
+  // A leaf is reused across respawns, only report later OOM kills.
+  CgroupStats stats;
+  cgroups_->getStats(name, stats);
+  state.oom_kills = stats.oom_kills;
+  state.cgroup = name;
+#endif
+}
+
+void WatcherRunner::waitInterval() {
+  auto interval =
+      std::chrono::seconds(getWorkerLimit(WatchdogLimitType::INTERVAL));
+
+#ifdef __linux__
+  if (cgroups_ != nullptr) {
+    auto start = std::chrono::steady_clock::now();
+    if (cgroups_->wait(interval, [this]() { return interrupted(); })) {
+      // Check at most once a second while memory events keep arriving.
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      if (elapsed < std::chrono::seconds(1)) {
+        pause(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::seconds(1) - elapsed));
+      }
+    }
+    return;
+  }
+#endif
+
+  pause(interval);
+}
+
 void WatcherRunner::stop() {
   std::unique_lock<std::mutex> lock(watcher_->new_processes_mutex_);
 
@@ -609,11 +712,8 @@ Status WatcherRunner::isChildSane(const PlatformProcess& child) const {
     return Status(1, "Cannot find process");
   }
 
-  PerformanceChange change;
-  {
-    auto& state = watcher_->getState(child);
-    change = getChange(child.pid(), rows[0], state);
-  }
+  auto& state = watcher_->getState(child);
+  auto change = getChange(child.pid(), rows[0], state);
 
   // Only make a decision about the child sanity if it is still the watcher's
   // child. It's possible for the child to die, and its pid reused.
@@ -624,6 +724,14 @@ Status WatcherRunner::isChildSane(const PlatformProcess& child) const {
     return Status(0);
   }
 
+  if (!state.cgroup.empty()) {
+    // The kernel enforces the CPU and memory limits of a cgroup-managed child.
+    auto status = isCgroupSane(child, state);
+    if (!status.ok() || !state.cgroup.empty()) {
+      return status;
+    }
+  }
+
   if (exceededCyclesLimit(change)) {
     return Status(
         1,
@@ -647,6 +755,62 @@ Status WatcherRunner::isChildSane(const PlatformProcess& child) const {
   return Status(0);
 }
 
+Status WatcherRunner::isCgroupSane(const PlatformProcess& child,
+                                   PerformanceState& state) const {
+#ifdef __linux__
+  CgroupStats stats;
+  auto status = (cgroups_ != nullptr)
+                    ? cgroups_->getStats(state.cgroup, stats)
+                    : Status(1, "Watchdog cgroups are not enabled");
+  if (!status.ok()) {
+    VLOG(1) << "Cannot read cgroup " << state.cgroup
+            << ", polling process limits instead: " << status.getMessage();
+    state.cgroup.clear();
+    return Status(0);
+  }
+
+  if (stats.oom_kills > state.oom_kills) {
+    LOG(WARNING) << "osquery child (" << child.pid() << ") cgroup "
+                 << state.cgroup << " hit its memory limit, "
+                 << (stats.oom_kills - state.oom_kills)
+                 << " process(es) were OOM killed";
+    state.oom_kills = stats.oom_kills;
+  }
+
+  if (FLAGS_enable_watchdog_debug) {
+    VLOG(1) << "pid: " << child.pid() << ", memory pressure: " << std::fixed
+            << std::setprecision(2) << stats.memory_pressure << "%/"
+            << FLAGS_watchdog_cgroups_pressure_limit
+            << "%, memory.high events: " << stats.memory_high_events
+            << ", cpu throttled periods: " << stats.cpu_throttled;
+  }
+
+  if (FLAGS_watchdog_cgroups_pressure_limit == 0 ||
+      stats.memory_pressure < FLAGS_watchdog_cgroups_pressure_limit) {
+    state.pressure_start_time = 0;
+    return Status(0);
+  }
+
+  // Throttling is preferred, restart only when reclaim cannot keep up.
+  auto now = getUnixTime();
+  if (state.pressure_start_time == 0) {
+    state.pressure_start_time = now;
+  }
+
+  auto sustained = now - state.pressure_start_time;
+  if (sustained >= getWorkerLimit(WatchdogLimitType::LATENCY_LIMIT)) {
+    return Status(1,
+                  "Memory pressure limit " +
+                      std::to_string(FLAGS_watchdog_cgroups_pressure_limit) +
+                      "% exceeded for " + std::to_string(sustained) +
+                      " seconds");
+  }
+#else
+  state.cgroup.clear();
+#endif
+  return Status(0);
+}
+
 void WatcherRunner::createWorker() {
   std::unique_lock<std::mutex> lock(watcher_->new_processes_mutex_);
 
@@ -717,6 +881,7 @@ void WatcherRunner::createWorker() {
 
   watcher_->setWorker(worker);
   watcher_->resetWorkerCounters(getUnixTime());
+  attachCgroup(*worker, "", watcher_->getState(*worker));
   VLOG(1) << "osqueryd watcher (" << PlatformProcess::getCurrentPid()
           << ") executing worker (" << worker->pid() << ")";
   watcher_->worker_status_ = -1;
@@ -769,6 +934,9 @@ void WatcherRunner::createExtension(const std::string& extension) {
 
   watcher_->setExtension(extension, ext_process);
   watcher_->resetExtensionCounters(extension, getUnixTime());
+  if (ext_process != nullptr && FLAGS_enable_extensions_watchdog) {
+    attachCgroup(*ext_process, extension, watcher_->getState(extension));
+  }
   VLOG(1) << "Created and monitoring extension child (" << ext_process->pid()
           << "): " << extension;
 }
@@ -33,6 +33,7 @@ DECLARE_bool(disable_watchdog);
 DECLARE_int32(watchdog_level);
 
 class WatcherRunner;
+class WatcherCgroups;
 
 /**
  * @brief Categories of process performance limitations.
@@ -70,12 +71,21 @@ struct PerformanceState {
   /// The initial (or as close as possible) process image footprint.
   uint64_t initial_footprint;
 
+  /// The cgroup leaf enforcing the process limits, empty if none.
+  std::string cgroup;
+  /// A timestamp when the cgroup's memory pressure went over the limit.
+  uint64_t pressure_start_time;
+  /// The last checked number of OOM kills within the cgroup.
+  uint64_t oom_kills;
+
   PerformanceState() {
     sustained_latency = 0;
     user_time = 0;
     system_time = 0;
     last_respawn_time = 0;
     initial_footprint = 0;
+    pressure_start_time = 0;
+    oom_kills = 0;
   }
 };
 
@@ -265,6 +275,10 @@ class WatcherRunner : public InternalRunnable {
   /// Inspect into the memory, CPU, and other worker/extension process states.
   virtual Status isChildSane(const PlatformProcess& child) const;
 
+  /// Inspect the memory pressure of a child placed in a cgroup.
+  Status isCgroupSane(const PlatformProcess& child,
+                      PerformanceState& state) const;
+
   /// Inspect into the memory and CPU of the watcher process.
   virtual Status isWatcherHealthy(const PlatformProcess& watcher,
                                   PerformanceState& watcher_state) const;
@@ -293,6 +307,17 @@ class WatcherRunner : public InternalRunnable {
   /// Return the time the watchdog is delayed until (from start of watcher).
   uint64_t delayedTime() const;
 
+  /// Move the watcher into a cgroup v2 subtree, if requested and supported.
+  void setUpCgroups();
+
+  /// Place a new worker, or the extension at a path, in its own cgroup leaf.
+  void attachCgroup(const PlatformProcess& child,
+                    const std::string& extension,
+                    PerformanceState& state);
+
+  /// Sleep for the check interval, waking early on cgroup memory events.
+  void waitInterval();
+
  private:
   /// For testing only, ask the WatcherRunner to run a start loop once.
   void runOnce() {
@@ -318,6 +343,9 @@ class WatcherRunner : public InternalRunnable {
   /// Watcher instance.
   std::shared_ptr<Watcher> watcher_{nullptr};
 
+  /// cgroup v2 subtrees enforcing limits, if enabled and available.
+  std::shared_ptr<WatcherCgroups> cgroups_{nullptr};
+
  private:
   FRIEND_TEST(WatcherTests, test_watcherrunner_watch);
   FRIEND_TEST(WatcherTests, test_watcherrunner_stop);
@@ -122,6 +122,10 @@ Status DatabasePlugin::scan(const std::string& domain,
   return Status::success();
 }
 
+Status DatabasePlugin::stats(PluginResponse& response) const {
+  return Status::failure("Database plugin does not report statistics");
+}
+
 Status DatabasePlugin::call(const PluginRequest& request,
                             PluginResponse& response) {
   if (request.count("action") == 0) {
@@ -213,6 +217,8 @@ Status DatabasePlugin::call(const PluginRequest& request,
       response.push_back({{"k", k}});
     }
     return status;
+  } else if (request.at("action") == "stats") {
+    return this->stats(response);
   }
 
   return Status(1, "Unknown database plugin action");
@@ -446,6 +452,23 @@ Status scanDatabaseKeys(const std::string& domain,
   }
 }
 
+Status getDatabaseStats(PluginResponse& stats) {
+  if (RegistryFactory::get().external()) {
+    return Registry::call("database", {{"action", "stats"}}, stats);
+  }
+
+  ReadLock lock(kDatabaseReset);
+  if (!kDBInitialized) {
+    return Status::failure("Database is not initialized");
+  }
+
+  auto plugin = getDatabasePlugin();
+  if (plugin == nullptr) {
+    return Status::failure("No active database plugin");
+  }
+  return plugin->stats(stats);
+}
+
 void resetDatabase() {
   PluginRequest request = {{"action", "reset"}};
   Registry::call("database", request);
@@ -148,6 +148,16 @@ class DatabasePlugin : public Plugin {
                       const std::string& prefix,
                       uint64_t max) const;
 
+  /**
+   * @brief Report backing-store statistics, one row per domain.
+   *
+   * Plugins without meaningful storage statistics do not implement this.
+   *
+   * @param response Output rows, each must include a "domain" key.
+   * @return Failure if the plugin does not support statistics.
+   */
+  virtual Status stats(PluginResponse& response) const;
+
   /**
    * @brief Shutdown the database and release initialization resources.
    *
@@ -248,6 +258,9 @@ Status scanDatabaseKeys(const std::string& domain,
                         const std::string& prefix,
                         uint64_t max = 0);
 
+/// Get per-domain statistics from the active database plugin.
+Status getDatabaseStats(PluginResponse& stats);
+
 /// Allow callers to reload or reset the database plugin.
 void resetDatabase();
 
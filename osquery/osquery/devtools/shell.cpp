@@ -41,6 +41,7 @@
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/process/process.h>
 #include <osquery/registry/registry_factory.h>
+#include <osquery/sql/query_profile.h>
 #include <osquery/sql/virtual_table.h>
 #include <osquery/utils/chars.h>
 #include <osquery/utils/conversions/join.h>
@@ -106,6 +107,7 @@ static char zHelp[] =
     "                   pretty   Pretty printed SQL results (default)\n"
     ".nullvalue STR   Use STRING in place of NULL values\n"
     ".print STR...    Print literal STRING\n"
+    ".profile ON|OFF  Show the table and SQLite costs of each query\n"
     ".quit            Exit this program\n"
     ".schema [TABLE]  Show the CREATE statements\n"
     ".separator STR   Change separator used by output mode\n"
@@ -237,6 +239,32 @@ static void endTimer() {
 #define END_TIMER endTimer()
 #define HAS_TIMER 1
 
+// True if query profiling is enabled
+static bool enableProfile = false;
+
+// Print the costs collected while executing a query.
+static void printProfile(const osquery::QueryProfile& profile) {
+  printf(
+      "Profile: real %.3f statements %llu vm_steps %llu fullscan_steps %llu "
+      "sorts %llu autoindex_rows %llu memory_peak %llu\n",
+      profile.micros / 1000000.0,
+      static_cast<unsigned long long>(profile.statements),
+      static_cast<unsigned long long>(profile.vm_steps),
+      static_cast<unsigned long long>(profile.fullscan_steps),
+      static_cast<unsigned long long>(profile.sorts),
+      static_cast<unsigned long long>(profile.autoindex_rows),
+      static_cast<unsigned long long>(profile.memory_peak));
+  for (const auto& table : profile.tables) {
+    printf("  %s: filters %llu generate %.3f rows produced %llu "
+           "consumed %llu\n",
+           table.first.c_str(),
+           static_cast<unsigned long long>(table.second.filters),
+           table.second.generate_micros / 1000000.0,
+           static_cast<unsigned long long>(table.second.rows_produced),
+           static_cast<unsigned long long>(table.second.rows_consumed));
+  }
+}
+
 // If the following flag is set, then command execution stops
 // at an error if we are not interactive.
 static int bail_on_error = 0;
@@ -1007,6 +1035,7 @@ static int shell_exec(
       /* Finalize the statement just executed. If this fails, save a
       ** copy of the error message. Otherwise, set zSql to point to the
       ** next statement to execute. */
+      osquery::ScopedQueryProfile::recordStatement(pStmt);
       rc2 = sqlite3_finalize(pStmt);
       if (rc != SQLITE_NOMEM) {
         rc = rc2;
@@ -1501,6 +1530,9 @@ static int do_meta_command(char* zLine, struct callback_data* p) {
       fprintf(p->out, "%s", azArg[j]);
     }
     fprintf(p->out, "\n");
+  } else if (c == 'p' && n >= 3 && strncmp(azArg[0], "profile", n) == 0 &&
+             nArg == 2) {
+    enableProfile = booleanValue(azArg[1]) != 0;
   } else if (c == 'q' && strncmp(azArg[0], "quit", n) == 0 && nArg == 1) {
     rc = 2;
   } else if (c == 's' && strncmp(azArg[0], "schema", n) == 0 && nArg < 3) {
@@ -1711,7 +1743,16 @@ static int process_input(struct callback_data* p, FILE* in) {
       } else {
         p->cnt = 0;
         BEGIN_TIMER;
-        rc = shell_exec(zSql, shell_callback, p, &zErrMsg);
+        if (enableProfile && osquery::FLAGS_connect.empty()) {
+          osquery::QueryProfile profile;
+          {
+            osquery::ScopedQueryProfile scope(profile);
+            rc = shell_exec(zSql, shell_callback, p, &zErrMsg);
+          }
+          printProfile(profile);
+        } else {
+          rc = shell_exec(zSql, shell_callback, p, &zErrMsg);
+        }
         END_TIMER;
         if ((rc != 0) || zErrMsg != nullptr) {
           char zPrefix[100] = {0};
@@ -26,6 +26,7 @@
 #include <osquery/numeric_monitoring/numeric_monitoring.h>
 #include <osquery/process/process.h>
 #include <osquery/profiler/code_profiler.h>
+#include <osquery/sql/query_profile.h>
 #include <osquery/sql/sqlite_util.h>
 #include <osquery/utils/expected/expected.h>
 #include <osquery/utils/system/time.h>
@@ -53,6 +54,11 @@ FLAG(bool,
      false,
      "Log the running scheduled query name at INFO level");
 
+FLAG(bool,
+     schedule_profile,
+     false,
+     "Profile scheduled queries for the osquery_query_profile table");
+
 HIDDEN_FLAG(bool,
             schedule_reload_sql,
             false,
@@ -63,6 +69,21 @@ DECLARE_bool(events_optimize);
 DECLARE_bool(enable_numeric_monitoring);
 DECLARE_bool(verbose);
 
+/// Run a scheduled query, recording its profile if profiling is enabled.
+SQLInternal runQuery(const std::string& name, const ScheduledQuery& query) {
+  if (!FLAGS_schedule_profile) {
+    return SQLInternal(query.query, true);
+  }
+
+  QueryProfile profile;
+  auto sql = [&query, &profile]() {
+    ScopedQueryProfile scope(profile);
+    return SQLInternal(query.query, true);
+  }();
+  QueryProfiles::get().record(name, std::move(profile), getUnixTime());
+  return sql;
+}
+
 SQLInternal monitor(const std::string& name, const ScheduledQuery& query) {
   if (FLAGS_enable_numeric_monitoring) {
     CodeProfiler profiler(
@@ -78,7 +99,7 @@ SQLInternal monitor(const std::string& name, const ScheduledQuery& query) {
           monitoring::hostIdentifierKeys().scheme % query.pack_name %
           query.name)
              .str()});
-    return SQLInternal(query.query, true);
+    return runQuery(name, query);
   } else {
     // Snapshot the performance and times for the worker before running.
     auto pid = std::to_string(PlatformProcess::getCurrentPid());
@@ -91,7 +112,7 @@ SQLInternal monitor(const std::string& name, const ScheduledQuery& query) {
     using namespace std::chrono;
     auto t0 = steady_clock::now();
     Config::get().recordQueryStart(name);
-    SQLInternal sql(query.query, true);
+    auto sql = runQuery(name, query);
 
     // Snapshot the performance after, and compare.
     auto t1 = steady_clock::now();
@@ -7,7 +7,10 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <algorithm>
+#include <atomic>
 #include <sstream>
+#include <thread>
 #include <utility>
 
 #include <osquery/core/flags.h>
@@ -48,9 +51,20 @@ FLAG(uint64,
      86400,
      "Seconds to denylist distributed queries (default 1 day)");
 
+FLAG(uint32,
+     distributed_concurrency,
+     1,
+     "Number of distributed queries to execute concurrently (default 1)");
+
+FLAG(uint64,
+     distributed_flush_rows,
+     0,
+     "Flush distributed results early once this many rows are buffered "
+     "(default 0, flush after all queries ran)");
+
 DECLARE_bool(verbose);
 
-std::string Distributed::currentRequestId_{""};
+thread_local std::string Distributed::currentRequestId_{""};
 
 Status DistributedPlugin::call(const PluginRequest& request,
                                PluginResponse& response) {
@@ -101,16 +115,24 @@ std::vector<std::string> Distributed::getPendingQueries() {
 }
 
 size_t Distributed::getCompletedCount() {
+  std::lock_guard<std::mutex> lock(results_mutex_);
   return results_.size();
 }
 
 Status Distributed::serializeResults(std::string& json) {
+  return serializeResults(results_, performance_, json);
+}
+
+Status Distributed::serializeResults(
+    const std::vector<DistributedQueryResult>& results,
+    const std::map<std::string, QueryPerformance>& performance,
+    std::string& json) {
   auto doc = JSON::newObject();
   auto queries_obj = doc.getObject();
   auto statuses_obj = doc.getObject();
   auto messages_obj = doc.getObject();
   auto stats_obj = doc.getObject();
-  for (const auto& result : results_) {
+  for (const auto& result : results) {
     auto arr = doc.getArray();
     auto s = serializeQueryData(result.results, result.columns, doc, arr);
     if (!s.ok()) {
@@ -121,8 +143,9 @@ Status Distributed::serializeResults(std::string& json) {
     doc.add(result.request.id, result.message, messages_obj);
 
     auto obj = doc.getObject();
-    if (performance_.count(result.request.id) > 0) {
-      auto perf = performance_[result.request.id];
+    auto perf_it = performance.find(result.request.id);
+    if (perf_it != performance.end()) {
+      const auto& perf = perf_it->second;
       obj.AddMember("wall_time_ms",
                     static_cast<uint64_t>(perf.wall_time_ms),
                     obj.GetAllocator());
@@ -148,27 +171,67 @@ Status Distributed::serializeResults(std::string& json) {
 }
 
 void Distributed::addResult(const DistributedQueryResult& result) {
+  buffered_rows_ += result.results.size();
   results_.push_back(result);
 }
 
 Status Distributed::runQueries() {
-  auto queries = getPendingQueries();
-
-  for (const auto& query : queries) {
+  // Requests with identical SQL text within a batch are only executed once.
+  std::map<std::string, std::vector<DistributedQueryRequest>> groups;
+  for (const auto& query : getPendingQueries()) {
     auto request = popRequest(query);
+    groups[request.query].push_back(std::move(request));
+  }
 
-    const auto denylisted = checkAndSetAsRunning(request.query);
-    if (denylisted) {
-      VLOG(1) << "Not executing distributed denylisted query: \""
-              << request.query << "\"";
-      DistributedQueryResult result;
-      result.request = request;
-      result.status = Status(1, "Denylisted");
-      result.message = "distributed query is denylisted";
-      addResult(result);
-      continue;
+  std::vector<const std::vector<DistributedQueryRequest>*> work;
+  work.reserve(groups.size());
+  for (const auto& group : groups) {
+    work.push_back(&group.second);
+  }
+
+  size_t workers = std::min<size_t>(
+      std::max<size_t>(FLAGS_distributed_concurrency, 1), work.size());
+  if (workers <= 1) {
+    for (const auto* requests : work) {
+      runQueryGroup(*requests, false);
     }
+  } else {
+    std::atomic<size_t> next{0};
+    auto worker = [this, &work, &next]() {
+      for (auto i = next++; i < work.size(); i = next++) {
+        runQueryGroup(*work[i], true);
+      }
+    };
 
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+      threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  return flushCompleted();
+}
+
+void Distributed::runQueryGroup(
+    const std::vector<DistributedQueryRequest>& requests, bool concurrent) {
+  const auto& request = requests.front();
+
+  std::vector<DistributedQueryResult> results;
+  const auto denylisted = checkAndSetAsRunning(request.query);
+  if (denylisted) {
+    VLOG(1) << "Not executing distributed denylisted query: \""
+            << request.query << "\"";
+    for (const auto& r : requests) {
+      results.emplace_back(r,
+                           QueryData{},
+                           ColumnNames{},
+                           Status(1, "Denylisted"),
+                           "distributed query is denylisted");
+    }
+  } else {
     if (FLAGS_verbose) {
       VLOG(1) << "Executing distributed query: " << request.id << ": "
               << request.query;
@@ -177,10 +240,10 @@ Status Distributed::runQueries() {
                 << request.query;
     }
 
-    // Keep track of the currently executing request
+    // Keep track of the request executing on this worker thread.
     Distributed::setCurrentRequestId(request.id);
 
-    auto sql = monitorNonnumeric(request.id, request.query);
+    auto sql = monitorNonnumeric(request.id, request.query, !concurrent);
     const auto ok = sql.getStatus().ok();
     const auto& msg = ok ? "" : sql.getMessageString();
     if (!ok) {
@@ -190,11 +253,35 @@ Status Distributed::runQueries() {
 
     setAsNotRunning(request.query);
 
-    DistributedQueryResult result(
-        request, sql.rows(), sql.columns(), sql.getStatus(), msg);
-    addResult(result);
+    for (const auto& r : requests) {
+      results.emplace_back(r, sql.rows(), sql.columns(), sql.getStatus(), msg);
+    }
+  }
+
+  bool flush = false;
+  {
+    std::lock_guard<std::mutex> lock(results_mutex_);
+    auto perf = performance_.find(request.id);
+    for (auto& result : results) {
+      if (perf != performance_.end() && result.request.id != request.id) {
+        performance_[result.request.id] = perf->second;
+      }
+      addResult(result);
+    }
+
+    // Stream large batches back to the server instead of buffering them all.
+    flush = FLAGS_distributed_flush_rows > 0 &&
+            buffered_rows_ >= FLAGS_distributed_flush_rows;
+  }
+
+  // The write is a network request, other workers keep queueing results.
+  if (flush) {
+    auto s = flushCompleted();
+    if (!s.ok()) {
+      LOG(ERROR) << "Error flushing distributed query results: "
+                 << s.getMessage();
+    }
   }
-  return flushCompleted();
 }
 
 bool Distributed::checkAndSetAsRunning(const std::string& query) {
@@ -253,6 +340,8 @@ Status Distributed::cleanupExpiredRunningQueries() {
 }
 
 Status Distributed::flushCompleted() {
+  // Writes are serialized so results reach the server in completion order.
+  std::lock_guard<std::mutex> flush_lock(flush_mutex_);
   if (getCompletedCount() == 0) {
     return Status::success();
   }
@@ -262,19 +351,43 @@ Status Distributed::flushCompleted() {
     return Status(1, "Missing distributed plugin " + distributed_plugin);
   }
 
-  std::string results;
-  auto s = serializeResults(results);
-  if (!s.ok()) {
-    return s;
+  // Take the completed results, workers may queue more during the write.
+  std::vector<DistributedQueryResult> results;
+  std::map<std::string, QueryPerformance> performance;
+  size_t rows = 0;
+  {
+    std::lock_guard<std::mutex> lock(results_mutex_);
+    results.swap(results_);
+    std::swap(rows, buffered_rows_);
+
+    // Statistics of queries still running stay with their future results.
+    for (const auto& result : results) {
+      auto perf = performance_.find(result.request.id);
+      if (perf != performance_.end()) {
+        performance.insert(*perf);
+        performance_.erase(perf);
+      }
+    }
   }
 
-  PluginResponse response;
-  s = Registry::call("distributed",
-                     {{"action", "writeResults"}, {"results", results}},
-                     response);
+  std::string json;
+  auto s = serializeResults(results, performance, json);
   if (s.ok()) {
-    results_.clear();
-    performance_.clear();
+    PluginResponse response;
+    s = Registry::call("distributed",
+                       {{"action", "writeResults"}, {"results", json}},
+                       response);
+  }
+
+  if (!s.ok()) {
+    // Requeue the results ahead of newer ones so the next flush retries them.
+    std::lock_guard<std::mutex> lock(results_mutex_);
+    results_.insert(results_.begin(),
+                    std::make_move_iterator(results.begin()),
+                    std::make_move_iterator(results.end()));
+    performance_.insert(performance.begin(), performance.end());
+    buffered_rows_ += rows;
+    return s;
   }
 
 #ifdef OSQUERY_LINUX
@@ -379,7 +492,24 @@ void Distributed::setCurrentRequestId(const std::string& cReqId) {
 }
 
 SQL Distributed::monitorNonnumeric(const std::string& name,
-                                   const std::string& query) {
+                                   const std::string& query,
+                                   bool process_stats) {
+  using namespace std::chrono;
+  if (!process_stats) {
+    // The process CPU and memory are shared with concurrently running
+    // queries, only the wall time can be attributed to this one.
+    auto t0 = steady_clock::now();
+    SQL sql(query, true);
+
+    QueryPerformance perf;
+    perf.wall_time_ms =
+        duration_cast<milliseconds>(steady_clock::now() - t0).count();
+
+    std::lock_guard<std::mutex> lock(results_mutex_);
+    performance_[name] = perf;
+    return sql;
+  }
+
   // Snapshot the performance and times for the worker before running.
   auto pid = std::to_string(PlatformProcess::getCurrentPid());
   auto r0 = SQL::selectFrom({"resident_size", "user_time", "system_time"},
@@ -388,7 +518,6 @@ SQL Distributed::monitorNonnumeric(const std::string& name,
                             EQUALS,
                             pid);
 
-  using namespace std::chrono;
   auto t0 = steady_clock::now();
   SQL sql(query, true);
 
@@ -413,9 +542,7 @@ void Distributed::recordQueryPerformance(const std::string& name,
                                          uint64_t size,
                                          const Row& r0,
                                          const Row& r1) {
-  performance_[name] = QueryPerformance();
-
-  auto& query = performance_.at(name);
+  QueryPerformance query;
   if (!r1.at("user_time").empty() && !r0.at("user_time").empty()) {
     auto ut1 = tryTo<long long>(r1.at("user_time"));
     auto ut0 = tryTo<long long>(r0.at("user_time"));
@@ -444,6 +571,9 @@ void Distributed::recordQueryPerformance(const std::string& name,
   }
 
   query.wall_time_ms = delay_ms;
+
+  std::lock_guard<std::mutex> lock(results_mutex_);
+  performance_[name] = query;
 }
 
 Status serializeDistributedQueryRequest(const DistributedQueryRequest& r,
@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -260,13 +262,20 @@ class Distributed {
   /// Serialize result data into a JSON string and clear the results
   Status serializeResults(std::string& json);
 
-  /// Process and execute queued queries
+  /**
+   * @brief Process and execute queued queries
+   *
+   * Queued requests that share identical SQL text are executed once and the
+   * results are reported for every request ID. Unique queries are executed
+   * by up to `distributed_concurrency` workers. Completed results are flushed
+   * early, between queries, once `distributed_flush_rows` rows are buffered.
+   */
   Status runQueries();
 
   /// Cleanup distributed queries marked as running that have expired.
   Status cleanupExpiredRunningQueries();
 
-  // Getter for ID of currently executing request
+  // Getter for ID of the request executing on the calling thread
   static std::string getCurrentRequestId();
 
  protected:
@@ -296,6 +305,12 @@ class Distributed {
    */
   DistributedQueryRequest popRequest(std::string query);
 
+  /// Serialize a set of results and their performance statistics.
+  static Status serializeResults(
+      const std::vector<DistributedQueryResult>& results,
+      const std::map<std::string, QueryPerformance>& performance,
+      std::string& json);
+
   /**
    * @brief Queue a result to be batch sent to the server
    *
@@ -303,6 +318,18 @@ class Distributed {
    */
   void addResult(const DistributedQueryResult& result);
 
+  /**
+   * @brief Execute a set of requests sharing the same SQL text
+   *
+   * The query is executed a single time and a result is queued for each of
+   * the requests. This may be called concurrently from several workers.
+   *
+   * @param requests the non-empty set of requests with identical queries
+   * @param concurrent true if other groups may be executing at the same time
+   */
+  void runQueryGroup(const std::vector<DistributedQueryRequest>& requests,
+                     bool concurrent);
+
   /**
    * @brief Checks and sets whether the given query is marked as running.
    *
@@ -340,8 +367,15 @@ class Distributed {
   // Setter for ID of currently executing request
   static void setCurrentRequestId(const std::string& cReqId);
 
-  // Run a query and record its performance statistics
-  SQL monitorNonnumeric(const std::string& name, const std::string& query);
+  /**
+   * @brief Run a query and record its performance statistics
+   *
+   * @param process_stats if false, only the wall time is recorded. Process CPU
+   * and memory deltas are meaningless while other queries run concurrently.
+   */
+  SQL monitorNonnumeric(const std::string& name,
+                        const std::string& query,
+                        bool process_stats = true);
 
   /**
    * @brief Calculate query performance and record it into the performance_
@@ -361,8 +395,17 @@ class Distributed {
 
   std::vector<DistributedQueryResult> results_;
 
-  // ID of the currently executing query
-  static std::string currentRequestId_;
+  /// Number of result rows buffered in results_ since the last flush.
+  size_t buffered_rows_{0};
+
+  /// Protects results_, buffered_rows_ and performance_ during runQueries.
+  std::mutex results_mutex_;
+
+  /// Serializes flushCompleted writes, held without results_mutex_.
+  std::mutex flush_mutex_;
+
+  // ID of the query executing on the calling thread
+  static thread_local std::string currentRequestId_;
 
   // Performance statistics recorded from distributed queries
   std::map<std::string, QueryPerformance> performance_;
@@ -375,5 +418,7 @@ class Distributed {
   FRIEND_TEST(DistributedTests, test_accept_work_basic);
   FRIEND_TEST(DistributedTests, test_accept_work_with_discovery);
   FRIEND_TEST(DistributedTests, test_accept_work_with_discovery_all_fail);
+  FRIEND_TEST(DistributedTests, test_run_queries_deduplicates_queries);
+  FRIEND_TEST(DistributedTests, test_run_queries_concurrently);
 };
 } // namespace osquery
@@ -30,6 +30,7 @@ namespace osquery {
 
 DECLARE_string(distributed_tls_read_endpoint);
 DECLARE_string(distributed_tls_write_endpoint);
+DECLARE_uint32(distributed_concurrency);
 
 class DistributedTests : public testing::Test {
  protected:
@@ -343,6 +344,86 @@ TEST_F(DistributedTests, test_run_queries_with_denylisted_query) {
   ASSERT_TRUE(ts2.empty());
 }
 
+TEST_F(DistributedTests, test_run_queries_deduplicates_queries) {
+  auto dist = DistributedMock();
+  EXPECT_CALL(dist, flushCompleted).Times(1);
+
+  const std::string work = R"json(
+{
+  "queries": {
+    "q1": "SELECT * FROM osquery_info;",
+    "q2": "SELECT * FROM osquery_info;",
+    "q3": "SELECT * FROM time;"
+  }
+}
+)json";
+  auto status = dist.acceptWork(work);
+  ASSERT_TRUE(status.ok()) << status.getMessage();
+  status = dist.runQueries();
+  ASSERT_TRUE(status.ok()) << status.getMessage();
+
+  // The duplicate query is not reported as denylisted, it shares results.
+  ASSERT_EQ(dist.results_.size(), 3);
+  std::map<std::string, const DistributedQueryResult*> by_id;
+  for (const auto& result : dist.results_) {
+    EXPECT_TRUE(result.status.ok()) << result.request.id;
+    EXPECT_FALSE(result.results.empty()) << result.request.id;
+    by_id[result.request.id] = &result;
+  }
+  ASSERT_EQ(by_id.size(), 3);
+  EXPECT_EQ(by_id["q1"]->results, by_id["q2"]->results);
+  EXPECT_EQ(by_id["q1"]->columns, by_id["q2"]->columns);
+
+  // No query remains marked as running.
+  std::vector<std::string> running;
+  scanDatabaseKeys(kDistributedRunningQueries, running);
+  EXPECT_TRUE(running.empty());
+}
+
+TEST_F(DistributedTests, test_run_queries_concurrently) {
+  auto concurrency = FLAGS_distributed_concurrency;
+  FLAGS_distributed_concurrency = 4;
+
+  auto dist = DistributedMock();
+  EXPECT_CALL(dist, flushCompleted).Times(1);
+
+  const std::string work = R"json(
+{
+  "queries": {
+    "q1": "SELECT * FROM osquery_info;",
+    "q2": "SELECT * FROM time;",
+    "q3": "SELECT * FROM system_info;",
+    "q4": "SELECT 1;",
+    "q5": "SELECT * FROM not_a_table;"
+  }
+}
+)json";
+  auto status = dist.acceptWork(work);
+  ASSERT_TRUE(status.ok()) << status.getMessage();
+  status = dist.runQueries();
+  FLAGS_distributed_concurrency = concurrency;
+  ASSERT_TRUE(status.ok()) << status.getMessage();
+
+  ASSERT_EQ(dist.results_.size(), 5);
+  for (const auto& result : dist.results_) {
+    if (result.request.id == "q5") {
+      EXPECT_FALSE(result.status.ok());
+    } else {
+      EXPECT_TRUE(result.status.ok()) << result.request.id;
+      EXPECT_FALSE(result.results.empty()) << result.request.id;
+    }
+  }
+  EXPECT_TRUE(dist.getPendingQueries().empty());
+
+  // Process-wide CPU and memory deltas are not attributed to single queries.
+  ASSERT_EQ(dist.performance_.size(), 5);
+  for (const auto& perf : dist.performance_) {
+    EXPECT_EQ(perf.second.user_time, 0U) << perf.first;
+    EXPECT_EQ(perf.second.system_time, 0U) << perf.first;
+    EXPECT_EQ(perf.second.last_memory, 0U) << perf.first;
+  }
+}
+
 TEST_F(DistributedTests, test_accept_work_basic) {
   auto dist = Distributed();
 
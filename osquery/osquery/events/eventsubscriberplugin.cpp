@@ -12,11 +12,13 @@
 #include <osquery/database/database.h>
 #include <osquery/events/eventfactory.h>
 #include <osquery/events/eventsubscriberplugin.h>
+#include <osquery/experimental/events_stream/events_stream.h>
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry_factory.h>
 #include <osquery/sql/dynamic_table_row.h>
 #include <osquery/utils/conversions/tryto.h>
 #include <osquery/utils/info/tool_type.h>
+#include <osquery/utils/json/json.h>
 #include <osquery/utils/system/time.h>
 
 namespace osquery {
@@ -26,6 +28,45 @@ namespace {
 /// Checkpoint interval to inspect max event buffering.
 const EventContextID kEventsCheckpoint{256U};
 
+/// Accepts the JSON objects deserializeRowJSON accepts, without a DOM.
+class SerializedRowHandler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>,
+                                          SerializedRowHandler> {
+ public:
+  bool Default() {
+    return depth_ > 0;
+  }
+
+  bool StartObject() {
+    ++depth_;
+    return true;
+  }
+
+  bool EndObject(rapidjson::SizeType) {
+    --depth_;
+    return true;
+  }
+
+  bool StartArray() {
+    return depth_++ > 0;
+  }
+
+  bool EndArray(rapidjson::SizeType) {
+    --depth_;
+    return true;
+  }
+
+ private:
+  std::size_t depth_{0U};
+};
+
+bool isSerializedRow(const std::string& serialized_row) {
+  SerializedRowHandler handler;
+  rapidjson::Reader reader;
+  rapidjson::StringStream stream(serialized_row.c_str());
+  return !reader.Parse(stream, handler).IsError();
+}
+
 void removeDeprecatedEventKeysOnceHelper() {
   std::vector<std::string> key_list;
   auto status = scanDatabaseKeys(kEvents, key_list);
@@ -121,6 +162,10 @@ Status EventSubscriberPlugin::addBatch(std::vector<Row>& row_list,
   auto event_time = custom_event_time != 0 ? custom_event_time : getTime();
   auto string_event_time = std::to_string(event_time);
 
+  // Streamed events may skip the database entirely.
+  auto stream = events::isEventsStreamEnabled();
+  auto stream_only = events::isEventsStreamOnly();
+
   for (auto& row : row_list) {
     auto event_identifier = getEventID();
     event_id_list.push_back(event_identifier);
@@ -147,12 +192,26 @@ Status EventSubscriberPlugin::addBatch(std::vector<Row>& row_list,
     // If no active logger is marked 'usesLogEvent' then this is a no-op.
     EventFactory::forwardEvent(serialized_row);
 
+    if (stream) {
+      events::dispatchSerializedEvent("{\"name\":\"" + getName() +
+                                      "\",\"columns\":" + serialized_row +
+                                      "}");
+    }
+
+    if (stream_only) {
+      continue;
+    }
+
     // Store the event data in the batch
     database_data.push_back(
         std::make_pair("data." + dbNamespace() + "." + string_event_identifier,
                        serialized_row));
   }
 
+  if (stream_only) {
+    return Status::success();
+  }
+
   if (database_data.empty()) {
     return Status(1, "Failed to process the rows");
   }
@@ -258,7 +317,8 @@ uint64_t EventSubscriberPlugin::getExpireTime() {
 void EventSubscriberPlugin::generateRows(std::function<void(Row)> callback,
                                          bool can_optimize,
                                          EventTime start_time,
-                                         EventTime stop_time) {
+                                         EventTime stop_time,
+                                         bool decode_rows) {
   EventTime optimize_time{0U};
   EventID optimize_eid{0U};
   if (can_optimize && shouldOptimize()) {
@@ -278,7 +338,8 @@ void EventSubscriberPlugin::generateRows(std::function<void(Row)> callback,
                                callback,
                                start_time,
                                stop_time,
-                               optimize_eid);
+                               optimize_eid,
+                               decode_rows);
 
     if (can_optimize && shouldOptimize() && !result.isEnd) {
       setOptimizeData(getDatabase(), result.last_time, result.last_id);
@@ -294,32 +355,75 @@ void EventSubscriberPlugin::generateRows(std::function<void(Row)> callback,
 void EventSubscriberPlugin::genTable(RowYield& yield, QueryContext& context) {
   // Stop is an unsigned (-1), our end of time equivalent.
   EventTime start = 0, stop = 0;
-  bool can_optimize{true};
-  if (context.constraints["time"].getAll().size() > 0) {
-    can_optimize = false;
-    // Use the 'time' constraint to optimize backing-store lookups.
-    for (const auto& constraint : context.constraints["time"].getAll()) {
-      EventTime expr = timeFromRecord(constraint.expr);
-      if (constraint.op == EQUALS) {
-        stop = start = expr;
-        break;
-      } else if (constraint.op == GREATER_THAN) {
-        start = std::max(start, expr + 1);
-      } else if (constraint.op == GREATER_THAN_OR_EQUALS) {
-        start = std::max(start, expr);
-      } else if (constraint.op == LESS_THAN) {
-        stop = std::min(stop, expr - 1);
-      } else if (constraint.op == LESS_THAN_OR_EQUALS) {
-        stop = std::min(stop, expr);
-      }
-    }
+  if (!getTimeBounds(context, start, stop)) {
+    return;
   }
 
+  // Use the 'time' constraint to optimize backing-store lookups.
+  bool can_optimize = context.constraints["time"].getAll().empty();
+
   auto generateRowsCallback = [&yield](Row row) {
     yield(TableRowHolder(new DynamicTableRow(std::move(row))));
   };
 
-  generateRows(generateRowsCallback, can_optimize, start, stop);
+  generateRows(generateRowsCallback,
+               can_optimize,
+               start,
+               stop,
+               !onlyIndexColumnsUsed(context));
+}
+
+bool EventSubscriberPlugin::getTimeBounds(const QueryContext& context,
+                                          EventTime& start_time,
+                                          EventTime& end_time) {
+  start_time = 0;
+  end_time = 0;
+
+  auto it = context.constraints.find("time");
+  if (it == context.constraints.end()) {
+    return true;
+  }
+
+  // An end time of 0 is unbounded, track an explicit empty range instead.
+  for (const auto& constraint : it->second.getAll()) {
+    EventTime expr = timeFromRecord(constraint.expr);
+    if (constraint.op == EQUALS) {
+      if (expr == 0) {
+        return false;
+      }
+      start_time = end_time = expr;
+      break;
+    } else if (constraint.op == GREATER_THAN) {
+      start_time = std::max(start_time, expr + 1);
+    } else if (constraint.op == GREATER_THAN_OR_EQUALS) {
+      start_time = std::max(start_time, expr);
+    } else if (constraint.op == LESS_THAN) {
+      if (expr <= 1) {
+        return false;
+      }
+      end_time = (end_time == 0) ? expr - 1 : std::min(end_time, expr - 1);
+    } else if (constraint.op == LESS_THAN_OR_EQUALS) {
+      if (expr == 0) {
+        return false;
+      }
+      end_time = (end_time == 0) ? expr : std::min(end_time, expr);
+    }
+  }
+
+  return end_time == 0 || start_time <= end_time;
+}
+
+bool EventSubscriberPlugin::onlyIndexColumnsUsed(const QueryContext& context) {
+  if (!context.colsUsed) {
+    return false;
+  }
+
+  for (const auto& column : *context.colsUsed) {
+    if (column != "time" && column != "eid") {
+      return false;
+    }
+  }
+  return true;
 }
 
 size_t EventSubscriberPlugin::numSubscriptions() const {
@@ -642,9 +746,10 @@ EventSubscriberPlugin::GenerateRowsResult EventSubscriberPlugin::generateRows(
     std::function<void(Row)> callback,
     EventTime start_time,
     EventTime end_time,
-    EventID last_eid) {
+    EventID last_eid,
+    bool decode_rows) {
   EventSubscriberPlugin::GenerateRowsResult ret{true, 0, 0};
-  std::vector<EventID> collected_event_id_list;
+  std::vector<std::pair<EventTime, EventID>> collected_event_id_list;
   {
     ReadLock lock(context.event_index_mutex);
     auto last = context.event_index.end();
@@ -675,7 +780,7 @@ EventSubscriberPlugin::GenerateRowsResult EventSubscriberPlugin::generateRows(
           // A previous optimized query has already visited this event.
           continue;
         }
-        collected_event_id_list.push_back(event_identifier);
+        collected_event_id_list.emplace_back(it->first, event_identifier);
       }
       last = it;
     }
@@ -687,8 +792,8 @@ EventSubscriberPlugin::GenerateRowsResult EventSubscriberPlugin::generateRows(
   }
 
   std::vector<std::string> invalid_key_list;
-  for (const auto& event_identifier : collected_event_id_list) {
-    auto key = databaseKeyForEventId(context, event_identifier);
+  for (const auto& event : collected_event_id_list) {
+    auto key = databaseKeyForEventId(context, event.second);
 
     std::string serialized_row;
     auto status = db_interface.getDatabaseValue(kEvents, key, serialized_row);
@@ -697,6 +802,19 @@ EventSubscriberPlugin::GenerateRowsResult EventSubscriberPlugin::generateRows(
       continue;
     }
 
+    if (!decode_rows) {
+      // The index already knows the time and eid of the event, the stored
+      // row is only checked so that the same events are skipped as below.
+      if (!isSerializedRow(serialized_row)) {
+        invalid_key_list.push_back(key);
+        continue;
+      }
+
+      callback(Row{{"time", std::to_string(event.first)},
+                   {"eid", toIndex(event.second)}});
+      continue;
+    }
+
     Row row = {};
     status = deserializeRowJSON(serialized_row, row);
     if (!status.ok()) {
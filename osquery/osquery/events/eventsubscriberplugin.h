@@ -124,12 +124,14 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
    * @param can_optimize If true then optimization can be considered.
    * @param start_time Inclusive lower bound time limit.
    * @param end_time Inclusive upper bound time limit.
+   * @param decode_rows If false only the time and eid columns are emitted.
    * @return Set of event rows matching time limits.
    */
   void generateRows(std::function<void(Row)> callback,
                     bool can_optimize,
                     EventTime start_time,
-                    EventTime stop_stop);
+                    EventTime stop_stop,
+                    bool decode_rows = true);
 
   /// Track a query execution.
   virtual void setExecutedQuery(const std::string& query_name,
@@ -241,6 +243,9 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
    * @param start_time Inclusive lower bound time limit.
    * @param end_time Inclusive upper bound time limit.
    * @param last_eid (optional) The last visited event id.
+   * @param decode_rows (optional) If false the stored rows are only checked
+   * for validity, not deserialized, and the callback receives rows containing
+   * only the time and eid columns which are known from the in-memory index.
    * @return The upper bound time or 0 if there were no events in the range.
    */
   static GenerateRowsResult generateRows(Context& context,
@@ -248,7 +253,23 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
                                          std::function<void(Row)> callback,
                                          EventTime start_time,
                                          EventTime end_time,
-                                         EventID last_eid = 0);
+                                         EventID last_eid = 0,
+                                         bool decode_rows = true);
+
+  /**
+   * @brief Translate the 'time' constraints of a query into index bounds.
+   *
+   * @param context The query context.
+   * @param start_time Output inclusive lower bound, 0 if unbounded.
+   * @param end_time Output inclusive upper bound, 0 if unbounded.
+   * @return false if the constraints cannot match any event.
+   */
+  static bool getTimeBounds(const QueryContext& context,
+                            EventTime& start_time,
+                            EventTime& end_time);
+
+  /// Check if a query only selects columns that are answered by the index.
+  static bool onlyIndexColumnsUsed(const QueryContext& context);
 
   explicit EventSubscriberPlugin(EventSubscriberPlugin const&) = delete;
   EventSubscriberPlugin& operator=(EventSubscriberPlugin const&) = delete;
@@ -330,6 +351,7 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
 
   friend class EventFactory;
   friend class EventPublisherPlugin;
+  friend class EventTimeline;
 
   FRIEND_TEST(EventsTests, test_event_subscriber_configure);
   FRIEND_TEST(EventsTests, test_event_toggle_subscribers);
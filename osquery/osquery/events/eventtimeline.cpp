@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+
+#include <osquery/events/eventtimeline.h>
+#include <osquery/utils/mutex.h>
+
+namespace osquery {
+
+EventTimeline::EventTimeline(std::vector<Source> sources,
+                             EventTime start_time,
+                             EventTime end_time,
+                             bool read_rows,
+                             std::size_t chunk_size)
+    : start_time_(start_time),
+      read_rows_(read_rows),
+      chunk_size_(std::max<std::size_t>(chunk_size, 1)) {
+  if (end_time != 0 && start_time > end_time) {
+    return;
+  }
+
+  cursors_.reserve(sources.size());
+  for (auto& source : sources) {
+    Cursor cursor;
+    cursor.source = std::move(source);
+
+    // Bound the scan to the events present now, a busy source must not keep
+    // the timeline from ever ending.
+    {
+      auto& context = *cursor.source.context;
+      ReadLock lock(context.event_index_mutex);
+      if (context.event_index.empty()) {
+        cursor.exhausted = true;
+      } else {
+        cursor.stop_time = context.event_index.rbegin()->first;
+      }
+    }
+
+    if (end_time != 0) {
+      cursor.stop_time = std::min(cursor.stop_time, end_time);
+    }
+    cursors_.push_back(std::move(cursor));
+  }
+
+  for (std::size_t i = 0; i < cursors_.size(); ++i) {
+    push(i);
+  }
+}
+
+EventTimeline::Source EventTimeline::getSource(
+    EventSubscriberPlugin& subscriber) {
+  return Source{
+      subscriber.getName(), &subscriber.context, &subscriber.getDatabase()};
+}
+
+bool EventTimeline::fill(Cursor& cursor) {
+  cursor.entries.clear();
+  cursor.position = 0;
+  if (cursor.exhausted) {
+    return false;
+  }
+
+  {
+    auto& context = *cursor.source.context;
+    ReadLock lock(context.event_index_mutex);
+
+    const auto& event_index = context.event_index;
+    auto from = cursor.started ? cursor.time : start_time_;
+    if (from > cursor.stop_time) {
+      cursor.exhausted = true;
+      return false;
+    }
+
+    auto it = event_index.lower_bound(from);
+    auto end = event_index.upper_bound(cursor.stop_time);
+    for (; it != end && cursor.entries.size() < chunk_size_; ++it) {
+      const auto& event_id_list = it->second;
+
+      std::size_t offset = 0;
+      if (cursor.started && it->first == cursor.time) {
+        offset = cursor.offset;
+      }
+
+      cursor.started = true;
+      cursor.time = it->first;
+      for (; offset < event_id_list.size() &&
+             cursor.entries.size() < chunk_size_;
+           ++offset) {
+        cursor.entries.emplace_back(it->first, event_id_list[offset]);
+      }
+      cursor.offset = offset;
+    }
+  }
+
+  if (cursor.entries.empty()) {
+    cursor.exhausted = true;
+    return false;
+  }
+  return true;
+}
+
+void EventTimeline::push(std::size_t cursor_index) {
+  auto& cursor = cursors_[cursor_index];
+  if (cursor.position >= cursor.entries.size() && !fill(cursor)) {
+    return;
+  }
+  heads_.emplace(cursor.entries[cursor.position].first, cursor_index);
+}
+
+bool EventTimeline::next(Event& event) {
+  while (!heads_.empty()) {
+    auto cursor_index = heads_.top().second;
+    heads_.pop();
+
+    auto& cursor = cursors_[cursor_index];
+    auto entry = cursor.entries[cursor.position++];
+    push(cursor_index);
+
+    event.time = entry.first;
+    event.eid = entry.second;
+    event.source = cursor.source.name;
+    event.data.clear();
+    if (!read_rows_) {
+      return true;
+    }
+
+    auto key = EventSubscriberPlugin::databaseKeyForEventId(
+        *cursor.source.context, entry.second);
+    auto status =
+        cursor.source.db_interface->getDatabaseValue(kEvents, key, event.data);
+    if (status.ok() && !event.data.empty()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+} // namespace osquery
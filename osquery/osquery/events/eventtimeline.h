@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <osquery/database/database.h>
+#include <osquery/events/eventsubscriberplugin.h>
+#include <osquery/events/types.h>
+
+namespace osquery {
+
+/**
+ * @brief Merge the stored events of several subscribers in time order.
+ *
+ * Each subscriber keeps its own in-memory time -> eid index. The timeline
+ * walks every index in bounded chunks and performs a k-way merge, so events
+ * are produced one at a time, ordered by time, without materializing and
+ * sorting the union of all subscribers. The stored row of an event is only
+ * read from the backing store once the event is produced.
+ *
+ * Events with the same time are produced in the order of the sources and then
+ * in the order they were recorded. Events recorded at a time later than the
+ * newest event present when the timeline is created are not included.
+ */
+class EventTimeline final {
+ public:
+  /// A subscriber's index and backing store.
+  struct Source final {
+    std::string name;
+    EventSubscriberPlugin::Context* context{nullptr};
+    IDatabaseInterface* db_interface{nullptr};
+  };
+
+  /// A single merged event.
+  struct Event final {
+    EventTime time{0};
+    EventID eid{0};
+
+    /// The name of the source that recorded the event.
+    std::string source;
+
+    /// The stored JSON row, empty if rows are not read.
+    std::string data;
+  };
+
+  /**
+   * @brief Create a timeline over a set of sources.
+   *
+   * @param sources The sources to merge, they must outlive the timeline.
+   * @param start_time Inclusive lower bound time limit, 0 if unbounded.
+   * @param end_time Inclusive upper bound time limit, 0 if unbounded.
+   * @param read_rows If false only the index is used and data stays empty.
+   * @param chunk_size Index entries read from a source per index lock.
+   */
+  EventTimeline(std::vector<Source> sources,
+                EventTime start_time,
+                EventTime end_time,
+                bool read_rows = true,
+                std::size_t chunk_size = 1024);
+
+  /// Describe a subscriber as a timeline source.
+  static Source getSource(EventSubscriberPlugin& subscriber);
+
+  /**
+   * @brief Produce the next event in time order.
+   *
+   * Events whose stored row disappeared, for example because they expired
+   * after their index entry was read, are skipped.
+   *
+   * @return false when every source is exhausted.
+   */
+  bool next(Event& event);
+
+ private:
+  /// A (time, eid) entry of a subscriber index.
+  using IndexEntry = std::pair<EventTime, EventID>;
+
+  struct Cursor final {
+    Source source;
+
+    /// Inclusive upper bound time limit of this source.
+    EventTime stop_time{0};
+
+    /// The current chunk of index entries.
+    std::vector<IndexEntry> entries;
+    std::size_t position{0};
+
+    /**
+     * The index time and the offset within its eid list the next chunk
+     * starts at. Expiration removes whole times and new events are appended,
+     * so an offset stays valid between chunks.
+     */
+    EventTime time{0};
+    std::size_t offset{0};
+    bool started{false};
+    bool exhausted{false};
+  };
+
+  /// Read the next chunk of a cursor's index, returns false when exhausted.
+  bool fill(Cursor& cursor);
+
+  /// Queue the cursor's current entry, refilling the chunk if needed.
+  void push(std::size_t cursor_index);
+
+ private:
+  std::vector<Cursor> cursors_;
+  EventTime start_time_{0};
+  bool read_rows_{true};
+  std::size_t chunk_size_{0};
+
+  /// The current entry of each source, ordered by (time, source index).
+  using Head = std::pair<EventTime, std::size_t>;
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads_;
+};
+
+} // namespace osquery
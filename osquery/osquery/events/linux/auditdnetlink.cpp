@@ -788,7 +788,7 @@ void AuditdNetlinkParser::start() {
         continue;
       }
 
-      audit_event_record_queue.push_back(audit_event_record);
+      audit_event_record_queue.push_back(std::move(audit_event_record));
     }
 
     // Save the new records and notify the reader
@@ -802,8 +802,8 @@ void AuditdNetlinkParser::start() {
 
       auditd_context_->processed_events.insert(
           auditd_context_->processed_events.end(),
-          audit_event_record_queue.begin(),
-          audit_event_record_queue.end());
+          std::make_move_iterator(audit_event_record_queue.begin()),
+          std::make_move_iterator(audit_event_record_queue.end()));
 
       auditd_context_->processed_records_backlog =
           auditd_context_->processed_events.size();
@@ -847,6 +847,58 @@ void AuditdNetlinkParser::start() {
   }
 }
 
+void AuditdNetlinkParser::TokenizeAuditFields(
+    boost::string_ref field_view,
+    std::map<std::string, std::string>& fields) noexcept {
+  // Fields are 'key=value' pairs separated by spaces. A value may contain an
+  // enclosed (quoted) sequence, which may contain spaces, and the quotes are
+  // kept. Each key and value is copied once, directly from the message.
+  auto size = field_view.size();
+  std::size_t i = 0;
+
+  while (i < size) {
+    if (field_view[i] == ' ') {
+      ++i;
+      continue;
+    }
+
+    auto key_begin = i;
+    while (i < size && field_view[i] != '=' && field_view[i] != ' ') {
+      ++i;
+    }
+    auto key = field_view.substr(key_begin, i - key_begin);
+
+    if (i == size || field_view[i] == ' ') {
+      // A key without an assignment.
+      fields.try_emplace(key.to_string());
+      continue;
+    }
+
+    // Skip the assignment.
+    auto value_begin = ++i;
+    while (i < size && field_view[i] != ' ' && field_view[i] != '"') {
+      ++i;
+    }
+
+    if (i < size && field_view[i] == '"') {
+      // The enclosure ends at the next quote, or at the end of the message.
+      ++i;
+      while (i < size && field_view[i] != '"') {
+        ++i;
+      }
+      if (i < size) {
+        ++i;
+      }
+    }
+
+    if (!key.empty()) {
+      fields.try_emplace(key.to_string(),
+                         field_view.data() + value_begin,
+                         i - value_begin);
+    }
+  }
+}
+
 bool AuditdNetlinkParser::ParseAuditReply(
     const audit_reply& reply, AuditEventRecord& event_record) noexcept {
   event_record = {};
@@ -883,62 +935,7 @@ bool AuditdNetlinkParser::ParseAuditReply(
 
   // Tokenize the message
   boost::string_ref field_view(message_view.substr(preamble_end + 3));
-
-  // The linear search will construct series of key value pairs.
-  std::string key, value;
-  key.reserve(20);
-  value.reserve(256);
-
-  // There are several ways of representing value data (enclosed strings,
-  // etc).
-  bool found_assignment{false};
-  bool found_enclose{false};
-
-  for (const auto& c : field_view) {
-    // Iterate over each character in the audit message.
-    if ((found_enclose && c == '"') || (!found_enclose && c == ' ')) {
-      if (c == '"') {
-        value += c;
-      }
-
-      // This is a terminating sequence, the end of an enclosure or space
-      // tok.
-      if (!key.empty()) {
-        // Multiple space tokens are supported.
-        event_record.fields.emplace(
-            std::make_pair(std::move(key), std::move(value)));
-      }
-
-      found_enclose = false;
-      found_assignment = false;
-
-      key.clear();
-      value.clear();
-
-    } else if (!found_assignment && c == ' ') {
-      // A field tokenizer.
-
-    } else if (found_assignment) {
-      // Enclosure sequences appear immediately following assignment.
-      if (c == '"') {
-        found_enclose = true;
-      }
-
-      value += c;
-
-    } else if (c == '=') {
-      found_assignment = true;
-
-    } else {
-      key += c;
-    }
-  }
-
-  // Last step, if there was no trailing tokenizer.
-  if (!key.empty()) {
-    event_record.fields.emplace(
-        std::make_pair(std::move(key), std::move(value)));
-  }
+  TokenizeAuditFields(field_view, event_record.fields);
 
   return true;
 }
@@ -21,6 +21,7 @@
 #include <vector>
 
 #include <boost/algorithm/hex.hpp>
+#include <boost/utility/string_ref.hpp>
 
 #include <osquery/dispatcher/dispatcher.h>
 
@@ -161,6 +162,11 @@ class AuditdNetlinkParser final : public InternalRunnable {
   static bool ParseAuditReply(const audit_reply& reply,
                               AuditEventRecord& event_record) noexcept;
 
+  /// Splits the 'key=value' fields of an audit record message
+  static void TokenizeAuditFields(
+      boost::string_ref field_view,
+      std::map<std::string, std::string>& fields) noexcept;
+
   /// Adjusts the internal pointers of the audit_reply object
   static void AdjustAuditReply(audit_reply& reply) noexcept;
 
@@ -120,14 +120,14 @@ Status AuditEventPublisher::run() {
 
 void AuditEventPublisher::ProcessEvents(
     AuditEventContextRef event_context,
-    const std::vector<AuditEventRecord>& record_list,
+    std::vector<AuditEventRecord>& record_list,
     AuditTraceContext& trace_context,
     const std::set<int>& syscalls_allowed_to_fail) noexcept {
   static const auto& selinux_event_set = kSELinuxEventList;
 
   // Assemble each record into a AuditEvent object; multi-record events
   // are complete when we receive the terminator (AUDIT_EOE)
-  for (const auto& audit_event_record : record_list) {
+  for (auto& audit_event_record : record_list) {
     auto audit_event_it = trace_context.find(audit_event_record.audit_id);
 
     // We have two entry points here; the first one is for user messages, while
@@ -142,7 +142,7 @@ void AuditEventPublisher::ProcessEvents(
       audit_event.record_list.push_back(std::move(audit_event_record));
       audit_event.data = data;
 
-      event_context->audit_events.push_back(audit_event);
+      event_context->audit_events.push_back(std::move(audit_event));
 
       // SELinux or AppArmor events
     } else if (selinux_event_set.find(audit_event_record.type) !=
@@ -153,9 +153,9 @@ void AuditEventPublisher::ProcessEvents(
 
         AuditEvent audit_event;
         audit_event.type = AuditEvent::Type::SELinux;
-        audit_event.record_list.push_back(audit_event_record);
+        audit_event.record_list.push_back(std::move(audit_event_record));
 
-        event_context->audit_events.push_back(audit_event);
+        event_context->audit_events.push_back(std::move(audit_event));
       } else {
         // We've got an AppArmor event
         AppArmorAuditEventData data;
@@ -191,9 +191,9 @@ void AuditEventPublisher::ProcessEvents(
 
         AuditEvent audit_event;
         audit_event.type = AuditEvent::Type::AppArmor;
-        audit_event.record_list.push_back(audit_event_record);
-        audit_event.data = data;
-        event_context->audit_events.push_back(audit_event);
+        audit_event.record_list.push_back(std::move(audit_event_record));
+        audit_event.data = std::move(data);
+        event_context->audit_events.push_back(std::move(audit_event));
       }
 
       // Seccomp events
@@ -204,9 +204,9 @@ void AuditEventPublisher::ProcessEvents(
 
       AuditEvent audit_event;
       audit_event.type = AuditEvent::Type::Seccomp;
-      audit_event.data = data;
-      audit_event.record_list.push_back(audit_event_record);
-      event_context->audit_events.push_back(audit_event);
+      audit_event.data = std::move(data);
+      audit_event.record_list.push_back(std::move(audit_event_record));
+      event_context->audit_events.push_back(std::move(audit_event));
 
     } else if (audit_event_record.type == AUDIT_SYSCALL) {
       if (audit_event_it != trace_context.end()) {
@@ -361,8 +361,9 @@ void AuditEventPublisher::ProcessEvents(
       data.process_fsgid = static_cast<gid_t>(process_fsgid);
       data.process_sgid = static_cast<gid_t>(process_sgid);
 
-      audit_event.record_list.push_back(audit_event_record);
-      trace_context[audit_event_record.audit_id] = std::move(audit_event);
+      auto audit_id = audit_event_record.audit_id;
+      audit_event.record_list.push_back(std::move(audit_event_record));
+      trace_context[std::move(audit_id)] = std::move(audit_event);
 
       // This is the terminator for multi-record audit events
     } else if (audit_event_record.type == AUDIT_EOE) {
@@ -370,7 +371,7 @@ void AuditEventPublisher::ProcessEvents(
         continue;
       }
 
-      auto completed_audit_event = audit_event_it->second;
+      auto completed_audit_event = std::move(audit_event_it->second);
       trace_context.erase(audit_event_it);
 
       event_context->audit_events.push_back(std::move(completed_audit_event));
@@ -380,7 +381,8 @@ void AuditEventPublisher::ProcessEvents(
         continue;
       }
 
-      audit_event_it->second.record_list.push_back(audit_event_record);
+      audit_event_it->second.record_list.push_back(
+          std::move(audit_event_record));
     }
   }
 
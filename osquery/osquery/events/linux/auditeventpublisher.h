@@ -150,10 +150,10 @@ class AuditEventPublisher final
   /// Executable path
   static std::string executable_path_;
 
-  /// Aggregates raw event records into audit events
+  /// Aggregates raw event records into audit events, the records are moved
   static void ProcessEvents(
       AuditEventContextRef event_context,
-      const std::vector<AuditEventRecord>& record_list,
+      std::vector<AuditEventRecord>& record_list,
       AuditTraceContext& trace_context,
       const std::set<int>& syscalls_allowed_to_fail) noexcept;
 
@@ -14,6 +14,11 @@ namespace osquery {
 
 namespace ebpfpub = tob::ebpfpub;
 
+BPFPublisherStats& getBPFPublisherStats() {
+  static BPFPublisherStats stats;
+  return stats;
+}
+
 void updateBpfErrorState(
     BPFErrorState& bpf_error_state,
     const ebpfpub::IPerfEventReader::ErrorCounters& perf_error_counters) {
@@ -28,6 +33,12 @@ void updateBpfErrorState(
 
   bpf_error_state.perf_error_counters.invalid_event_data +=
       perf_error_counters.invalid_event_data;
+
+  auto& stats = getBPFPublisherStats();
+  stats.lost_events += perf_error_counters.lost_events;
+  stats.invalid_events += perf_error_counters.invalid_event +
+                          perf_error_counters.invalid_probe_output +
+                          perf_error_counters.invalid_event_data;
 }
 
 void reportAndClearBpfErrorState(BPFErrorState& bpf_error_state) {
@@ -11,6 +11,8 @@
 
 #include <ebpfpub/iperfeventreader.h>
 
+#include <atomic>
+#include <cstdint>
 #include <unordered_set>
 
 namespace osquery {
@@ -31,6 +33,30 @@ struct BPFErrorState final {
   std::unordered_set<std::uint64_t> errored_tracer_list;
 };
 
+/// Cumulative publisher counters, exposed by the bpf_publisher_stats table
+struct BPFPublisherStats final {
+  /// Events the kernel could not write to the perf buffers
+  std::atomic<std::uint64_t> lost_events{0U};
+
+  /// Events that could not be decoded
+  std::atomic<std::uint64_t> invalid_events{0U};
+
+  /// Buffers/strings that could not be captured by the probes
+  std::atomic<std::uint64_t> probe_errors{0U};
+
+  /// Events received after a more recent event was already processed
+  std::atomic<std::uint64_t> late_events{0U};
+
+  /// Events handed to the system state tracker
+  std::atomic<std::uint64_t> processed_events{0U};
+
+  /// Events waiting in the reordering queue
+  std::atomic<std::uint64_t> queued_events{0U};
+};
+
+/// Returns the process-wide publisher counters
+BPFPublisherStats& getBPFPublisherStats();
+
 /// Updates the error state structure with the given perf error counters
 void updateBpfErrorState(
     BPFErrorState& bpf_error_state,
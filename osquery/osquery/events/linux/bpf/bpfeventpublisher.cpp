@@ -125,7 +125,10 @@ struct BPFEventPublisher::PrivateData final {
   BufferStorageMap buffer_storage_map;
   EventHandlerMap event_handler_map;
 
-  std::map<std::uint64_t, ebpfpub::IFunctionTracer::Event> event_queue;
+  // Events are ordered by timestamp; different CPUs can emit events with
+  // the same timestamp, so keys are not unique
+  std::multimap<std::uint64_t, ebpfpub::IFunctionTracer::Event> event_queue;
+  std::uint64_t last_processed_timestamp{0U};
   ISystemStateTracker::Ref system_state_tracker;
 };
 
@@ -298,6 +301,7 @@ void BPFEventPublisher::tearDown() {
   d->buffer_storage_map.clear();
   d->event_handler_map.clear();
   d->event_queue.clear();
+  d->last_processed_timestamp = 0U;
 
   d->initialized = false;
 }
@@ -313,6 +317,7 @@ Status BPFEventPublisher::run() {
   }
 
   BPFErrorState bpf_error_state;
+  auto& stats = getBPFPublisherStats();
 
   auto last_error_report = getUnixTime();
   auto last_tracker_restart = getUnixTime();
@@ -345,10 +350,12 @@ Status BPFEventPublisher::run() {
           for (auto& event : event_list) {
             if (event.header.probe_error) {
               ++bpf_error_state.probe_error_counter;
+              ++stats.probe_errors;
             }
 
             auto rel_timestamp = event.header.timestamp;
-            d->event_queue.insert({rel_timestamp, std::move(event)});
+            d->event_queue.emplace_hint(
+                d->event_queue.end(), rel_timestamp, std::move(event));
           }
         });
 
@@ -365,14 +372,21 @@ Status BPFEventPublisher::run() {
 
     for (auto event_it = d->event_queue.begin();
          event_it != d->event_queue.end();) {
+      // The queue is sorted, every following event is also too recent
       const auto& rel_timestamp = event_it->first / 1000000000ULL;
       if (system_info.uptime - rel_timestamp < 5ULL) {
-        ++event_it;
-        continue;
+        break;
+      }
+
+      if (event_it->first < d->last_processed_timestamp) {
+        ++stats.late_events;
+      } else {
+        d->last_processed_timestamp = event_it->first;
       }
 
       auto event = std::move(event_it->second);
       event_it = d->event_queue.erase(event_it);
+      ++stats.processed_events;
 
       auto event_handler_it = d->event_handler_map.find(event.identifier);
       if (event_handler_it == d->event_handler_map.end()) {
@@ -387,6 +401,8 @@ Status BPFEventPublisher::run() {
       }
     }
 
+    stats.queued_events = d->event_queue.size();
+
     auto event_list = state.eventList();
     if (!event_list.empty()) {
       auto event_context = createEventContext();
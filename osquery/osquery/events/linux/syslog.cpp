@@ -10,19 +10,17 @@
 #include <fcntl.h>
 #include <grp.h>
 #include <sys/file.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <time.h>
 #include <unistd.h>
 
 #include <istream>
 #include <string>
 
-#include <boost/algorithm/string/trim.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/lexical_cast.hpp>
-#include <boost/property_tree/json_parser.hpp>
-#include <boost/tokenizer.hpp>
 #include <osquery/registry/registry_factory.h>
 
 #include <osquery/core/flags.h>
@@ -42,9 +40,14 @@ FLAG(string,
      "/var/osquery/syslog_pipe",
      "Path to the named pipe used for forwarding rsyslog events");
 
+FLAG(string,
+     syslog_socket_path,
+     "",
+     "Read rsyslog events from a unix datagram socket instead of the pipe");
+
 FLAG(uint64,
      syslog_rate_limit,
-     100,
+     10000,
      "Maximum number of logs to ingest per run (~200ms between runs)");
 
 REGISTER(SyslogEventPublisher, "event_publisher", "syslog");
@@ -57,6 +60,67 @@ const std::vector<std::string> kCsvFields = {
     "time", "host", "severity", "facility", "tag", "message"};
 const size_t kErrorThreshold = 10;
 
+// Grow the pipe, and socket, kernel buffers so that rsyslog does not block
+// on writes while the publisher pauses between runs.
+const int kPipeBufferSize = 1024 * 1024;
+const int kSocketBufferSize = 4 * 1024 * 1024;
+
+namespace {
+
+std::string_view trimField(std::string_view value) {
+  const char* kWhitespace = " \t\n\v\f\r";
+  auto begin = value.find_first_not_of(kWhitespace);
+  if (begin == std::string_view::npos) {
+    return std::string_view();
+  }
+  auto end = value.find_last_not_of(kWhitespace);
+  return value.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+SyslogPublisherStats& getSyslogPublisherStats() {
+  static SyslogPublisherStats stats;
+  return stats;
+}
+
+void splitRsyslogCsv(std::string_view line,
+                     std::vector<std::string_view>& fields,
+                     std::string& scratch) {
+  fields.clear();
+  if (line.empty()) {
+    return;
+  }
+
+  // Unescaping never grows a field, so the output is written over the input.
+  scratch.assign(line.data(), line.size());
+  char* field = &scratch[0];
+  char* output = field;
+  const char* end = scratch.data() + scratch.size();
+  bool in_quote = false;
+  for (char* input = &scratch[0]; input != end; ++input) {
+    if (*input == ',' && !in_quote) {
+      fields.emplace_back(field, output - field);
+      field = output = input + 1;
+    } else if (*input == '"') {
+      if (!in_quote) {
+        in_quote = true;
+      } else if (input + 1 != end && *(input + 1) == '"') {
+        // rsyslog escapes " with "", so reverse this by inserting "
+        *output++ = '"';
+        ++input;
+      } else {
+        in_quote = false;
+      }
+    } else {
+      *output++ = *input;
+    }
+  }
+
+  // A trailing comma is followed by an empty field.
+  fields.emplace_back(field, output - field);
+}
+
 Status NonBlockingFStream::openReadOnly(const std::string& path) {
   WriteLock lock(fd_mutex_);
 
@@ -68,6 +132,48 @@ Status NonBlockingFStream::openReadOnly(const std::string& path) {
   if (fd_ < 0) {
     return Status::failure("Error opening stream for reading: " + path);
   }
+
+  // This is best-effort, the size is limited by fs.pipe-max-size.
+  ::fcntl(fd_, F_SETPIPE_SZ, kPipeBufferSize);
+  return Status::success();
+}
+
+Status NonBlockingFStream::openSocket(const std::string& path) {
+  WriteLock lock(fd_mutex_);
+
+  if (fd_ != -1) {
+    return Status::failure("Stream already open");
+  }
+
+  struct sockaddr_un addr {};
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return Status::failure("Socket path is too long: " + path);
+  }
+  addr.sun_family = AF_UNIX;
+  path.copy(addr.sun_path, path.size());
+
+  fd_ = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd_ < 0) {
+    return Status::failure("Error creating socket: " +
+                           std::string(strerror(errno)));
+  }
+
+  if (::bind(fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) !=
+      0) {
+    auto error = std::string(strerror(errno));
+    ::close(fd_);
+    fd_ = -1;
+    return Status::failure("Error binding socket " + path + ": " + error);
+  }
+
+  // This is best-effort, the size is limited by net.core.rmem_max.
+  ::setsockopt(fd_,
+               SOL_SOCKET,
+               SO_RCVBUF,
+               &kSocketBufferSize,
+               sizeof(kSocketBufferSize));
+
+  datagram_ = true;
   return Status::success();
 }
 
@@ -128,6 +234,104 @@ Status NonBlockingFStream::getline(std::string& output) {
   return Status::success();
 }
 
+ssize_t NonBlockingFStream::readDatagram() {
+  while (true) {
+    // Keep one byte to terminate the datagram with a newline.
+    auto available = buffer_.size() - offset_;
+    if (available < 2) {
+      return 0;
+    }
+
+    // With MSG_TRUNC the full length of the datagram is returned.
+    auto data = buffer_.data() + offset_;
+    auto bytes_read =
+        ::recv(fd_, data, available - 1, MSG_DONTWAIT | MSG_TRUNC);
+    if (bytes_read < 0) {
+      return bytes_read;
+    } else if (static_cast<size_t>(bytes_read) > available - 1) {
+      // The datagram is larger than the free space and was cut short.
+      getSyslogPublisherStats().overflowed_lines++;
+      continue;
+    }
+
+    if (bytes_read == 0 || data[bytes_read - 1] != '\n') {
+      data[bytes_read++] = '\n';
+    }
+    return bytes_read;
+  }
+}
+
+Status NonBlockingFStream::readLines(std::vector<std::string_view>& lines,
+                                     size_t max_lines) {
+  lines.clear();
+
+  WriteLock lock(fd_mutex_);
+  if (fd_ == -1) {
+    return Status::failure("Stream is not open");
+  }
+
+  // Shift the bytes after the lines returned by the previous call down.
+  auto compact = [this]() {
+    offset_ -= consumed_;
+    if (offset_ > 0) {
+      memmove(buffer_.data(), buffer_.data() + consumed_, offset_);
+    }
+    consumed_ = 0;
+  };
+  compact();
+
+  size_t scanned = 0;
+  while (lines.size() < max_lines) {
+    auto line_end = static_cast<char*>(
+        memchr(buffer_.data() + scanned, '\n', offset_ - scanned));
+    if (line_end != nullptr) {
+      if (discarding_) {
+        // This is the tail of a line that overflowed the buffer.
+        discarding_ = false;
+      } else {
+        lines.emplace_back(buffer_.data() + consumed_,
+                           line_end - buffer_.data() - consumed_);
+      }
+      consumed_ = scanned = line_end - buffer_.data() + 1;
+      continue;
+    }
+    scanned = offset_;
+
+    // A datagram is only read if it has room to fit, which is at most the
+    // largest syslog message forwarded by rsyslog.
+    auto full = (datagram_) ? buffer_.size() - offset_ < buffer_.size() / 4
+                            : offset_ == buffer_.size();
+    if (full) {
+      if (!lines.empty()) {
+        // The lines must be used before the buffer is compacted.
+        break;
+      } else if (consumed_ > 0) {
+        compact();
+        scanned = offset_;
+      } else {
+        // A single line fills the buffer, drop it until the next newline.
+        if (!discarding_) {
+          getSyslogPublisherStats().overflowed_lines++;
+          discarding_ = true;
+        }
+        offset_ = scanned = 0;
+      }
+    }
+
+    auto bytes_read =
+        (datagram_) ? readDatagram()
+                    : ::read(fd_,
+                             buffer_.data() + offset_,
+                             buffer_.size() - offset_);
+    if (bytes_read <= 0) {
+      // No more data is available.
+      break;
+    }
+    offset_ += bytes_read;
+  }
+  return Status::success();
+}
+
 Status NonBlockingFStream::close() {
   WriteLock lock(fd_mutex_);
 
@@ -135,6 +339,7 @@ Status NonBlockingFStream::close() {
     ::close(fd_);
     fd_ = -1;
   }
+  datagram_ = false;
   return Status();
 }
 
@@ -143,6 +348,17 @@ Status SyslogEventPublisher::setUp() {
     return Status(1, "Publisher disabled via configuration");
   }
 
+  if (!FLAGS_syslog_socket_path.empty()) {
+    auto s = createSocket(FLAGS_syslog_socket_path);
+    if (!s.ok()) {
+      return s;
+    }
+
+    VLOG(1) << "Successfully bound socket for syslog ingestion: "
+            << FLAGS_syslog_socket_path;
+    return Status::success();
+  }
+
   Status s;
   if (!pathExists(FLAGS_syslog_pipe_path)) {
     VLOG(1) << "Pipe does not exist: creating pipe " << FLAGS_syslog_pipe_path;
@@ -180,10 +396,51 @@ Status SyslogEventPublisher::createPipe(const std::string& path) {
   if (mkfifo(path.c_str(), kPipeMode) != 0) {
     return Status(1, "Error in mkfifo: " + std::string(strerror(errno)));
   }
+  return setPipePermissions(path);
+}
 
+Status SyslogEventPublisher::createSocket(const std::string& path) {
+  boost::system::error_code ec;
+  auto file_status = fs::symlink_status(path, ec);
+  if (file_status.type() == fs::socket_file) {
+    // Only remove a stale socket, another osquery process may be reading.
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+
+    int probe = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    auto in_use =
+        probe >= 0 && ::connect(probe,
+                                reinterpret_cast<struct sockaddr*>(&addr),
+                                sizeof(addr)) == 0;
+    if (probe >= 0) {
+      ::close(probe);
+    }
+    if (in_use) {
+      return Status(1, "Socket is in use by another process: " + path);
+    }
+    fs::remove(path, ec);
+  } else if (file_status.type() != fs::file_not_found) {
+    return Status(1, "Not a socket file: " + path);
+  }
+
+  auto s = readStream_.openSocket(path);
+  if (!s.ok()) {
+    return s;
+  }
+
+  s = setPipePermissions(path);
+  if (!s.ok()) {
+    LOG(WARNING) << "Problems encountered setting socket permissions: "
+                 << s.getMessage();
+  }
+  return Status::success();
+}
+
+Status SyslogEventPublisher::setPipePermissions(const std::string& path) {
   // Explicitly set the permissions since the umask will effect the
-  // permissions created by mkfifo
-  if (chmod(FLAGS_syslog_pipe_path.c_str(), kPipeMode) != 0) {
+  // permissions created by mkfifo and bind
+  if (chmod(path.c_str(), kPipeMode) != 0) {
     return Status(1, "Error in chmod: " + std::string(strerror(errno)));
   }
 
@@ -194,7 +451,7 @@ Status SyslogEventPublisher::createPipe(const std::string& path) {
             << " found. Not changing group for the pipe.";
     return Status::success();
   }
-  if (chown(FLAGS_syslog_pipe_path.c_str(), -1, group->gr_gid) == -1) {
+  if (chown(path.c_str(), -1, group->gr_gid) == -1) {
     return Status(1,
                   "Error in chown to group " + kPipeGroupName + ": " +
                       std::string(strerror(errno)));
@@ -228,67 +485,91 @@ void SyslogEventPublisher::unlockPipe() {
 }
 
 Status SyslogEventPublisher::run() {
-  // This run function will be called by the event factory with ~100ms pause
+  // This run function will be called by the event factory with ~200ms pause
   // (see InterruptibleRunnable::pause()) between runs. In case something goes
   // weird and there is a huge amount of input, we limit how many logs we
   // take in per run to avoid pegging the CPU.
+  auto& stats = getSyslogPublisherStats();
 
-  std::string line;
-  for (size_t i = 0; i < FLAGS_syslog_rate_limit; ++i) {
-    if (!readStream_.getline(line) || line.empty()) {
+  size_t remaining = FLAGS_syslog_rate_limit;
+  while (remaining > 0) {
+    if (!readStream_.readLines(lines_, remaining) || lines_.empty()) {
       // Not enough data was available, fall through an wait.
       break;
     }
+    remaining -= lines_.size();
 
+    // Every line read at once is fired to subscribers as a single event.
     auto ec = createEventContext();
-    Status status = populateEventContext(line, ec);
-    if (status.ok()) {
-      fire(ec);
-      if (errorCount_ > 0) {
-        --errorCount_;
+    ec->rows.reserve(lines_.size());
+
+    bool too_many_errors = false;
+    for (const auto& line : lines_) {
+      if (line.empty()) {
+        continue;
       }
-    } else {
-      LOG(ERROR) << status.getMessage() << " in line: " << line;
-      ++errorCount_;
-      if (errorCount_ >= kErrorThreshold) {
-        return Status(1, "Too many errors in syslog parsing.");
+
+      Row row;
+      auto status = populateRow(line, row);
+      if (status.ok()) {
+        ec->rows.push_back(std::move(row));
+        if (errorCount_ > 0) {
+          --errorCount_;
+        }
+      } else {
+        stats.parse_errors++;
+        LOG(ERROR) << status.getMessage() << " in line: " << line;
+        ++errorCount_;
+        if (errorCount_ >= kErrorThreshold) {
+          too_many_errors = true;
+          break;
+        }
       }
     }
+
+    if (!ec->rows.empty()) {
+      stats.lines += ec->rows.size();
+      stats.batches++;
+      fire(ec);
+    }
+
+    if (too_many_errors) {
+      return Status(1, "Too many errors in syslog parsing.");
+    }
   }
   return Status::success();
 }
 
 void SyslogEventPublisher::tearDown() {
   readStream_.close();
+  if (!FLAGS_syslog_socket_path.empty()) {
+    boost::system::error_code ec;
+    fs::remove(FLAGS_syslog_socket_path, ec);
+  }
   unlockPipe();
 }
 
-Status SyslogEventPublisher::populateEventContext(const std::string& line,
-                                                  SyslogEventContextRef& ec) {
-  boost::tokenizer<RsyslogCsvSeparator> tokenizer(line);
-  auto key = kCsvFields.begin();
-  for (std::string value : tokenizer) {
-    if (key == kCsvFields.end()) {
-      return Status(1, "Received more fields than expected");
-    }
+Status SyslogEventPublisher::populateRow(std::string_view line, Row& row) {
+  splitRsyslogCsv(line, fields_, scratch_);
+  if (fields_.size() > kCsvFields.size()) {
+    return Status(1, "Received more fields than expected");
+  } else if (fields_.size() < kCsvFields.size()) {
+    return Status(1, "Received fewer fields than expected");
+  }
 
-    boost::trim(value);
-    if (*key == "time") {
-      ec->fields["datetime"] = value;
-    } else if (*key == "tag" && !value.empty() && value.back() == ':') {
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    const auto& key = kCsvFields[i];
+    auto value = trimField(fields_[i]);
+    if (key == "time") {
+      row["datetime"] = std::string(value);
+    } else if (key == "tag" && !value.empty() && value.back() == ':') {
       // rsyslog sends "tag" with a trailing colon that we don't need
-      ec->fields.emplace(*key, value.substr(0, value.size() - 1));
+      row.emplace(key, std::string(value.substr(0, value.size() - 1)));
     } else {
-      ec->fields.emplace(*key, value);
+      row.emplace(key, std::string(value));
     }
-    ++key;
-  }
-
-  if (key == kCsvFields.end()) {
-    return Status::success();
-  } else {
-    return Status(1, "Received fewer fields than expected");
   }
+  return Status::success();
 }
 
 bool SyslogEventPublisher::shouldFire(const SyslogSubscriptionContextRef& sc,
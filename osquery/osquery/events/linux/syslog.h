@@ -9,13 +9,16 @@
 
 #pragma once
 
+#include <osquery/core/sql/row.h>
 #include <osquery/events/eventpublisher.h>
 #include <osquery/events/eventsubscriber.h>
 #include <osquery/utils/mutex.h>
 
 #include <boost/noncopyable.hpp>
 
+#include <atomic>
 #include <map>
+#include <string_view>
 #include <vector>
 
 #include <stdio.h>
@@ -39,16 +42,34 @@ struct SyslogSubscriptionContext : public SubscriptionContext {
  */
 struct SyslogEventContext : public EventContext {
   /**
-   * @brief The syslog message tokenized into fields.
+   * @brief A batch of syslog messages, each tokenized into fields.
    *
    * Fields will be stripped of extra space
    */
-  std::map<std::string, std::string> fields;
+  std::vector<Row> rows;
 };
 
 using SyslogEventContextRef = std::shared_ptr<SyslogEventContext>;
 using SyslogSubscriptionContextRef = std::shared_ptr<SyslogSubscriptionContext>;
 
+/// Cumulative publisher counters, exposed by the syslog_publisher_stats table
+struct SyslogPublisherStats final {
+  /// Lines parsed and fired to subscribers
+  std::atomic<std::uint64_t> lines{0U};
+
+  /// Batches fired to subscribers
+  std::atomic<std::uint64_t> batches{0U};
+
+  /// Lines that could not be parsed as rsyslog CSV
+  std::atomic<std::uint64_t> parse_errors{0U};
+
+  /// Lines dropped because they did not fit in the read buffer
+  std::atomic<std::uint64_t> overflowed_lines{0U};
+};
+
+/// Returns the process-wide publisher counters
+SyslogPublisherStats& getSyslogPublisherStats();
+
 /**
  * @brief Implement a non-blocking-read of a pipe.
  *
@@ -77,6 +98,13 @@ class NonBlockingFStream : public boost::noncopyable {
   /// Open for reading and writing to avoid blocking a pipe read.
   Status openReadOnly(const std::string& path);
 
+  /**
+   * @brief Bind a unix datagram socket for reading.
+   *
+   * Each datagram is read as a single line, a trailing newline is optional.
+   */
+  Status openSocket(const std::string& path);
+
   /// Close the managed fstream, called on destruction.
   Status close();
 
@@ -92,6 +120,18 @@ class NonBlockingFStream : public boost::noncopyable {
    */
   Status getline(std::string& output);
 
+  /**
+   * @brief Read every complete line available, up to max_lines.
+   *
+   * This performs as few large non-blocking reads as possible. The output
+   * lines are views into the internal buffer and remain valid until the next
+   * call. A line that overflows the internal buffer is dropped entirely and
+   * counted in the publisher stats.
+   *
+   * Do not mix calls to readLines and getline on the same stream.
+   */
+  Status readLines(std::vector<std::string_view>& lines, size_t max_lines);
+
   /// Inspect the internal offset.
   size_t offset() {
     return offset_;
@@ -115,17 +155,32 @@ class NonBlockingFStream : public boost::noncopyable {
    */
   size_t offset_{0};
 
+  /// Bytes at the front of the buffer already returned by readLines.
+  size_t consumed_{0};
+
+  /// The remainder of an overflowed line is being discarded.
+  bool discarding_{false};
+
+  /// The descriptor is a datagram socket rather than a pipe.
+  bool datagram_{false};
+
+ private:
+  /// Read one datagram into the buffer, terminated with a newline.
+  ssize_t readDatagram();
+
  private:
   FRIEND_TEST(SyslogTests, test_nonblockingfstream);
+  FRIEND_TEST(SyslogTests, test_nonblockingfstream_lines);
+  FRIEND_TEST(SyslogTests, test_nonblockingfstream_socket);
 };
 
 /**
  * @brief Event publisher for syslog lines forwarded through rsyslog
  *
- * This event publisher ingests JSON representations of syslog entries, and
- * publishes them to it's subscribers. In order for it to function properly,
- * rsyslog must be configured to forward JSON to a named pipe that this
- * publisher will read from.
+ * This event publisher ingests CSV representations of syslog entries, and
+ * publishes them to it's subscribers in batches. In order for it to function
+ * properly, rsyslog must be configured to forward CSV to a named pipe, or a
+ * unix datagram socket, that this publisher will read from.
  */
 class SyslogEventPublisher
     : public EventPublisher<SyslogSubscriptionContext, SyslogEventContext> {
@@ -158,6 +213,12 @@ class SyslogEventPublisher
    */
   Status createPipe(const std::string& path);
 
+  /// Bind the unix datagram socket used for log forwarding.
+  Status createSocket(const std::string& path);
+
+  /// Allow the syslog group to write to the pipe or socket.
+  Status setPipePermissions(const std::string& path);
+
   /**
    * @brief Attempt to lock the pipe for reading.
    *
@@ -177,18 +238,27 @@ class SyslogEventPublisher
   void unlockPipe();
 
   /**
-   * @brief Populate the SyslogEventContext with the syslog JSON.
+   * @brief Populate a row with the fields of a syslog CSV line.
    *
-   * Performs basic cleanup on the JSON data as it is populated into the
-   * context.
+   * Performs basic cleanup on the CSV data as it is populated into the row.
    */
-  static Status populateEventContext(const std::string& line,
-                                     SyslogEventContextRef& ec);
+  Status populateRow(std::string_view line, Row& row);
 
   /**
-   * @brief Input stream for reading from the pipe.
+   * @brief Input stream for reading from the pipe or socket.
+   *
+   * The buffer is large enough to dequeue many lines with a single read.
    */
-  NonBlockingFStream readStream_;
+  NonBlockingFStream readStream_{256 * 1024};
+
+  /// Reused views of the lines read in a run.
+  std::vector<std::string_view> lines_;
+
+  /// Reused views of the fields split from a line.
+  std::vector<std::string_view> fields_;
+
+  /// Reused buffer the fields of a line are unescaped into.
+  std::string scratch_;
 
   /**
    * @brief Counter used to shut down thread when too many errors occur.
@@ -209,71 +279,21 @@ class SyslogEventPublisher
   int lockFd_;
 
  private:
-  FRIEND_TEST(SyslogTests, test_populate_event_context);
+  FRIEND_TEST(SyslogTests, test_populate_row);
 };
 
 /**
- * Boost TokenizerFunction functor for tokenizing rsyslog CSV data
+ * @brief Split a line of rsyslog CSV data into fields.
+ *
+ * The line is copied once into scratch and unescaped in place, the output
+ * fields are views into scratch. rsyslog escapes " with "", and does not
+ * escape backslashes, so a generic CSV tokenizer cannot be used.
  *
- * This functor is intended to be used with boost::tokenizer in order to
- * properly parse CSV data generated by rsyslog. The default
- * boost::escaped_list_separator provided with boost::tokenizer chokes on
- * rsyslog CSV output, because rsyslog escapes " with "", and also does not
- * escape backslashes. Our implementation closely follows the one provided with
- * Boost, but allows for the idiosyncrasies of rsyslog output and simplifies
- * the implementation for our limited use case.
+ * @param line A single line of CSV without the newline.
+ * @param fields Output views, valid until scratch is modified.
+ * @param scratch A reusable buffer.
  */
-class RsyslogCsvSeparator {
- public:
-  RsyslogCsvSeparator() : last_(false) {}
-
-  void reset() {
-    last_ = false;
-  }
-
-  template <typename InputIterator, typename Token>
-  bool operator()(InputIterator& next, InputIterator end, Token& tok) {
-    bool in_quote = false;
-    tok = Token();
-
-    if (next == end) {
-      if (last_) {
-        // The last character was a comma, so we got an empty field at the end
-        last_ = false;
-        return true;
-      } else {
-        return false;
-      }
-    }
-    last_ = false;
-    for (; next != end; ++next) {
-      if (*next == ',') {
-        if (!in_quote) {
-          ++next;
-          last_ = true;
-          return true;
-        } else {
-          tok += *next;
-        }
-      } else if (*next == '"') {
-        auto after = next + 1;
-        if (!in_quote) {
-          in_quote = true;
-        } else if (after != end && *after == '"') {
-          // rsyslog escapes " with "", so reverse this by inserting "
-          tok += "\"";
-          ++next;
-        } else {
-          in_quote = false;
-        }
-      } else {
-        tok += *next;
-      }
-    }
-    return true;
-  }
-
- private:
-  bool last_;
-};
+void splitRsyslogCsv(std::string_view line,
+                     std::vector<std::string_view>& fields,
+                     std::string& scratch);
 } // namespace osquery
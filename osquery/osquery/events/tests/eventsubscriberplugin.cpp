@@ -239,6 +239,110 @@ TEST_F(EventSubscriberPluginTests, generateRows) {
   EXPECT_EQ(result.isEnd, true);
 }
 
+TEST_F(EventSubscriberPluginTests, generateRowsWithoutDecoding) {
+  MockedOsqueryDatabase mocked_database;
+  mocked_database.generateEvents("type", "name");
+
+  EventSubscriberPlugin::Context context;
+  EventSubscriberPlugin::setDatabaseNamespace(context, "type", "name");
+
+  auto status =
+      EventSubscriberPlugin::generateEventDataIndex(context, mocked_database);
+  ASSERT_TRUE(status.ok());
+
+  // Rows are built from the index, the stored rows need not be decoded.
+  std::vector<Row> rows;
+  auto callback = [&rows](Row row) { rows.push_back(std::move(row)); };
+  auto result = EventSubscriberPlugin::generateRows(
+      context, mocked_database, callback, 3, 5, 0, false);
+  EXPECT_EQ(result.isEnd, false);
+  EXPECT_EQ(result.last_time, 5U);
+
+  ASSERT_EQ(rows.size(), 3U);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    EXPECT_EQ(rows[i].size(), 2U);
+    EXPECT_EQ(rows[i]["time"], std::to_string(i + 3));
+    EXPECT_EQ(rows[i]["eid"], EventSubscriberPlugin::toIndex(2 * (i + 3) + 1));
+  }
+
+  // Events whose stored row is empty or broken are skipped and erased, as
+  // when the rows are decoded.
+  auto empty_key = EventSubscriberPlugin::databaseKeyForEventId(context, 7);
+  auto broken_key = EventSubscriberPlugin::databaseKeyForEventId(context, 9);
+  mocked_database.key_map[empty_key] = "";
+  mocked_database.key_map[broken_key] = "[\"time\", \"4\"]";
+
+  rows.clear();
+  EventSubscriberPlugin::generateRows(
+      context, mocked_database, callback, 3, 5, 0, false);
+  ASSERT_EQ(rows.size(), 1U);
+  EXPECT_EQ(rows[0]["time"], "5");
+  EXPECT_EQ(mocked_database.key_map.count(empty_key), 0U);
+  EXPECT_EQ(mocked_database.key_map.count(broken_key), 0U);
+
+  mocked_database.key_map[empty_key] = "";
+  mocked_database.key_map[broken_key] = "{\"time\": \"4\"";
+
+  rows.clear();
+  EventSubscriberPlugin::generateRows(
+      context, mocked_database, callback, 3, 5, 0, false);
+  ASSERT_EQ(rows.size(), 1U);
+  EXPECT_EQ(rows[0]["time"], "5");
+}
+
+TEST_F(EventSubscriberPluginTests, getTimeBounds) {
+  EventTime start{1};
+  EventTime stop{1};
+
+  QueryContext unbounded;
+  EXPECT_TRUE(EventSubscriberPlugin::getTimeBounds(unbounded, start, stop));
+  EXPECT_EQ(start, 0U);
+  EXPECT_EQ(stop, 0U);
+
+  QueryContext range;
+  range.constraints["time"].add(Constraint(GREATER_THAN, "10"));
+  range.constraints["time"].add(Constraint(LESS_THAN, "20"));
+  EXPECT_TRUE(EventSubscriberPlugin::getTimeBounds(range, start, stop));
+  EXPECT_EQ(start, 11U);
+  EXPECT_EQ(stop, 19U);
+
+  QueryContext upper;
+  upper.constraints["time"].add(Constraint(LESS_THAN_OR_EQUALS, "30"));
+  upper.constraints["time"].add(Constraint(LESS_THAN_OR_EQUALS, "25"));
+  EXPECT_TRUE(EventSubscriberPlugin::getTimeBounds(upper, start, stop));
+  EXPECT_EQ(start, 0U);
+  EXPECT_EQ(stop, 25U);
+
+  QueryContext equals;
+  equals.constraints["time"].add(Constraint(EQUALS, "42"));
+  EXPECT_TRUE(EventSubscriberPlugin::getTimeBounds(equals, start, stop));
+  EXPECT_EQ(start, 42U);
+  EXPECT_EQ(stop, 42U);
+
+  QueryContext inverted;
+  inverted.constraints["time"].add(Constraint(GREATER_THAN, "20"));
+  inverted.constraints["time"].add(Constraint(LESS_THAN, "10"));
+  EXPECT_FALSE(EventSubscriberPlugin::getTimeBounds(inverted, start, stop));
+
+  QueryContext empty;
+  empty.constraints["time"].add(Constraint(LESS_THAN, "1"));
+  EXPECT_FALSE(EventSubscriberPlugin::getTimeBounds(empty, start, stop));
+}
+
+TEST_F(EventSubscriberPluginTests, onlyIndexColumnsUsed) {
+  QueryContext context;
+  EXPECT_FALSE(EventSubscriberPlugin::onlyIndexColumnsUsed(context));
+
+  context.colsUsed = UsedColumns{};
+  EXPECT_TRUE(EventSubscriberPlugin::onlyIndexColumnsUsed(context));
+
+  context.colsUsed = UsedColumns{"time", "eid"};
+  EXPECT_TRUE(EventSubscriberPlugin::onlyIndexColumnsUsed(context));
+
+  context.colsUsed = UsedColumns{"time", "path"};
+  EXPECT_FALSE(EventSubscriberPlugin::onlyIndexColumnsUsed(context));
+}
+
 class FakeEventSubscriberPlugin : public EventSubscriberPlugin {
  public:
   FakeEventSubscriberPlugin(IDatabaseInterface& db)
@@ -0,0 +1,156 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include "mockedosquerydatabase.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <osquery/events/eventtimeline.h>
+
+namespace osquery {
+
+class EventTimelineTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    EventSubscriberPlugin::setDatabaseNamespace(first_, "type", "first");
+    EventSubscriberPlugin::setDatabaseNamespace(second_, "type", "second");
+
+    for (EventTime time : {1, 3, 3, 5}) {
+      addEvent(first_, time);
+    }
+    for (EventTime time : {2, 3, 6}) {
+      addEvent(second_, time);
+    }
+  }
+
+  void addEvent(EventSubscriberPlugin::Context& context, EventTime time) {
+    auto event_id = EventSubscriberPlugin::generateEventIdentifier(context);
+    context.event_index[time].push_back(event_id);
+
+    auto key = EventSubscriberPlugin::databaseKeyForEventId(context, event_id);
+    database_.key_map[key] = "{\"time\":\"" + std::to_string(time) + "\"}";
+  }
+
+  std::vector<EventTimeline::Source> sources() {
+    return {{"first", &first_, &database_}, {"second", &second_, &database_}};
+  }
+
+  static std::vector<std::pair<EventTime, std::string>> drain(
+      EventTimeline& timeline) {
+    std::vector<std::pair<EventTime, std::string>> events;
+    EventTimeline::Event event;
+    while (timeline.next(event)) {
+      events.emplace_back(event.time, event.source);
+    }
+    return events;
+  }
+
+  MockedOsqueryDatabase database_;
+  EventSubscriberPlugin::Context first_;
+  EventSubscriberPlugin::Context second_;
+};
+
+TEST_F(EventTimelineTests, mergeInTimeOrder) {
+  // A chunk of a single entry refills every source after each event.
+  EventTimeline timeline(sources(), 0, 0, true, 1);
+
+  std::vector<std::pair<EventTime, std::string>> expected = {
+      {1, "first"},
+      {2, "second"},
+      {3, "first"},
+      {3, "first"},
+      {3, "second"},
+      {5, "first"},
+      {6, "second"},
+  };
+
+  std::vector<std::pair<EventTime, std::string>> events;
+  EventTimeline::Event event;
+  while (timeline.next(event)) {
+    EXPECT_EQ(event.data, "{\"time\":\"" + std::to_string(event.time) + "\"}");
+    events.emplace_back(event.time, event.source);
+  }
+  EXPECT_EQ(events, expected);
+
+  // Events within a source keep the order they were recorded in.
+  EventTimeline first_only({sources()[0]}, 3, 3, true, 1);
+  ASSERT_TRUE(first_only.next(event));
+  EXPECT_EQ(event.eid, 2U);
+  ASSERT_TRUE(first_only.next(event));
+  EXPECT_EQ(event.eid, 3U);
+  EXPECT_FALSE(first_only.next(event));
+}
+
+TEST_F(EventTimelineTests, timeBounds) {
+  EventTimeline timeline(sources(), 3, 5);
+
+  std::vector<std::pair<EventTime, std::string>> expected = {
+      {3, "first"},
+      {3, "first"},
+      {3, "second"},
+      {5, "first"},
+  };
+  EXPECT_EQ(drain(timeline), expected);
+
+  EventTimeline after(sources(), 6, 0);
+  expected = {{6, "second"}};
+  EXPECT_EQ(drain(after), expected);
+
+  EventTimeline inverted(sources(), 5, 3);
+  EXPECT_TRUE(drain(inverted).empty());
+
+  EventTimeline beyond(sources(), 100, 0);
+  EXPECT_TRUE(drain(beyond).empty());
+}
+
+TEST_F(EventTimelineTests, withoutReadingRows) {
+  // The mocked database throws on unknown keys, nothing may be read.
+  database_.key_map.clear();
+
+  EventTimeline timeline(sources(), 0, 0, false);
+
+  EventTimeline::Event event;
+  std::size_t count = 0;
+  while (timeline.next(event)) {
+    EXPECT_TRUE(event.data.empty());
+    ++count;
+  }
+  EXPECT_EQ(count, 7U);
+}
+
+TEST_F(EventTimelineTests, skipMissingRows) {
+  auto key = EventSubscriberPlugin::databaseKeyForEventId(first_, 1);
+  database_.key_map[key].clear();
+
+  EventTimeline timeline(sources(), 0, 2);
+
+  std::vector<std::pair<EventTime, std::string>> expected = {{2, "second"}};
+  EXPECT_EQ(drain(timeline), expected);
+}
+
+TEST_F(EventTimelineTests, ignoreNewerEvents) {
+  EventTimeline timeline(sources(), 5, 0);
+
+  // Events recorded after the timeline was created are not merged.
+  addEvent(first_, 10);
+  addEvent(second_, 6);
+
+  std::vector<std::pair<EventTime, std::string>> expected = {
+      {5, "first"},
+      {6, "second"},
+      {6, "second"},
+  };
+  EXPECT_EQ(drain(timeline), expected);
+}
+
+} // namespace osquery
@@ -76,6 +76,24 @@ TEST_F(AuditTests, test_handle_reply) {
   EXPECT_EQ(audit_event_record.fields["a2"], "c");
 }
 
+TEST_F(AuditTests, test_tokenize_audit_fields) {
+  std::map<std::string, std::string> fields;
+  AuditdNetlinkParser::TokenizeAuditFields(
+      "  key  a=1 b=\"x y\"c=2 d=e\"f g\" e=f=g =h a=3 i=\"open", fields);
+
+  EXPECT_EQ(fields.size(), 7U);
+  EXPECT_EQ(fields["key"], "");
+  // Duplicated keys keep the first value.
+  EXPECT_EQ(fields["a"], "1");
+  EXPECT_EQ(fields["b"], "\"x y\"");
+  EXPECT_EQ(fields["c"], "2");
+  EXPECT_EQ(fields["d"], "e\"f g\"");
+  EXPECT_EQ(fields["e"], "f=g");
+  EXPECT_EQ(fields.count(""), 0U);
+  // An unterminated enclosure extends to the end of the message.
+  EXPECT_EQ(fields["i"], "\"open");
+}
+
 TEST_F(AuditTests, test_audit_value_decode) {
   // In the normal case the decoding only removes '"' characters from the ends.
   auto decoded_normal = DecodeAuditPathValues("\"/bin/ls\"");
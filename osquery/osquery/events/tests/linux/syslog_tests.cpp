@@ -10,8 +10,10 @@
 #include <osquery/events/linux/syslog.h>
 #include <osquery/tests/test_util.h>
 
+#include <sys/socket.h>
+#include <sys/un.h>
+
 #include <boost/filesystem.hpp>
-#include <boost/tokenizer.hpp>
 
 #include <gtest/gtest.h>
 
@@ -34,9 +36,10 @@ class SyslogTests : public testing::Test {
   }
 
   std::vector<std::string> splitCsv(std::string line) {
-    boost::tokenizer<RsyslogCsvSeparator> tokenizer(line);
-    std::vector<std::string> result(tokenizer.begin(), tokenizer.end());
-    return result;
+    std::vector<std::string_view> fields;
+    std::string scratch;
+    splitRsyslogCsv(line, fields, scratch);
+    return std::vector<std::string>(fields.begin(), fields.end());
   }
 
  protected:
@@ -152,37 +155,120 @@ TEST_F(SyslogTests, test_nonblockingfstream) {
   }
 }
 
-TEST_F(SyslogTests, test_populate_event_context) {
+TEST_F(SyslogTests, test_nonblockingfstream_lines) {
+  auto pipe_path = test_working_dir_ / "pipe";
+  ASSERT_EQ(mkfifo(pipe_path.string().c_str(), 0660), 0);
+
+  NonBlockingFStream nbfs(20);
+  ASSERT_TRUE(nbfs.openReadOnly(pipe_path.string()).ok());
+
+  auto fd = open(pipe_path.string().c_str(), O_WRONLY | O_NONBLOCK);
+  ASSERT_GT(fd, 0);
+
+  // Nothing to read is not an error.
+  std::vector<std::string_view> lines;
+  EXPECT_TRUE(nbfs.readLines(lines, 10).ok());
+  EXPECT_TRUE(lines.empty());
+
+  // Several lines and a partial line are dequeued with a single read.
+  std::string fill = "AAA\nBB\n\nCC";
+  ASSERT_EQ(write(fd, fill.data(), fill.size()), 10);
+  EXPECT_TRUE(nbfs.readLines(lines, 10).ok());
+  EXPECT_EQ(std::vector<std::string_view>({"AAA", "BB", ""}), lines);
+
+  // The partial line is completed by the next read.
+  fill = "C\nDDD\nEEE\n";
+  ASSERT_EQ(write(fd, fill.data(), fill.size()), 10);
+  EXPECT_TRUE(nbfs.readLines(lines, 2).ok());
+  EXPECT_EQ(std::vector<std::string_view>({"CCC", "DDD"}), lines);
+
+  // Lines beyond the maximum stay buffered.
+  EXPECT_TRUE(nbfs.readLines(lines, 2).ok());
+  EXPECT_EQ(std::vector<std::string_view>({"EEE"}), lines);
+
+  // A line that overflows the buffer is dropped entirely.
+  auto overflows = getSyslogPublisherStats().overflowed_lines.load();
+  fill = std::string(30, 'A') + "\nFFF\n";
+  ASSERT_EQ(write(fd, fill.data(), fill.size()), 35);
+  EXPECT_TRUE(nbfs.readLines(lines, 10).ok());
+  EXPECT_EQ(std::vector<std::string_view>({"FFF"}), lines);
+  EXPECT_EQ(overflows + 1, getSyslogPublisherStats().overflowed_lines.load());
+
+  close(fd);
+}
+
+TEST_F(SyslogTests, test_nonblockingfstream_socket) {
+  auto socket_path = (test_working_dir_ / "socket").string();
+
+  NonBlockingFStream nbfs(1024);
+  ASSERT_TRUE(nbfs.openSocket(socket_path).ok());
+  EXPECT_FALSE(nbfs.openSocket(socket_path).ok());
+
+  auto fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  ASSERT_GE(fd, 0);
+  struct sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
+  socket_path.copy(addr.sun_path, socket_path.size());
+  ASSERT_EQ(
+      connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+
+  // Each datagram is a line, with or without a trailing newline.
+  for (const std::string message : {"AAA", "BBB\n", "CCC"}) {
+    ASSERT_EQ(send(fd, message.data(), message.size(), 0),
+              static_cast<ssize_t>(message.size()));
+  }
+
+  std::vector<std::string_view> lines;
+  EXPECT_TRUE(nbfs.readLines(lines, 10).ok());
+  EXPECT_EQ(std::vector<std::string_view>({"AAA", "BBB", "CCC"}), lines);
+
+  EXPECT_TRUE(nbfs.readLines(lines, 10).ok());
+  EXPECT_TRUE(lines.empty());
+
+  // A datagram larger than the buffer is dropped.
+  auto overflows = getSyslogPublisherStats().overflowed_lines.load();
+  std::string large(2048, 'A');
+  ASSERT_EQ(send(fd, large.data(), large.size(), 0),
+            static_cast<ssize_t>(large.size()));
+  ASSERT_EQ(send(fd, "DDD", 3, 0), 3);
+  EXPECT_TRUE(nbfs.readLines(lines, 10).ok());
+  EXPECT_EQ(std::vector<std::string_view>({"DDD"}), lines);
+  EXPECT_EQ(overflows + 1, getSyslogPublisherStats().overflowed_lines.load());
+
+  close(fd);
+  nbfs.close();
+}
+
+TEST_F(SyslogTests, test_populate_row) {
   std::string line =
       R"|("2016-03-22T21:17:01.701882+00:00","vagrant-ubuntu-trusty-64","6","cron","CRON[16538]:"," (root) CMD (   cd / && run-parts --report /etc/cron.hourly)")|";
   SyslogEventPublisher pub;
-  auto ec = pub.createEventContext();
-  Status status = pub.populateEventContext(line, ec);
+  Row row;
+  Status status = pub.populateRow(line, row);
 
   ASSERT_TRUE(status.ok());
   // Note: the time-parsing was removed to allow events to auto-assign.
-  ASSERT_EQ(0U, ec->time);
-  ASSERT_EQ("2016-03-22T21:17:01.701882+00:00", ec->fields.at("datetime"));
-  ASSERT_EQ("vagrant-ubuntu-trusty-64", ec->fields.at("host"));
-  ASSERT_EQ("6", ec->fields.at("severity"));
-  ASSERT_EQ("cron", ec->fields.at("facility"));
-  ASSERT_EQ("CRON[16538]", ec->fields.at("tag"));
+  ASSERT_EQ("2016-03-22T21:17:01.701882+00:00", row.at("datetime"));
+  ASSERT_EQ("vagrant-ubuntu-trusty-64", row.at("host"));
+  ASSERT_EQ("6", row.at("severity"));
+  ASSERT_EQ("cron", row.at("facility"));
+  ASSERT_EQ("CRON[16538]", row.at("tag"));
   ASSERT_EQ("(root) CMD (   cd / && run-parts --report /etc/cron.hourly)",
-            ec->fields.at("message"));
+            row.at("message"));
 
   // Too few fields
 
   std::string bad_line =
       R"("2016-03-22T21:17:01.701882+00:00","vagrant-ubuntu-trusty-64","6","cron",)";
-  ec = pub.createEventContext();
-  status = pub.populateEventContext(bad_line, ec);
+  row.clear();
+  status = pub.populateRow(bad_line, row);
   ASSERT_FALSE(status.ok());
   ASSERT_NE(std::string::npos, status.getMessage().find("fewer"));
 
   // Too many fields
   bad_line = R"("2016-03-22T21:17:01.701882+00:00","","6","","","","")";
-  ec = pub.createEventContext();
-  status = pub.populateEventContext(bad_line, ec);
+  row.clear();
+  status = pub.populateRow(bad_line, row);
   ASSERT_FALSE(status.ok());
   ASSERT_NE(std::string::npos, status.getMessage().find("more"));
 }
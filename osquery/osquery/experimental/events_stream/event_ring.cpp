@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+#include <cstdint>
+
+#include <osquery/experimental/events_stream/event_ring.h>
+
+namespace osquery {
+namespace events {
+
+namespace {
+
+std::size_t roundUpToPowerOfTwo(std::size_t value) {
+  std::size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+} // namespace
+
+EventRing::EventRing(std::size_t capacity) {
+  auto size = roundUpToPowerOfTwo(std::max<std::size_t>(capacity, 2));
+  slots_.reset(new Slot[size]);
+  mask_ = size - 1;
+
+  // A slot is free for the push at the position equal to its sequence.
+  for (std::size_t i = 0; i < size; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool EventRing::push(std::string&& event) {
+  auto position = tail_.load(std::memory_order_relaxed);
+  Slot* slot = nullptr;
+  while (true) {
+    slot = &slots_[position & mask_];
+    auto sequence = slot->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<std::intptr_t>(sequence) -
+                static_cast<std::intptr_t>(position);
+    if (diff == 0) {
+      if (tail_.compare_exchange_weak(
+              position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The slot still holds the event of the previous lap.
+      return false;
+    } else {
+      position = tail_.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->event = std::move(event);
+  slot->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool EventRing::pop(std::string& event) {
+  auto position = head_.load(std::memory_order_relaxed);
+  Slot* slot = nullptr;
+  while (true) {
+    slot = &slots_[position & mask_];
+    auto sequence = slot->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<std::intptr_t>(sequence) -
+                static_cast<std::intptr_t>(position + 1);
+    if (diff == 0) {
+      if (head_.compare_exchange_weak(
+              position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      position = head_.load(std::memory_order_relaxed);
+    }
+  }
+
+  event = std::move(slot->event);
+  std::string().swap(slot->event);
+  slot->sequence.store(position + mask_ + 1, std::memory_order_release);
+  return true;
+}
+
+std::size_t EventRing::capacity() const {
+  return mask_ + 1;
+}
+
+std::size_t EventRing::size() const {
+  auto tail = tail_.load(std::memory_order_relaxed);
+  auto head = head_.load(std::memory_order_relaxed);
+  return (tail > head) ? tail - head : 0;
+}
+
+} // namespace events
+} // namespace osquery
@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+
+namespace osquery {
+namespace events {
+
+/**
+ * @brief A bounded lock-free queue of serialized events.
+ *
+ * Any number of threads may push and pop concurrently. Each slot carries a
+ * sequence number telling producers and consumers whether it is free, so
+ * neither side takes a lock. The capacity is rounded up to a power of two.
+ */
+class EventRing : private boost::noncopyable {
+ public:
+  explicit EventRing(std::size_t capacity);
+
+  /// Move an event into the ring, the event is untouched if the ring is full.
+  bool push(std::string&& event);
+
+  /// Move the oldest event out of the ring, false if the ring is empty.
+  bool pop(std::string& event);
+
+  /// The number of events the ring holds when full.
+  std::size_t capacity() const;
+
+  /// The approximate number of events in the ring.
+  std::size_t size() const;
+
+ private:
+  struct Slot {
+    std::atomic<std::size_t> sequence{0};
+    std::string event;
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+
+  std::size_t mask_{0};
+
+  /// Position of the next pop, kept apart from the push position.
+  alignas(64) std::atomic<std::size_t> head_{0};
+
+  /// Position of the next push.
+  alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+} // namespace events
+} // namespace osquery
@@ -7,6 +7,12 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
 #include <osquery/experimental/events_stream/events_stream.h>
 #include <osquery/experimental/events_stream/events_stream_registry.h>
 
@@ -14,30 +20,220 @@
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry.h>
 
-#include <boost/io/quoted.hpp>
-
 namespace osquery {
 
 DEFINE_string(events_streaming_plugin,
               "",
               "Experimental events streaming plugin");
 
+FLAG(uint64,
+     events_stream_buffer_size,
+     65536,
+     "Max number of serialized events buffered for the streaming plugin");
+
+FLAG(uint64,
+     events_stream_batch_size,
+     512,
+     "Max number of events written to the streaming plugin at once");
+
+FLAG(uint64,
+     events_stream_flush_ms,
+     100,
+     "Milliseconds between writes of partial event batches");
+
+FLAG(uint64,
+     events_stream_backpressure_ms,
+     0,
+     "Milliseconds an event publisher waits for buffer space before the "
+     "event is dropped");
+
+FLAG(bool,
+     events_stream_only,
+     false,
+     "Stream events without storing them in the database");
+
 namespace events {
 
-void dispatchSerializedEvent(const std::string& serialized_event) {
+namespace {
+
+/// How often a publisher pushed back by a full ring retries.
+const std::chrono::milliseconds kBackpressureSlice{1};
+
+/// Log the count of dropped events once per this many drops.
+const std::uint64_t kDroppedLogInterval{10000};
+
+std::atomic<std::uint64_t> kQueued{0};
+std::atomic<std::uint64_t> kDropped{0};
+std::atomic<std::uint64_t> kWritten{0};
+std::atomic<std::uint64_t> kBatches{0};
+std::atomic<std::uint64_t> kFailed{0};
+
+EventRing& getEventRing() {
+  static EventRing ring(FLAGS_events_stream_buffer_size);
+  return ring;
+}
+
+void startEventsStream() {
+  static std::once_flag once;
+  std::call_once(once, []() {
+    Dispatcher::addService(
+        std::make_shared<EventsStreamRunner>(getEventRing()));
+  });
+}
+
+} // namespace
+
+void dispatchSerializedEvent(const std::string& event) {
+  dispatchSerializedEvent(std::string(event));
+}
+
+void dispatchSerializedEvent(std::string&& event) {
   if (FLAGS_events_streaming_plugin.empty()) {
-    LOG(INFO) << "New event: " << serialized_event;
+    LOG(INFO) << "New event: " << event;
+    return;
+  }
+
+  startEventsStream();
+  auto& ring = getEventRing();
+  if (ring.push(std::move(event))) {
+    kQueued++;
     return;
   }
-  auto status = Registry::call(streamRegistryName(),
-                               FLAGS_events_streaming_plugin,
-                               {
-                                   {"event", serialized_event},
-                               });
+
+  // Push back on the publisher while the runner makes room.
+  auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(FLAGS_events_stream_backpressure_ms);
+  while (std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(kBackpressureSlice);
+    if (ring.push(std::move(event))) {
+      kQueued++;
+      return;
+    }
+  }
+
+  auto dropped = kDropped++;
+  if (dropped % kDroppedLogInterval == 0) {
+    LOG(WARNING) << "Events stream buffer is full, " << dropped + 1
+                 << " events dropped";
+  }
+}
+
+bool isEventsStreamEnabled() {
+  return !FLAGS_events_streaming_plugin.empty();
+}
+
+bool isEventsStreamOnly() {
+  return FLAGS_events_stream_only && isEventsStreamEnabled();
+}
+
+EventsStreamStats getEventsStreamStats() {
+  EventsStreamStats stats;
+  stats.queued = kQueued;
+  stats.dropped = kDropped;
+  stats.written = kWritten;
+  stats.batches = kBatches;
+  stats.failed = kFailed;
+  return stats;
+}
+
+EventsStreamRunner::EventsStreamRunner(EventRing& ring)
+    : InternalRunnable("EventsStreamRunner"), ring_(ring) {}
+
+void EventsStreamRunner::start() {
+  auto batch_size = std::max<std::uint64_t>(FLAGS_events_stream_batch_size, 1);
+  while (!interrupted()) {
+    // Full batches are written back to back until the ring is drained.
+    auto written = flush();
+    recordStats();
+    if (written < batch_size) {
+      pause(std::chrono::milliseconds(FLAGS_events_stream_flush_ms));
+    }
+  }
+
+  // Drain the ring on shutdown, a failing plugin is not retried.
+  while (flush() > 0) {
+  }
+  recordStats();
+}
+
+std::size_t EventsStreamRunner::flush() {
+  auto batch_size = std::max<std::uint64_t>(FLAGS_events_stream_batch_size, 1);
+  std::string event;
+  while (batch_.size() < batch_size && ring_.pop(event)) {
+    batch_.push_back(std::move(event));
+  }
+
+  if (batch_.empty()) {
+    return 0;
+  }
+
+  // Events the plugin accepted before a failure are not written again.
+  std::size_t written = 0;
+  auto status = write(batch_, written);
+  written = std::min(written, batch_.size());
+  kWritten += written;
+  batch_.erase(batch_.begin(), batch_.begin() + written);
   if (!status.ok()) {
-    LOG(ERROR) << "Data loss. Event " << boost::io::quoted(serialized_event)
-               << " dispatch failed because " << status.what();
+    kFailed++;
+    VLOG(1) << "Cannot write " << batch_.size()
+            << " streamed events: " << status.getMessage();
+    return written;
   }
+
+  kBatches++;
+  return written;
+}
+
+Status EventsStreamRunner::write(const std::vector<std::string>& batch,
+                                 std::size_t& written) {
+  auto plugin = Registry::get().plugin(streamRegistryName(),
+                                       FLAGS_events_streaming_plugin);
+  auto stream = std::dynamic_pointer_cast<EventsStreamPlugin>(plugin);
+  if (stream != nullptr) {
+    return stream->write(batch, written);
+  }
+
+  // Plugins of extensions are called through the registry, one at a time.
+  for (written = 0; written < batch.size(); ++written) {
+    auto status = Registry::call(streamRegistryName(),
+                                 FLAGS_events_streaming_plugin,
+                                 {
+                                     {"event", batch[written]},
+                                 });
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return Status::success();
+}
+
+void EventsStreamRunner::recordStats() {
+  auto stats = getEventsStreamStats();
+  if (stats.queued == recorded_.queued && stats.written == recorded_.written &&
+      stats.dropped == recorded_.dropped && stats.failed == recorded_.failed) {
+    return;
+  }
+
+  monitoring::record("events_stream.queued",
+                     stats.queued - recorded_.queued,
+                     monitoring::PreAggregationType::Sum);
+  monitoring::record("events_stream.dropped",
+                     stats.dropped - recorded_.dropped,
+                     monitoring::PreAggregationType::Sum);
+  monitoring::record("events_stream.written",
+                     stats.written - recorded_.written,
+                     monitoring::PreAggregationType::Sum);
+  monitoring::record("events_stream.batches",
+                     stats.batches - recorded_.batches,
+                     monitoring::PreAggregationType::Sum);
+  monitoring::record("events_stream.failed",
+                     stats.failed - recorded_.failed,
+                     monitoring::PreAggregationType::Sum);
+  monitoring::record("events_stream.buffered",
+                     ring_.size(),
+                     monitoring::PreAggregationType::Max);
+  recorded_ = stats;
 }
 
 } // namespace events
@@ -9,12 +9,89 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
+
+#include <osquery/dispatcher/dispatcher.h>
+#include <osquery/experimental/events_stream/event_ring.h>
 
 namespace osquery {
 namespace events {
 
+/// Counters of the events stream since it was started.
+struct EventsStreamStats {
+  /// Events accepted into the ring.
+  std::uint64_t queued{0};
+
+  /// Events dropped because the ring stayed full.
+  std::uint64_t dropped{0};
+
+  /// Events written to the streaming plugin.
+  std::uint64_t written{0};
+
+  /// Batches written to the streaming plugin.
+  std::uint64_t batches{0};
+
+  /// Failed batch writes, the unwritten events are retried.
+  std::uint64_t failed{0};
+};
+
+/**
+ * @brief Queue a serialized event for the streaming plugin.
+ *
+ * The event is written by the EventsStreamRunner in a later batch. If the
+ * ring is full the caller waits up to events_stream_backpressure_ms for room,
+ * then the event is dropped and counted.
+ */
 void dispatchSerializedEvent(const std::string& event);
 
+/// Queue a serialized event for the streaming plugin without copying it.
+void dispatchSerializedEvent(std::string&& event);
+
+/// Return true if an events streaming plugin is configured.
+bool isEventsStreamEnabled();
+
+/// Return true if events are streamed instead of stored in the database.
+bool isEventsStreamOnly();
+
+/// Return the counters of the events stream.
+EventsStreamStats getEventsStreamStats();
+
+/**
+ * @brief Drains the event ring into the streaming plugin.
+ *
+ * Events are written in batches of up to events_stream_batch_size. Events a
+ * failed write did not deliver are kept and retried, those it did deliver are
+ * not written again. New events wait in the ring meanwhile. Once the ring is
+ * full publishers are pushed back, then events are dropped.
+ */
+class EventsStreamRunner : public InternalRunnable {
+ public:
+  explicit EventsStreamRunner(EventRing& ring);
+
+  /// Flush batches until interrupted, then drain the ring once more.
+  void start() override;
+
+  /// Write one batch, returns the number of events written.
+  std::size_t flush();
+
+ private:
+  /// Write a batch to the configured streaming plugin, counting the delivered.
+  Status write(const std::vector<std::string>& batch, std::size_t& written);
+
+  /// Record the counters since the last call as monitoring points.
+  void recordStats();
+
+ private:
+  EventRing& ring_;
+
+  /// The batch being written, kept until the plugin accepts it.
+  std::vector<std::string> batch_;
+
+  /// The counters reported by the last recordStats.
+  EventsStreamStats recorded_;
+};
+
 } // namespace events
 } // namespace osquery
@@ -23,6 +23,18 @@ Status EventsStreamPlugin::call(const PluginRequest& request,
   return Status::success();
 }
 
+Status EventsStreamPlugin::write(const std::vector<std::string>& events,
+                                 std::size_t& written) {
+  PluginResponse response;
+  for (written = 0; written < events.size(); ++written) {
+    auto status = call({{"event", events[written]}}, response);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return Status::success();
+}
+
 namespace events {
 
 char const* streamRegistryName() {
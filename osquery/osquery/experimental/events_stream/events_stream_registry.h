@@ -9,6 +9,10 @@
 
 #pragma once
 
+#include <cstddef>
+#include <string>
+#include <vector>
+
 #include <osquery/core/plugins/plugin.h>
 #include <osquery/core/query.h>
 #include <osquery/utils/expected/expected.h>
@@ -17,9 +21,27 @@
 
 namespace osquery {
 
+/**
+ * @brief A destination for streamed events.
+ *
+ * Plugins receive batches of serialized events through write. Plugins of
+ * extensions are called with one "event" per request instead.
+ */
 class EventsStreamPlugin : public Plugin {
  public:
   Status call(const PluginRequest& request, PluginResponse& response) override;
+
+  /**
+   * @brief Write a batch of serialized events.
+   *
+   * The default calls call once per event.
+   *
+   * @param events The serialized events, in order.
+   * @param written Set to the number of leading events that were written,
+   * also on failure. Only the remaining events are retried.
+   */
+  virtual Status write(const std::vector<std::string>& events,
+                       std::size_t& written);
 };
 
 namespace events {
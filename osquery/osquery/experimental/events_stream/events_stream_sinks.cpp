@@ -0,0 +1,242 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifndef WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <osquery/experimental/events_stream/events_stream_sinks.h>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/registry/registry_factory.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+FLAG(string,
+     events_stream_path,
+     "",
+     "Path of the file or UNIX domain socket of the file and unix_socket "
+     "events streaming plugins");
+
+REGISTER(StdoutEventsStreamPlugin, "osquery_events_stream", "stdout");
+REGISTER(FileEventsStreamPlugin, "osquery_events_stream", "file");
+
+#ifndef WIN32
+REGISTER(UnixSocketEventsStreamPlugin, "osquery_events_stream", "unix_socket");
+#endif
+
+namespace {
+
+/// Join a batch into one newline-delimited buffer, written at once.
+std::string joinEvents(const std::vector<std::string>& events) {
+  std::size_t size = 0;
+  for (const auto& event : events) {
+    size += event.size() + 1;
+  }
+
+  std::string buffer;
+  buffer.reserve(size);
+  for (const auto& event : events) {
+    buffer += event;
+    buffer += '\n';
+  }
+  return buffer;
+}
+
+/// Return the number of leading events fully contained in the first bytes.
+std::size_t countWritten(const std::vector<std::string>& events,
+                         std::size_t bytes) {
+  std::size_t written = 0;
+  for (const auto& event : events) {
+    if (bytes < event.size() + 1) {
+      break;
+    }
+    bytes -= event.size() + 1;
+    ++written;
+  }
+  return written;
+}
+
+/// Requests of the registry carry a single event.
+Status writeRequest(EventsStreamPlugin& plugin, const PluginRequest& request) {
+  auto it = request.find("event");
+  if (it == request.end()) {
+    return Status::failure("Missing event");
+  }
+  std::size_t written = 0;
+  return plugin.write({it->second}, written);
+}
+
+} // namespace
+
+Status StdoutEventsStreamPlugin::call(const PluginRequest& request,
+                                      PluginResponse& response) {
+  return writeRequest(*this, request);
+}
+
+Status StdoutEventsStreamPlugin::write(const std::vector<std::string>& events,
+                                       std::size_t& written) {
+  auto buffer = joinEvents(events);
+  auto bytes = std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+  if (bytes != buffer.size() || std::fflush(stdout) != 0) {
+    written = countWritten(events, bytes);
+    return Status::failure("Cannot write events to stdout");
+  }
+  written = events.size();
+  return Status::success();
+}
+
+Status FileEventsStreamPlugin::call(const PluginRequest& request,
+                                    PluginResponse& response) {
+  return writeRequest(*this, request);
+}
+
+Status FileEventsStreamPlugin::write(const std::vector<std::string>& events,
+                                     std::size_t& written) {
+  written = 0;
+  if (FLAGS_events_stream_path.empty()) {
+    return Status::failure("No events_stream_path for the file plugin");
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!output_.is_open()) {
+    output_.open(FLAGS_events_stream_path,
+                 std::ios::out | std::ios::app | std::ios::binary);
+    if (!output_.is_open()) {
+      return Status::failure("Cannot open " + FLAGS_events_stream_path);
+    }
+  }
+
+  // The size before the batch, a partial write is truncated back to it.
+  boost::system::error_code ec;
+  auto size = fs::file_size(FLAGS_events_stream_path, ec);
+
+  auto buffer = joinEvents(events);
+  output_.write(buffer.data(), buffer.size());
+  output_.flush();
+  if (!output_.good()) {
+    // Reopen the file on the next write.
+    output_.close();
+    output_.clear();
+    if (!ec) {
+      fs::resize_file(FLAGS_events_stream_path, size, ec);
+    }
+    return Status::failure("Cannot write events to " +
+                           FLAGS_events_stream_path);
+  }
+  written = events.size();
+  return Status::success();
+}
+
+#ifndef WIN32
+
+UnixSocketEventsStreamPlugin::~UnixSocketEventsStreamPlugin() {
+  disconnect();
+}
+
+Status UnixSocketEventsStreamPlugin::call(const PluginRequest& request,
+                                          PluginResponse& response) {
+  return writeRequest(*this, request);
+}
+
+Status UnixSocketEventsStreamPlugin::write(
+    const std::vector<std::string>& events, std::size_t& written) {
+  written = 0;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (socket_ < 0) {
+    auto status = connect();
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  auto buffer = joinEvents(events);
+  std::size_t sent = 0;
+  while (sent < buffer.size()) {
+#ifdef MSG_NOSIGNAL
+    auto bytes = ::send(
+        socket_, buffer.data() + sent, buffer.size() - sent, MSG_NOSIGNAL);
+#else
+    auto bytes = ::send(socket_, buffer.data() + sent, buffer.size() - sent, 0);
+#endif
+    if (bytes < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes <= 0) {
+      auto error = std::string(std::strerror(errno));
+
+      // Complete lines were received, a torn one is resent whole on the
+      // next connection.
+      written = countWritten(events, sent);
+      disconnect();
+      return Status::failure("Cannot write events to " +
+                             FLAGS_events_stream_path + ": " + error);
+    }
+    sent += static_cast<std::size_t>(bytes);
+  }
+  written = events.size();
+  return Status::success();
+}
+
+Status UnixSocketEventsStreamPlugin::connect() {
+  struct sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  if (FLAGS_events_stream_path.empty() ||
+      FLAGS_events_stream_path.size() >= sizeof(address.sun_path)) {
+    return Status::failure("Invalid events_stream_path for the socket plugin");
+  }
+
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path,
+               FLAGS_events_stream_path.c_str(),
+               sizeof(address.sun_path) - 1);
+
+  socket_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (socket_ < 0) {
+    return Status::failure("Cannot create socket: " +
+                           std::string(std::strerror(errno)));
+  }
+
+#ifdef SO_NOSIGPIPE
+  int enable = 1;
+  ::setsockopt(socket_, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+
+  if (::connect(socket_,
+                reinterpret_cast<struct sockaddr*>(&address),
+                sizeof(address)) != 0) {
+    auto error = std::string(std::strerror(errno));
+    disconnect();
+    return Status::failure("Cannot connect to " + FLAGS_events_stream_path +
+                           ": " + error);
+  }
+  return Status::success();
+}
+
+void UnixSocketEventsStreamPlugin::disconnect() {
+  if (socket_ >= 0) {
+    ::close(socket_);
+    socket_ = -1;
+  }
+}
+
+#endif
+
+} // namespace osquery
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <osquery/experimental/events_stream/events_stream_registry.h>
+
+namespace osquery {
+
+/// Writes streamed events to standard output, one per line.
+class StdoutEventsStreamPlugin : public EventsStreamPlugin {
+ public:
+  Status call(const PluginRequest& request, PluginResponse& response) override;
+
+  Status write(const std::vector<std::string>& events,
+               std::size_t& written) override;
+};
+
+/**
+ * @brief Appends streamed events to the events_stream_path file, one per line.
+ *
+ * A failed write truncates the file back to its size before the batch, so
+ * the retried events are neither duplicated nor torn.
+ */
+class FileEventsStreamPlugin : public EventsStreamPlugin {
+ public:
+  Status call(const PluginRequest& request, PluginResponse& response) override;
+
+  Status write(const std::vector<std::string>& events,
+               std::size_t& written) override;
+
+ private:
+  std::mutex mutex_;
+
+  std::ofstream output_;
+};
+
+#ifndef WIN32
+
+/**
+ * @brief Writes streamed events to a UNIX domain socket, one per line.
+ *
+ * The plugin connects to the stream socket at events_stream_path on the
+ * first write, and again after a failed write. An event cut short by a
+ * failed send is sent again, whole, on the next connection.
+ */
+class UnixSocketEventsStreamPlugin : public EventsStreamPlugin {
+ public:
+  ~UnixSocketEventsStreamPlugin() override;
+
+  Status call(const PluginRequest& request, PluginResponse& response) override;
+
+  Status write(const std::vector<std::string>& events,
+               std::size_t& written) override;
+
+ private:
+  Status connect();
+
+  void disconnect();
+
+ private:
+  std::mutex mutex_;
+
+  int socket_{-1};
+};
+
+#endif
+
+} // namespace osquery
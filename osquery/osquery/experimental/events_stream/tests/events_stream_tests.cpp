@@ -0,0 +1,271 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#ifndef WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/experimental/events_stream/event_ring.h>
+#include <osquery/experimental/events_stream/events_stream.h>
+#include <osquery/experimental/events_stream/events_stream_registry.h>
+#include <osquery/experimental/events_stream/events_stream_sinks.h>
+#include <osquery/filesystem/filesystem.h>
+#include <osquery/registry/registry.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+DECLARE_string(events_streaming_plugin);
+DECLARE_string(events_stream_path);
+DECLARE_uint64(events_stream_batch_size);
+
+namespace events {
+
+/// Fails the first write after delivering some events, then records batches.
+class MockEventsStreamPlugin : public EventsStreamPlugin {
+ public:
+  Status write(const std::vector<std::string>& events,
+               std::size_t& written) override {
+    if (fail_next) {
+      fail_next = false;
+      written = std::min(deliver_first, events.size());
+      delivered.insert(
+          delivered.end(), events.begin(), events.begin() + written);
+      return Status::failure("Unavailable");
+    }
+    batches.push_back(events);
+    delivered.insert(delivered.end(), events.begin(), events.end());
+    written = events.size();
+    return Status::success();
+  }
+
+  bool fail_next{true};
+
+  /// Events delivered by the failing write.
+  std::size_t deliver_first{0};
+
+  std::vector<std::vector<std::string>> batches;
+
+  std::vector<std::string> delivered;
+};
+
+class EventsStreamTests : public testing::Test {
+ public:
+  EventsStreamTests()
+      : path_(fs::temp_directory_path() /
+              fs::unique_path("osquery.events_stream.%%%%.%%%%")) {}
+
+  void SetUp() override {
+    registryAndPluginInit();
+    plugin_ = FLAGS_events_streaming_plugin;
+    stream_path_ = FLAGS_events_stream_path;
+    batch_size_ = FLAGS_events_stream_batch_size;
+  }
+
+  void TearDown() override {
+    FLAGS_events_streaming_plugin = plugin_;
+    FLAGS_events_stream_path = stream_path_;
+    FLAGS_events_stream_batch_size = batch_size_;
+    fs::remove(path_);
+  }
+
+ protected:
+  fs::path path_;
+
+ private:
+  std::string plugin_;
+  std::string stream_path_;
+  std::uint64_t batch_size_;
+};
+
+TEST_F(EventsStreamTests, test_ring) {
+  EventRing ring(5);
+  EXPECT_EQ(8U, ring.capacity());
+
+  for (size_t i = 0; i < ring.capacity(); ++i) {
+    EXPECT_TRUE(ring.push(std::to_string(i)));
+  }
+  EXPECT_EQ(8U, ring.size());
+
+  // A full ring leaves the event with the caller.
+  std::string event = "overflow";
+  EXPECT_FALSE(ring.push(std::move(event)));
+  EXPECT_EQ("overflow", event);
+
+  for (size_t i = 0; i < ring.capacity(); ++i) {
+    ASSERT_TRUE(ring.pop(event));
+    EXPECT_EQ(std::to_string(i), event);
+  }
+  EXPECT_FALSE(ring.pop(event));
+  EXPECT_EQ(0U, ring.size());
+}
+
+TEST_F(EventsStreamTests, test_ring_concurrent) {
+  EventRing ring(1024);
+  const size_t kProducers = 4;
+  const size_t kEvents = 20000;
+
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&ring, p, kEvents]() {
+      for (size_t i = 0; i < kEvents; ++i) {
+        auto event = std::to_string(p * kEvents + i);
+        while (!ring.push(std::move(event))) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // Every event is popped exactly once.
+  std::vector<bool> seen(kProducers * kEvents, false);
+  size_t popped = 0;
+  std::string event;
+  while (popped < seen.size()) {
+    if (!ring.pop(event)) {
+      std::this_thread::yield();
+      continue;
+    }
+    auto index = std::stoul(event);
+    ASSERT_LT(index, seen.size());
+    EXPECT_FALSE(seen[index]);
+    seen[index] = true;
+    ++popped;
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  EXPECT_FALSE(ring.pop(event));
+}
+
+TEST_F(EventsStreamTests, test_runner_retry) {
+  auto plugin = std::make_shared<MockEventsStreamPlugin>();
+  Registry::get().registry(streamRegistryName())->add("mock", plugin);
+  FLAGS_events_streaming_plugin = "mock";
+  FLAGS_events_stream_batch_size = 2;
+
+  EventRing ring(8);
+  EventsStreamRunner runner(ring);
+  for (const auto& event : {"a", "b", "c"}) {
+    ASSERT_TRUE(ring.push(event));
+  }
+
+  // The failed batch is kept and written first on the next flush.
+  EXPECT_EQ(0U, runner.flush());
+  EXPECT_TRUE(plugin->batches.empty());
+  EXPECT_EQ(2U, runner.flush());
+  EXPECT_EQ(1U, runner.flush());
+  EXPECT_EQ(0U, runner.flush());
+
+  ASSERT_EQ(2U, plugin->batches.size());
+  EXPECT_EQ(std::vector<std::string>({"a", "b"}), plugin->batches[0]);
+  EXPECT_EQ(std::vector<std::string>({"c"}), plugin->batches[1]);
+}
+
+TEST_F(EventsStreamTests, test_runner_partial_retry) {
+  auto plugin = std::make_shared<MockEventsStreamPlugin>();
+  plugin->deliver_first = 2;
+  Registry::get().registry(streamRegistryName())->add("mock_partial", plugin);
+  FLAGS_events_streaming_plugin = "mock_partial";
+  FLAGS_events_stream_batch_size = 3;
+
+  EventRing ring(8);
+  EventsStreamRunner runner(ring);
+  for (const auto& event : {"a", "b", "c", "d"}) {
+    ASSERT_TRUE(ring.push(event));
+  }
+  auto written = getEventsStreamStats().written;
+
+  // Events delivered before the failure are not written again.
+  EXPECT_EQ(2U, runner.flush());
+  EXPECT_EQ(2U, runner.flush());
+  EXPECT_EQ(0U, runner.flush());
+
+  ASSERT_EQ(1U, plugin->batches.size());
+  EXPECT_EQ(std::vector<std::string>({"c", "d"}), plugin->batches[0]);
+  EXPECT_EQ(std::vector<std::string>({"a", "b", "c", "d"}), plugin->delivered);
+  EXPECT_EQ(4U, getEventsStreamStats().written - written);
+}
+
+TEST_F(EventsStreamTests, test_file_plugin) {
+  FLAGS_events_streaming_plugin = "file";
+  FLAGS_events_stream_path = path_.string();
+
+  EventRing ring(8);
+  EventsStreamRunner runner(ring);
+  ring.push("{\"a\":1}");
+  ring.push("{\"b\":2}");
+  EXPECT_EQ(2U, runner.flush());
+  ring.push("{\"c\":3}");
+  EXPECT_EQ(1U, runner.flush());
+
+  std::string content;
+  ASSERT_TRUE(readFile(path_, content).ok());
+  EXPECT_EQ("{\"a\":1}\n{\"b\":2}\n{\"c\":3}\n", content);
+}
+
+#ifndef WIN32
+TEST_F(EventsStreamTests, test_unix_socket_plugin) {
+  FLAGS_events_stream_path = path_.string();
+
+  // Without a listener the write fails and the plugin reconnects later.
+  UnixSocketEventsStreamPlugin plugin;
+  std::size_t written = 1;
+  EXPECT_FALSE(plugin.write({"{\"a\":1}"}, written).ok());
+  EXPECT_EQ(0U, written);
+
+  int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_GE(listener, 0);
+  struct sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::strncpy(
+      address.sun_path, path_.string().c_str(), sizeof(address.sun_path) - 1);
+  ASSERT_EQ(0,
+            ::bind(listener,
+                   reinterpret_cast<struct sockaddr*>(&address),
+                   sizeof(address)));
+  ASSERT_EQ(0, ::listen(listener, 1));
+
+  EXPECT_TRUE(plugin.write({"{\"a\":1}", "{\"b\":2}"}, written).ok());
+  EXPECT_EQ(2U, written);
+
+  int connection = ::accept(listener, nullptr, nullptr);
+  ASSERT_GE(connection, 0);
+  std::string expected = "{\"a\":1}\n{\"b\":2}\n";
+  std::string received;
+  char buffer[64];
+  while (received.size() < expected.size()) {
+    auto bytes = ::read(connection, buffer, sizeof(buffer));
+    ASSERT_GT(bytes, 0);
+    received.append(buffer, bytes);
+  }
+  EXPECT_EQ(expected, received);
+
+  ::close(connection);
+  ::close(listener);
+}
+#endif
+
+} // namespace events
+} // namespace osquery
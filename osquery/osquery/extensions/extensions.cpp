@@ -40,6 +40,7 @@ namespace osquery {
 
 enum class ExtendableType {
   EXTENSION = 1,
+  MODULE = 2,
 };
 
 using ExtendableTypeSet = std::map<ExtendableType, std::set<std::string>>;
@@ -49,9 +50,14 @@ namespace {
 /// Map of acceptable file extensions for extension binaries.
 const std::map<PlatformType, ExtendableTypeSet> kFileExtensions{
     {PlatformType::TYPE_WINDOWS,
-     {{ExtendableType::EXTENSION, {".exe", ".ext"}}}},
-    {PlatformType::TYPE_LINUX, {{ExtendableType::EXTENSION, {".ext"}}}},
-    {PlatformType::TYPE_OSX, {{ExtendableType::EXTENSION, {".ext"}}}},
+     {{ExtendableType::EXTENSION, {".exe", ".ext"}},
+      {ExtendableType::MODULE, {".dll"}}}},
+    {PlatformType::TYPE_LINUX,
+     {{ExtendableType::EXTENSION, {".ext"}},
+      {ExtendableType::MODULE, {".so"}}}},
+    {PlatformType::TYPE_OSX,
+     {{ExtendableType::EXTENSION, {".ext"}},
+      {ExtendableType::MODULE, {".dylib"}}}},
 };
 
 /// Millisecond latency between initializing manager pings.
@@ -88,6 +94,13 @@ CLI_FLAG(string,
          "",
          "Comma-separated list of required extensions");
 
+CLI_FLAG(string,
+         modules_autoload,
+         OSQUERY_HOME "modules.load",
+         "Optional path to a list of autoloaded native table modules");
+
+SHELL_FLAG(string, module, "", "Path to a single native module to autoload");
+
 /**
  * @brief Alias the extensions_socket (used by core) to a simple 'socket'.
  *
@@ -439,18 +452,22 @@ static bool isFileSafe(std::string& path, ExtendableType type) {
   return true;
 }
 
-std::set<std::string> loadExtensions(const std::string& loadfile) {
+static std::set<std::string> loadExtendables(const std::string& loadfile,
+                                             const std::string& single_path,
+                                             ExtendableType type) {
   std::set<std::string> autoload_binaries;
-  if (!FLAGS_extension.empty()) {
+  if (!single_path.empty()) {
     // This is a shell-only development flag for quickly loading/using a single
-    // extension. It bypasses the safety check.
-    autoload_binaries.insert(FLAGS_extension);
+    // extension or module. It bypasses the safety check.
+    autoload_binaries.insert(single_path);
   }
 
   std::string autoload_paths;
   auto status = readFile(loadfile, autoload_paths);
   if (!status.ok()) {
-    VLOG(1) << "Could not autoload extensions: " << status.what();
+    VLOG(1) << "Could not autoload "
+            << ((type == ExtendableType::EXTENSION) ? "extensions" : "modules")
+            << ": " << status.what();
   }
 
   // The set of binaries to auto-load, after safety is confirmed.
@@ -459,11 +476,11 @@ std::set<std::string> loadExtensions(const std::string& loadfile) {
       std::vector<std::string> paths;
       listFilesInDirectory(path, paths, true);
       for (auto& embedded_path : paths) {
-        if (isFileSafe(embedded_path, ExtendableType::EXTENSION)) {
+        if (isFileSafe(embedded_path, type)) {
           autoload_binaries.insert(std::move(embedded_path));
         }
       }
-    } else if (isFileSafe(path, ExtendableType::EXTENSION)) {
+    } else if (isFileSafe(path, type)) {
       autoload_binaries.insert(path);
     }
   }
@@ -471,6 +488,24 @@ std::set<std::string> loadExtensions(const std::string& loadfile) {
   return autoload_binaries;
 }
 
+std::set<std::string> loadExtensions(const std::string& loadfile) {
+  return loadExtendables(loadfile, FLAGS_extension, ExtendableType::EXTENSION);
+}
+
+std::set<std::string> loadModules() {
+  // Modules are managed like extensions and are disabled with them.
+  if (FLAGS_disable_extensions) {
+    return {};
+  }
+
+  return loadModules(
+      fs::path(FLAGS_modules_autoload).make_preferred().string());
+}
+
+std::set<std::string> loadModules(const std::string& loadfile) {
+  return loadExtendables(loadfile, FLAGS_module, ExtendableType::MODULE);
+}
+
 Status startExtension(const std::string& name, const std::string& version) {
   return startExtension(name, version, "0.0.0");
 }
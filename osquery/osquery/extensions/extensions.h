@@ -100,6 +100,23 @@ std::set<std::string> loadExtensions();
  */
 std::set<std::string> loadExtensions(const std::string& loadfile);
 
+/**
+ * @brief Read the module autoload flags and return a set of module paths.
+ *
+ * Native modules are shared libraries whose tables run inside the process
+ * executing queries, see osquery/extensions/native_table.h. They are listed in the
+ * `modules_autoload` file and are subject to the same safety checks as
+ * autoloaded extensions.
+ */
+std::set<std::string> loadModules();
+
+/**
+ * @brief Load modules from a specific search path.
+ *
+ * @param loadfile Path to file containing newline delimited file paths.
+ */
+std::set<std::string> loadModules(const std::string& loadfile);
+
 /**
  * @brief Initialize the extensions socket path variable for osqueryi.
  *
@@ -0,0 +1,436 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <map>
+#include <memory>
+#include <utility>
+
+#include <osquery/extensions/extensions.h>
+#include <osquery/extensions/native_modules.h>
+#include <osquery/logger/logger.h>
+#include <osquery/process/process.h>
+#include <osquery/registry/registry_factory.h>
+#include <osquery/utils/json/json.h>
+#include <osquery/utils/mutex.h>
+#include <osquery/utils/scope_guard.h>
+
+/// The query constraints handed to a module scan.
+struct osquery_native_context {
+  osquery::QueryContext* context{nullptr};
+
+  /// Constraint values returned to the module, kept until the scan closes.
+  mutable std::map<std::pair<std::string, int32_t>, std::vector<std::string>>
+      values;
+};
+
+/// The rows added by a module during a single generate call.
+struct osquery_native_batch {
+  const osquery_native_table* table{nullptr};
+  std::vector<osquery::TableRowHolder> rows;
+};
+
+namespace osquery {
+
+namespace {
+
+/// Rows requested from a module per generate call.
+const size_t kNativeBatchRows{1024};
+
+Mutex kNativeModulesMutex;
+std::vector<NativeModuleInfo> kNativeModules;
+
+/// A TableRow holding the typed values produced by a native module.
+class NativeTableRow : public TableRow {
+ public:
+  NativeTableRow(const osquery_native_table* table,
+                 const osquery_native_value* values)
+      : table_(table), values_(table->column_count) {
+    for (size_t i = 0; i < table->column_count; ++i) {
+      auto& value = values_[i];
+      value.is_null = (values[i].is_null != 0);
+      if (value.is_null) {
+        continue;
+      }
+
+      if (table->columns[i].type == OSQUERY_NATIVE_TEXT) {
+        if (values[i].text != nullptr) {
+          value.text.assign(values[i].text, values[i].length);
+        }
+      } else if (table->columns[i].type == OSQUERY_NATIVE_DOUBLE) {
+        value.real = values[i].real;
+      } else {
+        value.integer = values[i].integer;
+      }
+    }
+  }
+
+  int get_rowid(sqlite_int64 default_value,
+                sqlite_int64* pRowid) const override {
+    *pRowid = default_value;
+    return SQLITE_OK;
+  }
+
+  int get_column(sqlite3_context* ctx, sqlite3_vtab* vtab, int col) override {
+    if (col < 0 || static_cast<size_t>(col) >= values_.size() ||
+        values_[col].is_null) {
+      sqlite3_result_null(ctx);
+      return SQLITE_OK;
+    }
+
+    const auto& value = values_[col];
+    switch (table_->columns[col].type) {
+    case OSQUERY_NATIVE_TEXT:
+      sqlite3_result_text(ctx,
+                          value.text.c_str(),
+                          static_cast<int>(value.text.size()),
+                          SQLITE_TRANSIENT);
+      break;
+    case OSQUERY_NATIVE_INTEGER:
+      sqlite3_result_int(ctx, static_cast<int>(value.integer));
+      break;
+    case OSQUERY_NATIVE_BIGINT:
+    case OSQUERY_NATIVE_UNSIGNED_BIGINT:
+      sqlite3_result_int64(ctx, value.integer);
+      break;
+    case OSQUERY_NATIVE_DOUBLE:
+      sqlite3_result_double(ctx, value.real);
+      break;
+    default:
+      sqlite3_result_null(ctx);
+    }
+    return SQLITE_OK;
+  }
+
+  Status serialize(JSON& doc, rapidjson::Value& obj) const override {
+    for (size_t i = 0; i < values_.size(); ++i) {
+      const auto& value = values_[i];
+      if (value.is_null) {
+        continue;
+      }
+
+      const std::string name = table_->columns[i].name;
+      switch (table_->columns[i].type) {
+      case OSQUERY_NATIVE_TEXT:
+        doc.addRef(name, value.text, obj);
+        break;
+      case OSQUERY_NATIVE_UNSIGNED_BIGINT:
+        doc.add(name, static_cast<unsigned long long>(value.integer), obj);
+        break;
+      case OSQUERY_NATIVE_DOUBLE:
+        doc.add(name, value.real, obj);
+        break;
+      default:
+        doc.add(name, static_cast<long long>(value.integer), obj);
+      }
+    }
+    return Status::success();
+  }
+
+  operator Row() const override {
+    Row result;
+    for (size_t i = 0; i < values_.size(); ++i) {
+      const auto& value = values_[i];
+      auto& field = result[table_->columns[i].name];
+      if (value.is_null) {
+        continue;
+      }
+
+      switch (table_->columns[i].type) {
+      case OSQUERY_NATIVE_TEXT:
+        field = value.text;
+        break;
+      case OSQUERY_NATIVE_UNSIGNED_BIGINT:
+        field = UNSIGNED_BIGINT(static_cast<uint64_t>(value.integer));
+        break;
+      case OSQUERY_NATIVE_DOUBLE:
+        field = DOUBLE(value.real);
+        break;
+      default:
+        field = BIGINT(value.integer);
+      }
+    }
+    return result;
+  }
+
+  TableRowHolder clone() const override {
+    return TableRowHolder(new NativeTableRow(*this));
+  }
+
+ private:
+  NativeTableRow(const NativeTableRow&) = default;
+
+  struct Value {
+    bool is_null{true};
+    int64_t integer{0};
+    double real{0};
+    std::string text;
+  };
+
+  const osquery_native_table* table_;
+  std::vector<Value> values_;
+};
+
+size_t nativeConstraintCount(const osquery_native_context* context,
+                             const char* column,
+                             int32_t op) {
+  if (context == nullptr || column == nullptr) {
+    return 0;
+  }
+
+  // The values are cached so returned pointers stay valid during the scan.
+  auto key = std::make_pair(std::string(column), op);
+  auto it = context->values.find(key);
+  if (it == context->values.end()) {
+    std::vector<std::string> values;
+    auto constraints = context->context->constraints.find(column);
+    if (constraints != context->context->constraints.end()) {
+      for (auto& value : constraints->second.getAll(
+               static_cast<ConstraintOperator>(op))) {
+        values.push_back(value);
+      }
+    }
+    it = context->values.emplace(key, std::move(values)).first;
+  }
+  return it->second.size();
+}
+
+const char* nativeConstraintValue(const osquery_native_context* context,
+                                  const char* column,
+                                  int32_t op,
+                                  size_t index) {
+  if (nativeConstraintCount(context, column, op) <= index) {
+    return nullptr;
+  }
+  return context->values.at({column, op})[index].c_str();
+}
+
+int32_t nativeColumnUsed(const osquery_native_context* context,
+                         const char* column) {
+  if (context == nullptr || column == nullptr) {
+    return 0;
+  }
+  return context->context->isColumnUsed(column) ? 1 : 0;
+}
+
+void nativeAddRow(osquery_native_batch* batch,
+                  const osquery_native_value* values) {
+  if (batch == nullptr || values == nullptr) {
+    return;
+  }
+  batch->rows.push_back(
+      TableRowHolder(new NativeTableRow(batch->table, values)));
+}
+
+void nativeLog(int32_t severity, const char* message) {
+  if (message == nullptr) {
+    return;
+  }
+
+  if (severity == OSQUERY_NATIVE_LOG_ERROR) {
+    LOG(ERROR) << message;
+  } else if (severity == OSQUERY_NATIVE_LOG_WARNING) {
+    LOG(WARNING) << message;
+  } else {
+    LOG(INFO) << message;
+  }
+}
+
+const osquery_native_host kNativeHost{
+    OSQUERY_NATIVE_ABI_VERSION,
+    nativeConstraintCount,
+    nativeConstraintValue,
+    nativeColumnUsed,
+    nativeAddRow,
+    nativeLog,
+};
+
+Status validateNativeTable(const osquery_native_table& table) {
+  if (table.name == nullptr || table.columns == nullptr ||
+      table.column_count == 0) {
+    return Status::failure("Native table is missing a name or columns");
+  }
+
+  if (table.open == nullptr || table.generate == nullptr ||
+      table.close == nullptr) {
+    return Status::failure("Native table " + std::string(table.name) +
+                           " is missing a scan function");
+  }
+
+  for (size_t i = 0; i < table.column_count; ++i) {
+    const auto& column = table.columns[i];
+    if (column.name == nullptr || column.type < OSQUERY_NATIVE_TEXT ||
+        column.type > OSQUERY_NATIVE_DOUBLE) {
+      return Status::failure("Native table " + std::string(table.name) +
+                             " has an invalid column");
+    }
+  }
+  return Status::success();
+}
+
+} // namespace
+
+NativeTablePlugin::NativeTablePlugin(const osquery_native_table* table)
+    : table_(table) {}
+
+TableColumns NativeTablePlugin::columns() const {
+  TableColumns columns;
+  for (size_t i = 0; i < table_->column_count; ++i) {
+    const auto& column = table_->columns[i];
+
+    ColumnType type = BIGINT_TYPE;
+    switch (column.type) {
+    case OSQUERY_NATIVE_TEXT:
+      type = TEXT_TYPE;
+      break;
+    case OSQUERY_NATIVE_INTEGER:
+      type = INTEGER_TYPE;
+      break;
+    case OSQUERY_NATIVE_UNSIGNED_BIGINT:
+      type = UNSIGNED_BIGINT_TYPE;
+      break;
+    case OSQUERY_NATIVE_DOUBLE:
+      type = DOUBLE_TYPE;
+      break;
+    }
+
+    columns.push_back(std::make_tuple(std::string(column.name),
+                                      type,
+                                      static_cast<ColumnOptions>(column.options)));
+  }
+  return columns;
+}
+
+void NativeTablePlugin::generator(RowYield& yield, QueryContext& context) {
+  osquery_native_context native_context;
+  native_context.context = &context;
+
+  auto scan = table_->open(&native_context);
+  if (scan == nullptr) {
+    LOG(WARNING) << "Native table " << getName() << " could not start a scan";
+    return;
+  }
+
+  // The generator is unwound without finishing when SQLite stops early.
+  auto const scan_guard =
+      scope_guard::create([this, scan]() { table_->close(scan); });
+
+  osquery_native_batch batch;
+  batch.table = table_;
+
+  int32_t result = OSQUERY_NATIVE_MORE;
+  while (result == OSQUERY_NATIVE_MORE) {
+    batch.rows.clear();
+    result = table_->generate(scan, &batch, kNativeBatchRows);
+    if (result == OSQUERY_NATIVE_ERROR) {
+      LOG(WARNING) << "Native table " << getName() << " failed to generate";
+    }
+
+    for (auto& row : batch.rows) {
+      yield(std::move(row));
+    }
+  }
+}
+
+const osquery_native_host* getNativeModuleHost() {
+  return &kNativeHost;
+}
+
+Status registerNativeModule(const osquery_native_module* module,
+                            const std::string& path) {
+  if (module == nullptr) {
+    return Status::failure("Native module did not describe itself: " + path);
+  }
+
+  if (module->abi_version != OSQUERY_NATIVE_ABI_VERSION) {
+    return Status::failure("Native module " + path + " uses ABI version " +
+                           std::to_string(module->abi_version) +
+                           ", expected " +
+                           std::to_string(OSQUERY_NATIVE_ABI_VERSION));
+  }
+
+  if (module->name == nullptr ||
+      (module->tables == nullptr && module->table_count > 0)) {
+    return Status::failure("Native module has an invalid description: " +
+                           path);
+  }
+
+  // Check every table before registering any, a rejected module is unloaded.
+  for (size_t i = 0; i < module->table_count; ++i) {
+    auto status = validateNativeTable(module->tables[i]);
+    if (!status.ok()) {
+      return Status::failure(status.getMessage() + ": " + path);
+    }
+  }
+
+  auto registry = RegistryFactory::get().registry("table");
+  size_t registered = 0;
+  for (size_t i = 0; i < module->table_count; ++i) {
+    const auto& table = module->tables[i];
+    auto status =
+        registry->add(table.name, std::make_shared<NativeTablePlugin>(&table));
+    if (status.ok()) {
+      ++registered;
+    } else {
+      LOG(WARNING) << "Cannot register native table " << table.name
+                   << " from " << path << ": " << status.getMessage();
+    }
+  }
+
+  // A module whose tables all collide with existing tables is not loaded.
+  if (module->table_count > 0 && registered == 0) {
+    return Status::failure("Native module " + std::string(module->name) +
+                           " registered no tables: " + path);
+  }
+
+  WriteLock lock(kNativeModulesMutex);
+  kNativeModules.push_back(NativeModuleInfo{
+      module->name, (module->version != nullptr) ? module->version : "", path});
+  return Status::success();
+}
+
+Status loadNativeModule(const std::string& path) {
+  auto handle = platformModuleOpen(path);
+  if (handle == nullptr) {
+    return Status::failure("Cannot load native module " + path + ": " +
+                           platformModuleGetError());
+  }
+
+  auto entry = reinterpret_cast<osquery_native_module_entry_fn>(
+      platformModuleGetSymbol(handle, OSQUERY_NATIVE_MODULE_ENTRY));
+  if (entry == nullptr) {
+    platformModuleClose(handle);
+    return Status::failure("Native module " + path + " does not export " +
+                           OSQUERY_NATIVE_MODULE_ENTRY);
+  }
+
+  // The handle stays open while the module's tables are registered.
+  auto status = registerNativeModule(entry(&kNativeHost), path);
+  if (!status.ok()) {
+    platformModuleClose(handle);
+  }
+  return status;
+}
+
+void loadNativeModules() {
+  for (const auto& path : loadModules()) {
+    auto status = loadNativeModule(path);
+    if (status.ok()) {
+      VLOG(1) << "Loaded native module: " << path;
+    } else {
+      LOG(WARNING) << status.getMessage();
+    }
+  }
+}
+
+std::vector<NativeModuleInfo> getNativeModules() {
+  ReadLock lock(kNativeModulesMutex);
+  return kNativeModules;
+}
+
+} // namespace osquery
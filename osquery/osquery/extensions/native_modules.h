@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <osquery/core/tables.h>
+#include <osquery/extensions/native_table.h>
+#include <osquery/utils/status/status.h>
+
+namespace osquery {
+
+/// A loaded native module, as listed by osquery_extensions.
+struct NativeModuleInfo {
+  std::string name;
+  std::string version;
+  std::string path;
+};
+
+/**
+ * @brief A table plugin implemented by a native module.
+ *
+ * The table runs in-process and is a generator: each batch filled by the
+ * module is converted to typed rows and yielded before the next batch is
+ * requested, so a LIMIT stops the module early.
+ */
+class NativeTablePlugin : public TablePlugin {
+ public:
+  explicit NativeTablePlugin(const osquery_native_table* table);
+
+  TableColumns columns() const override;
+
+  bool usesGenerator() const override {
+    return true;
+  }
+
+  void generator(RowYield& yield, QueryContext& context) override;
+
+ private:
+  const osquery_native_table* table_;
+};
+
+/**
+ * @brief Load a native module library and register its tables.
+ *
+ * The library stays loaded until the process exits.
+ *
+ * @param path Path to a shared library exporting OSQUERY_NATIVE_MODULE_ENTRY.
+ */
+Status loadNativeModule(const std::string& path);
+
+/**
+ * @brief Register the tables of a native module description.
+ *
+ * @param module The description returned by the module entry point.
+ * @param path The library path, used for reporting.
+ */
+Status registerNativeModule(const osquery_native_module* module,
+                            const std::string& path);
+
+/// Load the native modules listed by the modules_autoload flags.
+void loadNativeModules();
+
+/// The host services handed to module entry points.
+const osquery_native_host* getNativeModuleHost();
+
+/// The native modules loaded by this process.
+std::vector<NativeModuleInfo> getNativeModules();
+
+} // namespace osquery
@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+/**
+ * @brief The native module ABI for in-process table plugins.
+ *
+ * A native module is a shared library loaded by osquery with dlopen (or
+ * LoadLibrary) from the --modules_autoload list. Its tables run inside the
+ * process executing queries, so rows do not cross the Thrift extension API.
+ * Rows are passed to osquery as typed values, in batches.
+ *
+ * This header is plain C and does not depend on the rest of the SDK. A module
+ * exports a single function named OSQUERY_NATIVE_MODULE_ENTRY:
+ *
+ *   const osquery_native_module* osquery_native_module_entry(
+ *       const osquery_native_host* host);
+ *
+ * The returned description, its tables and columns must stay valid until the
+ * process exits. A module must not throw C++ exceptions across this ABI.
+ *
+ * Modules run without isolation: a crash or a leak in a module affects the
+ * osquery worker, and is handled by the watchdog like any other worker fault.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Bumped on any incompatible change to the structures below.
+#define OSQUERY_NATIVE_ABI_VERSION 1
+
+/// The name of the function every native module exports.
+#define OSQUERY_NATIVE_MODULE_ENTRY "osquery_native_module_entry"
+
+/// Column value types, matching osquery's ColumnType.
+typedef enum {
+  OSQUERY_NATIVE_TEXT = 1,
+  OSQUERY_NATIVE_INTEGER = 2,
+  OSQUERY_NATIVE_BIGINT = 3,
+  OSQUERY_NATIVE_UNSIGNED_BIGINT = 4,
+  OSQUERY_NATIVE_DOUBLE = 5,
+} osquery_native_type;
+
+/// Column options, matching osquery's ColumnOptions.
+#define OSQUERY_NATIVE_COLUMN_INDEX 1
+#define OSQUERY_NATIVE_COLUMN_REQUIRED 2
+#define OSQUERY_NATIVE_COLUMN_ADDITIONAL 4
+#define OSQUERY_NATIVE_COLUMN_OPTIMIZED 8
+#define OSQUERY_NATIVE_COLUMN_HIDDEN 16
+
+/// Constraint operators, matching osquery's ConstraintOperator.
+#define OSQUERY_NATIVE_OP_EQUALS 2
+#define OSQUERY_NATIVE_OP_GREATER_THAN 4
+#define OSQUERY_NATIVE_OP_LESS_THAN_OR_EQUALS 8
+#define OSQUERY_NATIVE_OP_LESS_THAN 16
+#define OSQUERY_NATIVE_OP_GREATER_THAN_OR_EQUALS 32
+#define OSQUERY_NATIVE_OP_LIKE 65
+
+/// Log severities accepted by osquery_native_host::log.
+#define OSQUERY_NATIVE_LOG_INFO 0
+#define OSQUERY_NATIVE_LOG_WARNING 1
+#define OSQUERY_NATIVE_LOG_ERROR 2
+
+/// Results of osquery_native_table::generate.
+#define OSQUERY_NATIVE_DONE 0
+#define OSQUERY_NATIVE_MORE 1
+#define OSQUERY_NATIVE_ERROR (-1)
+
+typedef struct {
+  const char* name;
+  int32_t type;
+  uint32_t options;
+} osquery_native_column;
+
+/**
+ * @brief A single column value.
+ *
+ * INTEGER, BIGINT and UNSIGNED_BIGINT use integer, DOUBLE uses real and TEXT
+ * uses text and length. The text is copied by osquery before add_row returns.
+ */
+typedef struct {
+  int32_t is_null;
+  int64_t integer;
+  double real;
+  const char* text;
+  size_t length;
+} osquery_native_value;
+
+/// The query constraints of a scan, owned by osquery.
+typedef struct osquery_native_context osquery_native_context;
+
+/// A batch of rows being filled by a scan, owned by osquery.
+typedef struct osquery_native_batch osquery_native_batch;
+
+/// Services osquery provides to modules, valid until the process exits.
+typedef struct {
+  uint32_t abi_version;
+
+  /// The number of constraint values for a column and operator.
+  size_t (*constraint_count)(const osquery_native_context* context,
+                             const char* column,
+                             int32_t op);
+
+  /// A constraint value, valid until the scan is closed.
+  const char* (*constraint_value)(const osquery_native_context* context,
+                                  const char* column,
+                                  int32_t op,
+                                  size_t index);
+
+  /// Non-zero if the query may use the column.
+  int32_t (*column_used)(const osquery_native_context* context,
+                         const char* column);
+
+  /// Append a row, with one value per column in declaration order.
+  void (*add_row)(osquery_native_batch* batch,
+                  const osquery_native_value* values);
+
+  /// Write a message to the osquery logs.
+  void (*log)(int32_t severity, const char* message);
+} osquery_native_host;
+
+typedef struct {
+  const char* name;
+  const osquery_native_column* columns;
+  size_t column_count;
+
+  /// Start a scan, returning module state or NULL on failure.
+  void* (*open)(const osquery_native_context* context);
+
+  /**
+   * @brief Add up to capacity rows to the batch.
+   *
+   * Return OSQUERY_NATIVE_MORE to be called again once the batch is consumed,
+   * OSQUERY_NATIVE_DONE after the last rows or OSQUERY_NATIVE_ERROR. The scan
+   * may be closed before the last rows are requested, for example if the
+   * query has a LIMIT.
+   */
+  int32_t (*generate)(void* scan, osquery_native_batch* batch, size_t capacity);
+
+  /// Release a scan, called once for every successful open.
+  void (*close)(void* scan);
+} osquery_native_table;
+
+typedef struct {
+  uint32_t abi_version;
+  const char* name;
+  const char* version;
+  const osquery_native_table* tables;
+  size_t table_count;
+} osquery_native_module;
+
+typedef const osquery_native_module* (*osquery_native_module_entry_fn)(
+    const osquery_native_host* host);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,252 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <cstring>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include <osquery/core/flags.h>
+#include <osquery/core/system.h>
+#include <osquery/database/database.h>
+#include <osquery/extensions/extensions.h>
+#include <osquery/extensions/native_modules.h>
+#include <osquery/filesystem/filesystem.h>
+#include <osquery/registry/registry_factory.h>
+#include <osquery/sql/sql.h>
+#include <osquery/sql/virtual_table.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+DECLARE_string(modules_autoload);
+
+namespace {
+
+/// The state of a scan of the test table.
+struct TestScan {
+  const osquery_native_context* context{nullptr};
+  int64_t next{0};
+  int64_t rows{0};
+};
+
+size_t kGenerateCalls{0};
+size_t kOpenScans{0};
+
+const osquery_native_column kTestColumns[] = {
+    {"id", OSQUERY_NATIVE_BIGINT, OSQUERY_NATIVE_COLUMN_INDEX},
+    {"name", OSQUERY_NATIVE_TEXT, 0},
+    {"ratio", OSQUERY_NATIVE_DOUBLE, 0},
+};
+
+void* testOpen(const osquery_native_context* context) {
+  auto scan = new TestScan();
+  scan->context = context;
+  scan->rows = 3000;
+
+  // An equality constraint on id limits the scan to a single row.
+  auto host = getNativeModuleHost();
+  if (host->constraint_count(context, "id", OSQUERY_NATIVE_OP_EQUALS) > 0) {
+    auto value =
+        host->constraint_value(context, "id", OSQUERY_NATIVE_OP_EQUALS, 0);
+    scan->next = std::stoll(value);
+    scan->rows = scan->next + 1;
+  }
+
+  ++kOpenScans;
+  return scan;
+}
+
+int32_t testGenerate(void* scan_ptr,
+                     osquery_native_batch* batch,
+                     size_t capacity) {
+  auto scan = static_cast<TestScan*>(scan_ptr);
+  auto host = getNativeModuleHost();
+  ++kGenerateCalls;
+
+  for (size_t i = 0; i < capacity && scan->next < scan->rows; ++i) {
+    auto name = "row" + std::to_string(scan->next);
+
+    osquery_native_value values[3];
+    std::memset(values, 0, sizeof(values));
+    values[0].integer = scan->next;
+    values[1].text = name.c_str();
+    values[1].length = name.size();
+    values[2].is_null = (scan->next % 2 == 1) ? 1 : 0;
+    values[2].real = 0.5;
+    host->add_row(batch, values);
+
+    ++scan->next;
+  }
+  return (scan->next < scan->rows) ? OSQUERY_NATIVE_MORE : OSQUERY_NATIVE_DONE;
+}
+
+void testClose(void* scan_ptr) {
+  delete static_cast<TestScan*>(scan_ptr);
+  --kOpenScans;
+}
+
+const osquery_native_table kTestTables[] = {
+    {"native_test", kTestColumns, 3, testOpen, testGenerate, testClose},
+};
+
+} // namespace
+
+class NativeModulesTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    platformSetup();
+    registryAndPluginInit();
+    initDatabasePluginForTesting();
+
+    // Tests share the process registry, the module is registered once.
+    if (!RegistryFactory::get().exists("table", "native_test")) {
+      auto module = testModule();
+      ASSERT_TRUE(registerNativeModule(&module, "test").ok());
+    }
+
+    kGenerateCalls = 0;
+    kOpenScans = 0;
+  }
+
+  static osquery_native_module testModule() {
+    return {OSQUERY_NATIVE_ABI_VERSION, "native_test", "1.0.0", kTestTables, 1};
+  }
+
+  QueryData query(const std::string& statement,
+                  const std::string& table = "native_test") {
+    auto dbc = SQLiteDBManager::getUnique();
+    attachTableInternal(table, dbc, false);
+
+    QueryData results;
+    EXPECT_TRUE(queryInternal(statement, results, dbc).ok());
+    return results;
+  }
+};
+
+TEST_F(NativeModulesTests, test_register_and_query) {
+  ASSERT_TRUE(RegistryFactory::get().exists("table", "native_test"));
+
+  auto results = query("SELECT * FROM native_test");
+  ASSERT_EQ(results.size(), 3000U);
+  EXPECT_EQ(results[0]["id"], "0");
+  EXPECT_EQ(results[0]["name"], "row0");
+  EXPECT_EQ(results[2]["name"], "row2");
+  EXPECT_EQ(results[0]["ratio"], "0.5");
+  EXPECT_EQ(results[1]["ratio"], "");
+  EXPECT_EQ(results[2999]["name"], "row2999");
+
+  // Rows arrive in batches, not one call per row.
+  EXPECT_EQ(kGenerateCalls, 3U);
+  EXPECT_EQ(kOpenScans, 0U);
+
+  auto modules = getNativeModules();
+  ASSERT_FALSE(modules.empty());
+  EXPECT_EQ(modules.back().name, "native_test");
+  EXPECT_EQ(modules.back().version, "1.0.0");
+  EXPECT_EQ(modules.back().path, "test");
+}
+
+TEST_F(NativeModulesTests, test_reject_duplicate_tables) {
+  auto modules = getNativeModules().size();
+
+  // Every table of the module is already registered.
+  auto module = testModule();
+  EXPECT_FALSE(registerNativeModule(&module, "duplicate").ok());
+  EXPECT_EQ(getNativeModules().size(), modules);
+}
+
+TEST_F(NativeModulesTests, test_constraints_and_limit) {
+  auto results = query("SELECT name FROM native_test WHERE id = 42");
+  ASSERT_EQ(results.size(), 1U);
+  EXPECT_EQ(results[0]["name"], "row42");
+  EXPECT_EQ(kGenerateCalls, 1U);
+
+  // Aggregates keep TEXT values after the row that produced them is freed.
+  results = query("SELECT max(name) AS name FROM native_test");
+  ASSERT_EQ(results.size(), 1U);
+  EXPECT_EQ(results[0]["name"], "row999");
+
+  // A LIMIT stops the scan after the first batch and still closes it.
+  kGenerateCalls = 0;
+  results = query("SELECT id FROM native_test LIMIT 10");
+  EXPECT_EQ(results.size(), 10U);
+  EXPECT_EQ(kGenerateCalls, 1U);
+  EXPECT_EQ(kOpenScans, 0U);
+}
+
+TEST_F(NativeModulesTests, test_reject_invalid_modules) {
+  EXPECT_FALSE(registerNativeModule(nullptr, "test").ok());
+
+  auto module = testModule();
+  module.abi_version = OSQUERY_NATIVE_ABI_VERSION + 1;
+  EXPECT_FALSE(registerNativeModule(&module, "test").ok());
+
+  osquery_native_table table = kTestTables[0];
+  table.generate = nullptr;
+  module = testModule();
+  module.tables = &table;
+  EXPECT_FALSE(registerNativeModule(&module, "test").ok());
+
+  EXPECT_FALSE(loadNativeModule("/nonexistent/native_test.so").ok());
+}
+
+TEST_F(NativeModulesTests, test_load_modules_autoload) {
+  // Modules are not autoloaded from tmp-like directories, use a subdirectory.
+  auto dir = fs::temp_directory_path() /
+             fs::unique_path("osquery.native_modules_test.%%%%.%%%%");
+  ASSERT_TRUE(fs::create_directories(dir));
+
+  auto module_path =
+      (dir / fs::path(OSQUERY_NATIVE_TEST_MODULE).filename()).make_preferred();
+  fs::copy_file(OSQUERY_NATIVE_TEST_MODULE, module_path);
+  fs::permissions(module_path,
+                  fs::owner_all | fs::group_read | fs::group_exe |
+                      fs::others_read | fs::others_exe);
+
+  auto autoload = (dir / "modules.load").make_preferred();
+  ASSERT_TRUE(writeTextFile(autoload, module_path.string() + "\n").ok());
+
+  auto modules_autoload = FLAGS_modules_autoload;
+  FLAGS_modules_autoload = autoload.string();
+  auto modules = getNativeModules().size();
+
+  loadNativeModules();
+  ASSERT_TRUE(RegistryFactory::get().exists("table", "native_loaded_test"));
+  ASSERT_EQ(getNativeModules().size(), modules + 1);
+  EXPECT_EQ(getNativeModules().back().name, "native_loaded_test");
+  EXPECT_EQ(getNativeModules().back().version, "0.0.1");
+  EXPECT_EQ(getNativeModules().back().path, module_path.string());
+
+  auto results =
+      query("SELECT * FROM native_loaded_test", "native_loaded_test");
+  ASSERT_EQ(results.size(), 5U);
+  EXPECT_EQ(results[0]["id"], "0");
+  EXPECT_EQ(results[0]["label"], "zero");
+  EXPECT_EQ(results[4]["id"], "4");
+  EXPECT_EQ(results[4]["label"], "four");
+
+  // Loading the module again collides with its own tables.
+  loadNativeModules();
+  EXPECT_EQ(getNativeModules().size(), modules + 1);
+  EXPECT_FALSE(loadNativeModule(module_path.string()).ok());
+
+  // Modules are disabled with extensions.
+  FLAGS_disable_extensions = true;
+  EXPECT_TRUE(loadModules().empty());
+  FLAGS_disable_extensions = false;
+  EXPECT_EQ(loadModules().size(), 1U);
+
+  FLAGS_modules_autoload = modules_autoload;
+  fs::remove_all(dir);
+}
+
+} // namespace osquery
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+/**
+ * @brief A native module used by the native module loading tests.
+ *
+ * The module is built as a shared library and loaded from a modules_autoload
+ * file. It only uses the plain C ABI, like a module built outside the tree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <osquery/extensions/native_table.h>
+
+#ifdef _WIN32
+#define NATIVE_TEST_EXPORT __declspec(dllexport)
+#else
+#define NATIVE_TEST_EXPORT __attribute__((visibility("default")))
+#endif
+
+#define NATIVE_TEST_ROWS 5
+
+static const osquery_native_host* kHost = NULL;
+
+static const osquery_native_column kColumns[] = {
+    {"id", OSQUERY_NATIVE_BIGINT, 0},
+    {"label", OSQUERY_NATIVE_TEXT, 0},
+};
+
+static void* nativeTestOpen(const osquery_native_context* context) {
+  (void)context;
+  return calloc(1, sizeof(int64_t));
+}
+
+static int32_t nativeTestGenerate(void* scan,
+                                  osquery_native_batch* batch,
+                                  size_t capacity) {
+  int64_t* next = (int64_t*)scan;
+  static const char* kLabels[NATIVE_TEST_ROWS] = {
+      "zero", "one", "two", "three", "four"};
+  osquery_native_value values[2];
+  size_t i;
+
+  for (i = 0; i < capacity && *next < NATIVE_TEST_ROWS; ++i) {
+    memset(values, 0, sizeof(values));
+    values[0].integer = *next;
+    values[1].text = kLabels[*next];
+    values[1].length = strlen(kLabels[*next]);
+    kHost->add_row(batch, values);
+    ++(*next);
+  }
+  return (*next < NATIVE_TEST_ROWS) ? OSQUERY_NATIVE_MORE : OSQUERY_NATIVE_DONE;
+}
+
+static void nativeTestClose(void* scan) {
+  free(scan);
+}
+
+static const osquery_native_table kTables[] = {
+    {"native_loaded_test",
+     kColumns,
+     2,
+     nativeTestOpen,
+     nativeTestGenerate,
+     nativeTestClose},
+};
+
+static const osquery_native_module kModule = {
+    OSQUERY_NATIVE_ABI_VERSION, "native_loaded_test", "0.0.1", kTables, 1};
+
+NATIVE_TEST_EXPORT const osquery_native_module* osquery_native_module_entry(
+    const osquery_native_host* host) {
+  kHost = host;
+  return &kModule;
+}
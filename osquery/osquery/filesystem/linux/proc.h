@@ -47,7 +47,8 @@ struct SocketProcessInfo final {
   std::string pid;
   std::string fd;
 };
-typedef std::map<std::string, SocketProcessInfo> SocketInodeToProcessInfoMap;
+typedef std::unordered_map<std::string, SocketProcessInfo>
+    SocketInodeToProcessInfoMap;
 
 // Linux proc protocol define to net stats file name.
 const std::map<int, std::string> kLinuxProtocolNames = {
@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <osquery/filesystem/parsed_file_cache.h>
+
+namespace osquery {
+
+FLAG(uint64,
+     parsed_file_cache_size,
+     4096,
+     "Max number of parsed configuration files each table keeps, 0 disables "
+     "the cache");
+
+FLAG(uint64,
+     parsed_file_workers,
+     4,
+     "Max number of threads a table uses to read and parse per-user files");
+
+namespace {
+
+const std::int64_t kNanoseconds{1000000000};
+
+} // namespace
+
+bool FileStamp::operator==(const FileStamp& other) const {
+  return device == other.device && inode == other.inode &&
+         size == other.size && mtime_ns == other.mtime_ns &&
+         ctime_ns == other.ctime_ns;
+}
+
+bool FileStamp::operator!=(const FileStamp& other) const {
+  return !(*this == other);
+}
+
+Status getFileStamp(const std::string& path, FileStamp& stamp) {
+#ifdef WIN32
+  struct _stat64 info;
+  if (::_stat64(path.c_str(), &info) != 0) {
+    return Status::failure("Cannot stat " + path);
+  }
+
+  // Windows only reports whole seconds and no inode.
+  stamp.mtime_ns = static_cast<std::int64_t>(info.st_mtime) * kNanoseconds;
+  stamp.ctime_ns = static_cast<std::int64_t>(info.st_ctime) * kNanoseconds;
+#else
+  struct stat info;
+  if (::stat(path.c_str(), &info) != 0) {
+    return Status::failure("Cannot stat " + path);
+  }
+
+#ifdef __APPLE__
+  const auto& mtime = info.st_mtimespec;
+  const auto& ctime = info.st_ctimespec;
+#else
+  const auto& mtime = info.st_mtim;
+  const auto& ctime = info.st_ctim;
+#endif
+  stamp.mtime_ns =
+      static_cast<std::int64_t>(mtime.tv_sec) * kNanoseconds + mtime.tv_nsec;
+  stamp.ctime_ns =
+      static_cast<std::int64_t>(ctime.tv_sec) * kNanoseconds + ctime.tv_nsec;
+#endif
+
+  stamp.device = static_cast<std::uint64_t>(info.st_dev);
+  stamp.inode = static_cast<std::uint64_t>(info.st_ino);
+  stamp.size = static_cast<std::uint64_t>(info.st_size);
+  return Status::success();
+}
+
+void parseFilesInParallel(std::size_t count,
+                          const std::function<void(std::size_t)>& work) {
+  auto workers = std::min<std::size_t>(
+      std::max<std::uint64_t>(FLAGS_parsed_file_workers, 1), count);
+  if (workers <= 1) {
+    for (std::size_t i = 0; i < count; ++i) {
+      work(i);
+    }
+    return;
+  }
+
+  // Workers take the next index until every file is parsed.
+  std::atomic<std::size_t> next{0};
+  auto run = [&next, count, &work]() {
+    for (auto i = next++; i < count; i = next++) {
+      work(i);
+    }
+  };
+
+  std::vector<std::future<void>> futures;
+  for (std::size_t i = 1; i < workers; ++i) {
+    futures.push_back(std::async(std::launch::async, run));
+  }
+  run();
+
+  for (auto& future : futures) {
+    future.get();
+  }
+}
+
+} // namespace osquery
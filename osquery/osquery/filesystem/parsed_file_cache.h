@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/filesystem/filesystem.h>
+#include <osquery/utils/status/status.h>
+
+namespace osquery {
+
+DECLARE_uint64(parsed_file_cache_size);
+
+/// The identity of a file's content, as reported by stat.
+struct FileStamp {
+  std::uint64_t device{0};
+  std::uint64_t inode{0};
+  std::uint64_t size{0};
+  std::int64_t mtime_ns{0};
+  std::int64_t ctime_ns{0};
+
+  bool operator==(const FileStamp& other) const;
+  bool operator!=(const FileStamp& other) const;
+};
+
+/// Stat a file, fails if the file does not exist.
+Status getFileStamp(const std::string& path, FileStamp& stamp);
+
+/**
+ * @brief Call work for every index below count, on parsed_file_workers threads.
+ *
+ * Tables use this to read and parse per-user files concurrently. Each call
+ * should write only to its own slot of a pre-sized output.
+ */
+void parseFilesInParallel(std::size_t count,
+                          const std::function<void(std::size_t)>& work);
+
+/**
+ * @brief Files parsed by a table, kept while the files are unchanged.
+ *
+ * A file is read and parsed again only when its FileStamp (device, inode,
+ * size, modification and change times) differs from the parsed copy. The
+ * least recently used parses are evicted beyond parsed_file_cache_size.
+ *
+ * The cache is safe to use from parseFilesInParallel workers, files are read
+ * and parsed without holding the lock.
+ */
+template <typename T>
+class ParsedFileCache : private boost::noncopyable {
+ public:
+  /// Parse the content of a file, a failed parse is not cached.
+  using Parser = std::function<Status(
+      const std::string& path, const std::string& content, T& parsed)>;
+
+  explicit ParsedFileCache(Parser parser) : parser_(std::move(parser)) {}
+
+  /**
+   * @brief Return the parsed content of a file.
+   *
+   * @param path The file to read.
+   * @param parsed Output, the shared parse of the file.
+   * @param log Log read failures, as readFile does.
+   * @return A failure if the file cannot be read or parsed.
+   */
+  Status get(const std::string& path,
+             std::shared_ptr<const T>& parsed,
+             bool log = true) {
+    FileStamp stamp;
+    auto status = getFileStamp(path, stamp);
+    if (!status.ok()) {
+      return status;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto entry = entries_.find(path);
+      if (entry != entries_.end()) {
+        if (entry->second.stamp == stamp) {
+          order_.splice(order_.begin(), order_, entry->second.position);
+          parsed = entry->second.parsed;
+          return Status::success();
+        }
+        order_.erase(entry->second.position);
+        entries_.erase(entry);
+      }
+    }
+
+    std::string content;
+    status = readFile(path, content, 0, false, false, log);
+    if (!status.ok()) {
+      return status;
+    }
+
+    auto value = std::make_shared<T>();
+    status = parser_(path, content, *value);
+    if (!status.ok()) {
+      return status;
+    }
+    parsed = value;
+
+    // Do not keep a parse of a file that changed while it was read.
+    FileStamp after;
+    if (getFileStamp(path, after).ok() && after == stamp) {
+      insert(path, stamp, std::move(value));
+    }
+    return Status::success();
+  }
+
+  /// The number of cached files.
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    order_.clear();
+  }
+
+ private:
+  void insert(const std::string& path,
+              const FileStamp& stamp,
+              std::shared_ptr<const T> parsed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto capacity = static_cast<std::size_t>(FLAGS_parsed_file_cache_size);
+    if (capacity == 0 || entries_.count(path) > 0) {
+      return;
+    }
+
+    order_.push_front(path);
+    entries_.emplace(path, Entry{stamp, std::move(parsed), order_.begin()});
+    while (entries_.size() > capacity) {
+      entries_.erase(order_.back());
+      order_.pop_back();
+    }
+  }
+
+ private:
+  struct Entry {
+    FileStamp stamp;
+    std::shared_ptr<const T> parsed;
+
+    /// Position of the path in the recently used order.
+    std::list<std::string>::iterator position;
+  };
+
+  Parser parser_;
+
+  /// Cached parses by path.
+  std::unordered_map<std::string, Entry> entries_;
+
+  /// Paths from the most to the least recently used.
+  std::list<std::string> order_;
+
+  mutable std::mutex mutex_;
+};
+
+} // namespace osquery
@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <atomic>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/filesystem/filesystem.h>
+#include <osquery/filesystem/parsed_file_cache.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+DECLARE_uint64(parsed_file_workers);
+
+class ParsedFileCacheTests : public testing::Test {
+ public:
+  ParsedFileCacheTests()
+      : dir_(fs::temp_directory_path() /
+             fs::unique_path("osquery.parsed_file_cache.%%%%.%%%%")),
+        cache_([this](const std::string& path,
+                      const std::string& content,
+                      std::string& parsed) {
+          parses_++;
+          if (content == "invalid") {
+            return Status::failure("Invalid content");
+          }
+          parsed = path + ":" + content;
+          return Status::success();
+        }) {}
+
+  void SetUp() override {
+    fs::create_directories(dir_);
+    cache_size_ = FLAGS_parsed_file_cache_size;
+    workers_ = FLAGS_parsed_file_workers;
+  }
+
+  void TearDown() override {
+    FLAGS_parsed_file_cache_size = cache_size_;
+    FLAGS_parsed_file_workers = workers_;
+    fs::remove_all(dir_);
+  }
+
+ protected:
+  std::string createFile(const std::string& name, const std::string& content) {
+    auto path = (dir_ / name).string();
+    writeTextFile(path, content, 0644, PF_CREATE_ALWAYS | PF_WRITE);
+    return path;
+  }
+
+ protected:
+  fs::path dir_;
+
+  std::atomic<size_t> parses_{0};
+
+  ParsedFileCache<std::string> cache_;
+
+ private:
+  std::uint64_t cache_size_{0};
+  std::uint64_t workers_{0};
+};
+
+TEST_F(ParsedFileCacheTests, test_reparse_on_change) {
+  auto path = createFile("config", "a");
+
+  std::shared_ptr<const std::string> parsed;
+  ASSERT_TRUE(cache_.get(path, parsed).ok());
+  EXPECT_EQ(path + ":a", *parsed);
+
+  // An unchanged file shares the parse.
+  std::shared_ptr<const std::string> again;
+  ASSERT_TRUE(cache_.get(path, again).ok());
+  EXPECT_EQ(parsed, again);
+  EXPECT_EQ(1U, parses_);
+
+  createFile("config", "bb");
+  ASSERT_TRUE(cache_.get(path, parsed).ok());
+  EXPECT_EQ(path + ":bb", *parsed);
+  EXPECT_EQ(2U, parses_);
+  EXPECT_EQ(1U, cache_.size());
+}
+
+TEST_F(ParsedFileCacheTests, test_failures) {
+  std::shared_ptr<const std::string> parsed;
+  EXPECT_FALSE(cache_.get((dir_ / "missing").string(), parsed).ok());
+
+  // A failed parse is tried again on the next lookup.
+  auto path = createFile("invalid", "invalid");
+  EXPECT_FALSE(cache_.get(path, parsed).ok());
+  EXPECT_FALSE(cache_.get(path, parsed).ok());
+  EXPECT_EQ(2U, parses_);
+  EXPECT_EQ(0U, cache_.size());
+}
+
+TEST_F(ParsedFileCacheTests, test_eviction) {
+  FLAGS_parsed_file_cache_size = 2;
+  auto first = createFile("first", "1");
+  auto second = createFile("second", "2");
+  auto third = createFile("third", "3");
+
+  std::shared_ptr<const std::string> parsed;
+  ASSERT_TRUE(cache_.get(first, parsed).ok());
+  ASSERT_TRUE(cache_.get(second, parsed).ok());
+  ASSERT_TRUE(cache_.get(first, parsed).ok());
+  ASSERT_TRUE(cache_.get(third, parsed).ok());
+  EXPECT_EQ(2U, cache_.size());
+  EXPECT_EQ(3U, parses_);
+
+  // The least recently used file was evicted.
+  ASSERT_TRUE(cache_.get(first, parsed).ok());
+  EXPECT_EQ(3U, parses_);
+  ASSERT_TRUE(cache_.get(second, parsed).ok());
+  EXPECT_EQ(4U, parses_);
+
+  FLAGS_parsed_file_cache_size = 0;
+  cache_.clear();
+  ASSERT_TRUE(cache_.get(first, parsed).ok());
+  EXPECT_EQ(0U, cache_.size());
+}
+
+TEST_F(ParsedFileCacheTests, test_parse_in_parallel) {
+  FLAGS_parsed_file_workers = 4;
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < 64; ++i) {
+    paths.push_back(createFile(std::to_string(i), std::to_string(i)));
+  }
+
+  std::vector<std::string> results(paths.size());
+  parseFilesInParallel(paths.size(), [&](size_t i) {
+    std::shared_ptr<const std::string> parsed;
+    if (cache_.get(paths[i], parsed).ok()) {
+      results[i] = *parsed;
+    }
+  });
+
+  for (size_t i = 0; i < paths.size(); ++i) {
+    EXPECT_EQ(paths[i] + ":" + std::to_string(i), results[i]);
+  }
+  EXPECT_EQ(paths.size(), parses_);
+}
+
+} // namespace osquery
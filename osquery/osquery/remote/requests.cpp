@@ -8,15 +8,83 @@
  */
 
 #include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 
 #include <zlib.h>
+#include <zstd.h>
+
+#include <osquery/remote/requests.h>
 
 namespace osquery {
 
 #define MOD_GZIP_ZLIB_WINDOWSIZE 15
 #define MOD_GZIP_ZLIB_CFACTOR 9
 
+namespace {
+
+/// Zstandard level used for request bodies, the library default.
+const int kZstdCompressionLevel{3};
+
+struct ZstdDictionaryDeleter {
+  void operator()(ZSTD_CDict* dictionary) const {
+    ZSTD_freeCDict(dictionary);
+  }
+};
+
+struct ZstdContextDeleter {
+  void operator()(ZSTD_CCtx* context) const {
+    ZSTD_freeCCtx(context);
+  }
+};
+
+using ZstdDictionaryRef = std::shared_ptr<ZSTD_CDict>;
+
+std::mutex kZstdDictionariesMutex;
+
+/// Loaded dictionaries by path, nullptr if the path failed to load.
+std::map<std::string, ZstdDictionaryRef> kZstdDictionaries;
+
+Status getZstdDictionary(const std::string& path, ZstdDictionaryRef& ref) {
+  std::lock_guard<std::mutex> lock(kZstdDictionariesMutex);
+  auto it = kZstdDictionaries.find(path);
+  if (it != kZstdDictionaries.end()) {
+    ref = it->second;
+    return (ref != nullptr)
+               ? Status::success()
+               : Status::failure("Cannot load Zstandard dictionary: " + path);
+  }
+
+  auto& cached = kZstdDictionaries[path];
+  std::ifstream input(path, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(input)),
+                      std::istreambuf_iterator<char>());
+  if (!input.good() && !input.eof()) {
+    return Status::failure("Cannot read Zstandard dictionary: " + path);
+  }
+
+  if (content.empty()) {
+    return Status::failure("Empty Zstandard dictionary: " + path);
+  }
+
+  cached.reset(
+      ZSTD_createCDict(content.data(), content.size(), kZstdCompressionLevel),
+      ZstdDictionaryDeleter());
+  if (cached == nullptr) {
+    return Status::failure("Invalid Zstandard dictionary: " + path);
+  }
+
+  ref = cached;
+  return Status::success();
+}
+
+} // namespace
+
 std::string compressString(const std::string& data) {
   z_stream zs;
   memset(&zs, 0, sizeof(zs));
@@ -56,4 +124,54 @@ std::string compressString(const std::string& data) {
 
   return output;
 }
+
+Status loadZstdDictionary(const std::string& dictionary) {
+  ZstdDictionaryRef ref;
+  return getZstdDictionary(dictionary, ref);
+}
+
+Status compressStringZstd(const std::string& data,
+                          std::string& output,
+                          const std::string& dictionary) {
+  // Contexts keep their workspace between calls, keep one per thread.
+  thread_local std::unique_ptr<ZSTD_CCtx, ZstdContextDeleter> context(
+      ZSTD_createCCtx());
+  if (context == nullptr) {
+    return Status::failure("Cannot create a Zstandard context");
+  }
+
+  ZstdDictionaryRef ref;
+  if (!dictionary.empty()) {
+    getZstdDictionary(dictionary, ref);
+  }
+
+  std::string buffer;
+  buffer.resize(ZSTD_compressBound(data.size()));
+
+  size_t size = 0;
+  if (ref != nullptr) {
+    size = ZSTD_compress_usingCDict(context.get(),
+                                    &buffer[0],
+                                    buffer.size(),
+                                    data.data(),
+                                    data.size(),
+                                    ref.get());
+  } else {
+    size = ZSTD_compressCCtx(context.get(),
+                             &buffer[0],
+                             buffer.size(),
+                             data.data(),
+                             data.size(),
+                             kZstdCompressionLevel);
+  }
+
+  if (ZSTD_isError(size)) {
+    return Status::failure(std::string("Cannot compress with Zstandard: ") +
+                           ZSTD_getErrorName(size));
+  }
+
+  buffer.resize(size);
+  output = std::move(buffer);
+  return Status::success();
+}
 }
@@ -34,6 +34,29 @@ class Serializer;
  */
 std::string compressString(const std::string& data);
 
+/**
+ * @brief Compress data using Zstandard.
+ *
+ * An optional dictionary, trained offline on samples of similar payloads
+ * with `zstd --train`, improves the ratio of small payloads. The frame
+ * records the dictionary ID so the receiver can pick the matching dictionary.
+ * If the dictionary cannot be loaded the data is compressed without it.
+ *
+ * @param data The input container.
+ * @param output The compressed frame, only set on success.
+ * @param dictionary An optional path to a Zstandard dictionary.
+ */
+Status compressStringZstd(const std::string& data,
+                          std::string& output,
+                          const std::string& dictionary = "");
+
+/**
+ * @brief Load and cache a Zstandard compression dictionary.
+ *
+ * Dictionaries are loaded once per path, a failed load is not retried.
+ */
+Status loadZstdDictionary(const std::string& dictionary);
+
 /**
  * @brief Abstract base class for remote transport implementations
  *
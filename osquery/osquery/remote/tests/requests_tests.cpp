@@ -9,6 +9,13 @@
 
 #include <gtest/gtest.h>
 
+#include <zdict.h>
+#include <zstd.h>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <osquery/filesystem/filesystem.h>
 #include <osquery/remote/requests.h>
 #include <osquery/remote/serializers/json.h>
 #include <osquery/remote/transports/tls.h>
@@ -177,4 +184,88 @@ TEST_F(RequestsTests, test_compression) {
   EXPECT_EQ(compressed.substr(10), expected2);
   EXPECT_LT(compressed.size(), uncompressed.size());
 }
+
+TEST_F(RequestsTests, test_compression_zstd) {
+  std::string uncompressed = "stringstringstringstring";
+  for (size_t i = 0; i < 10; i++) {
+    uncompressed += uncompressed;
+  }
+
+  std::string compressed;
+  ASSERT_TRUE(compressStringZstd(uncompressed, compressed).ok());
+  ASSERT_FALSE(compressed.empty());
+  EXPECT_LT(compressed.size(), uncompressed.size());
+
+  std::string decompressed(uncompressed.size(), '\0');
+  auto size = ZSTD_decompress(&decompressed[0],
+                              decompressed.size(),
+                              compressed.data(),
+                              compressed.size());
+  ASSERT_FALSE(ZSTD_isError(size));
+  decompressed.resize(size);
+  EXPECT_EQ(uncompressed, decompressed);
+}
+
+TEST_F(RequestsTests, test_compression_zstd_dictionary) {
+  // Train a dictionary on samples shaped like result log lines.
+  std::string samples;
+  std::vector<size_t> sample_sizes;
+  for (size_t i = 0; i < 1000; i++) {
+    std::string sample = "{\"name\":\"pack_example_processes\",";
+    sample += "\"hostIdentifier\":\"host" + std::to_string(i % 7) + "\",";
+    sample += "\"calendarTime\":\"Mon Jan  1 00:00:00 2024 UTC\",";
+    sample += "\"unixTime\":" + std::to_string(1704067200 + i) + ",";
+    sample += "\"columns\":{\"pid\":\"" + std::to_string(i * 13) + "\",";
+    sample += "\"path\":\"/usr/bin/example\"},\"action\":\"added\"}";
+    samples += sample;
+    sample_sizes.push_back(sample.size());
+  }
+
+  std::string dictionary(16 * 1024, '\0');
+  auto size = ZDICT_trainFromBuffer(&dictionary[0],
+                                    dictionary.size(),
+                                    samples.data(),
+                                    sample_sizes.data(),
+                                    static_cast<unsigned>(sample_sizes.size()));
+  ASSERT_FALSE(ZDICT_isError(size));
+  dictionary.resize(size);
+
+  auto path = boost::filesystem::temp_directory_path() /
+              boost::filesystem::unique_path("osquery.zstd.%%%%.%%%%");
+  ASSERT_TRUE(writeTextFile(path, dictionary).ok());
+  ASSERT_TRUE(loadZstdDictionary(path.string()).ok());
+
+  std::string line = samples.substr(0, sample_sizes[0]);
+  std::string plain;
+  ASSERT_TRUE(compressStringZstd(line, plain).ok());
+  std::string compressed;
+  ASSERT_TRUE(compressStringZstd(line, compressed, path.string()).ok());
+  ASSERT_FALSE(compressed.empty());
+  EXPECT_LT(compressed.size(), plain.size());
+
+  // The frame names its dictionary, which is required to decompress it.
+  EXPECT_EQ(ZDICT_getDictID(dictionary.data(), dictionary.size()),
+            ZSTD_getDictID_fromFrame(compressed.data(), compressed.size()));
+
+  std::string decompressed(line.size(), '\0');
+  auto context = ZSTD_createDCtx();
+  size = ZSTD_decompress_usingDict(context,
+                                   &decompressed[0],
+                                   decompressed.size(),
+                                   compressed.data(),
+                                   compressed.size(),
+                                   dictionary.data(),
+                                   dictionary.size());
+  ZSTD_freeDCtx(context);
+  ASSERT_FALSE(ZSTD_isError(size));
+  EXPECT_EQ(line, decompressed);
+  boost::filesystem::remove(path);
+
+  // A missing dictionary fails to load and is compressed without.
+  auto missing = path.string() + ".missing";
+  EXPECT_FALSE(loadZstdDictionary(missing).ok());
+  std::string fallback;
+  ASSERT_TRUE(compressStringZstd(line, fallback, missing).ok());
+  EXPECT_EQ(plain, fallback);
+}
 }
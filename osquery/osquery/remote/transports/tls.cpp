@@ -247,9 +247,19 @@ Status TLSTransport::sendRequest(const std::string& params, bool compress) {
 
   http::Request r(destination_);
   decorateRequest(r);
+
+  // Compress with GZip unless the caller asked for Zstandard.
+  bool zstd = false;
+  std::string dictionary;
   if (compress) {
-    // Later, when posting/putting, the data will be optionally compressed.
-    r << http::Request::Header("Content-Encoding", "gzip");
+    auto it = options_.doc().FindMember("compression");
+    zstd = it != options_.doc().MemberEnd() && it->value.IsString() &&
+           std::string(it->value.GetString()) == "zstd";
+
+    it = options_.doc().FindMember("compression_dictionary");
+    if (zstd && it != options_.doc().MemberEnd() && it->value.IsString()) {
+      dictionary = it->value.GetString();
+    }
   }
 
   // Allow request calls to override the default HTTP POST verb.
@@ -271,10 +281,28 @@ Status TLSTransport::sendRequest(const std::string& params, bool compress) {
     std::shared_ptr<http::Client> client = getClient();
     client->setOptions(getInternalOptions());
 
+    std::string body;
+    if (compress) {
+      // A failed Zstandard compression falls back to GZip, the header names
+      // the encoding that was used.
+      if (zstd) {
+        auto status = compressStringZstd(params, body, dictionary);
+        if (!status.ok()) {
+          LOG(WARNING) << status.getMessage() << ", compressing with GZip";
+          zstd = false;
+        }
+      }
+
+      if (!zstd) {
+        body = compressString(params);
+      }
+      r << http::Request::Header("Content-Encoding", (zstd) ? "zstd" : "gzip");
+    }
+
     if (verb == HTTP_POST) {
-      response_ = client->post(r, (compress) ? compressString(params) : params);
+      response_ = client->post(r, (compress) ? body : params);
     } else {
-      response_ = client->put(r, (compress) ? compressString(params) : params);
+      response_ = client->put(r, (compress) ? body : params);
     }
 
     const auto& response_body = response_.body();
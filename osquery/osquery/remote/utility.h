@@ -100,13 +100,30 @@ class TLSRequestHelper : private boost::noncopyable {
     request.setOption("hostname", FLAGS_tls_hostname);
 
     bool compress = false;
+    std::string compression;
     auto it = params_doc.FindMember("_compress");
     if (it != params_doc.MemberEnd()) {
       compress = true;
       request.setOption("compress", compress);
+
+      // The value may name the algorithm, GZip is used otherwise.
+      if (it->value.IsString()) {
+        compression = it->value.GetString();
+        request.setOption("compression", compression);
+      }
       params_doc.RemoveMember("_compress");
     }
 
+    std::string dictionary;
+    it = params_doc.FindMember("_compression_dictionary");
+    if (it != params_doc.MemberEnd()) {
+      assert(it->value.IsString());
+
+      dictionary = it->value.GetString();
+      request.setOption("compression_dictionary", dictionary);
+      params_doc.RemoveMember("_compression_dictionary");
+    }
+
     // The caller-supplied parameters may force a POST request.
     bool force_post = false;
     it = params_doc.FindMember("_verb");
@@ -131,8 +148,14 @@ class TLSRequestHelper : private boost::noncopyable {
       params.add("_verb", "POST");
     }
 
-    if (compress) {
+    if (compress && compression.empty()) {
       params.add("_compress", true);
+    } else if (compress) {
+      params.add("_compress", compression);
+    }
+
+    if (!dictionary.empty()) {
+      params.add("_compression_dictionary", dictionary);
     }
 
     if (!status.ok()) {
@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <osquery/sql/query_profile.h>
+
+namespace osquery {
+
+namespace {
+
+thread_local QueryProfile* kActiveProfile{nullptr};
+
+} // namespace
+
+ScopedQueryProfile::ScopedQueryProfile(QueryProfile& profile)
+    : profile_(profile), previous_(kActiveProfile) {
+  kActiveProfile = &profile_;
+  start_ = std::chrono::steady_clock::now();
+
+  // Reset the high-water mark, the SQLite heap is shared by every thread.
+  sqlite3_int64 highwater = 0;
+  sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &memory_start_, &highwater, 1);
+}
+
+ScopedQueryProfile::~ScopedQueryProfile() {
+  profile_.micros += std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start_)
+                         .count();
+
+  sqlite3_int64 current = 0;
+  sqlite3_int64 highwater = 0;
+  sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &current, &highwater, 0);
+  if (highwater > memory_start_) {
+    profile_.memory_peak = std::max<uint64_t>(
+        profile_.memory_peak, static_cast<uint64_t>(highwater - memory_start_));
+  }
+
+  kActiveProfile = previous_;
+}
+
+QueryProfile* ScopedQueryProfile::active() {
+  return kActiveProfile;
+}
+
+void ScopedQueryProfile::recordStatement(sqlite3_stmt* stmt) {
+  auto* profile = kActiveProfile;
+  if (profile == nullptr || stmt == nullptr) {
+    return;
+  }
+
+  profile->statements++;
+  profile->vm_steps += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 0);
+  profile->fullscan_steps +=
+      sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 0);
+  profile->sorts += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 0);
+  profile->autoindex_rows +=
+      sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, 0);
+}
+
+QueryProfiles& QueryProfiles::get() {
+  static QueryProfiles instance;
+  return instance;
+}
+
+void QueryProfiles::record(const std::string& name,
+                           QueryProfile profile,
+                           uint64_t time) {
+  WriteLock lock(mutex_);
+  profiles_[name] = std::make_pair(std::move(profile), time);
+}
+
+std::map<std::string, std::pair<QueryProfile, uint64_t>>
+QueryProfiles::snapshot() const {
+  ReadLock lock(mutex_);
+  return profiles_;
+}
+
+void QueryProfiles::reset() {
+  WriteLock lock(mutex_);
+  profiles_.clear();
+}
+} // namespace osquery
@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+
+#include <sqlite3.h>
+
+#include <osquery/utils/mutex.h>
+
+namespace osquery {
+
+/// Cost of a single virtual table within a profiled query.
+struct TableProfile {
+  /// Number of xFilter calls, one per scan or per outer row of a JOIN.
+  uint64_t filters{0};
+
+  /// Time spent generating rows in microseconds.
+  uint64_t generate_micros{0};
+
+  /// Rows generated by the table.
+  uint64_t rows_produced{0};
+
+  /// Rows SQLite read at least one column from.
+  uint64_t rows_consumed{0};
+};
+
+/// Cost of a query, accumulated over each of its statements.
+struct QueryProfile {
+  /// Number of statements executed.
+  uint64_t statements{0};
+
+  /// Wall time of the query in microseconds.
+  uint64_t micros{0};
+
+  /// SQLite virtual machine steps.
+  uint64_t vm_steps{0};
+
+  /// Steps SQLite spent in full table scans.
+  uint64_t fullscan_steps{0};
+
+  /// Sort operations SQLite performed.
+  uint64_t sorts{0};
+
+  /// Rows inserted into transient automatic indexes.
+  uint64_t autoindex_rows{0};
+
+  /// Peak bytes of SQLite heap used above the start of the query.
+  uint64_t memory_peak{0};
+
+  /// Per-table costs, by table name.
+  std::map<std::string, TableProfile> tables;
+};
+
+/**
+ * @brief Collect a QueryProfile for the queries run on this thread.
+ *
+ * While an instance exists the virtual table module, and the statement
+ * execution loops, add their costs to the profile. Profiling is thread-local
+ * because SQLite calls into virtual tables on the thread stepping the query.
+ */
+class ScopedQueryProfile : private boost::noncopyable {
+ public:
+  explicit ScopedQueryProfile(QueryProfile& profile);
+  ~ScopedQueryProfile();
+
+  /// The profile collected on this thread, nullptr if not profiling.
+  static QueryProfile* active();
+
+  /// Add the counters of a statement about to be finalized.
+  static void recordStatement(sqlite3_stmt* stmt);
+
+ private:
+  /// The profile being collected.
+  QueryProfile& profile_;
+
+  /// The profile collected before this one, restored when finished.
+  QueryProfile* previous_{nullptr};
+
+  /// The start of the query.
+  std::chrono::steady_clock::time_point start_;
+
+  /// The SQLite heap used at the start of the query.
+  sqlite3_int64 memory_start_{0};
+};
+
+/// The last profile collected for each scheduled query.
+class QueryProfiles : private boost::noncopyable {
+ public:
+  /// Access the process-wide profiles.
+  static QueryProfiles& get();
+
+  /// Replace the profile for a scheduled query.
+  void record(const std::string& name, QueryProfile profile, uint64_t time);
+
+  /// Copy the profiles and the time each was recorded.
+  std::map<std::string, std::pair<QueryProfile, uint64_t>> snapshot() const;
+
+  /// Forget all recorded profiles.
+  void reset();
+
+ private:
+  QueryProfiles() = default;
+
+ private:
+  /// The profiles and collection times, by scheduled query name.
+  std::map<std::string, std::pair<QueryProfile, uint64_t>> profiles_;
+
+  /// Protect the profiles map.
+  mutable Mutex mutex_;
+};
+} // namespace osquery
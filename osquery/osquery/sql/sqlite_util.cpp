@@ -19,6 +19,7 @@
 #include <osquery/core/shutdown.h>
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry_factory.h>
+#include <osquery/sql/query_profile.h>
 #include <osquery/sql/sql.h>
 
 #include <osquery/utils/conversions/split.h>
@@ -39,6 +40,11 @@ CLI_FLAG(string,
 
 FLAG(string, nullvalue, "", "Set string for NULL values, default ''");
 
+FLAG(uint64,
+     sql_statement_cache_size,
+     256,
+     "Prepared statements kept for reuse by the primary database (0 disables)");
+
 using OpReg = QueryPlanner::Opcode::Register;
 
 using SQLiteDBInstanceRef = std::shared_ptr<SQLiteDBInstance>;
@@ -377,6 +383,79 @@ bool SQLiteDBInstance::useCache() const {
   return use_cache_;
 }
 
+SQLiteStatementCache* SQLiteDBInstance::statements() const {
+  if (db_ == nullptr || FLAGS_sql_statement_cache_size == 0) {
+    return nullptr;
+  }
+  if (isPrimary()) {
+    return &SQLiteDBManager::instance().statements_;
+  }
+  return &statements_;
+}
+
+SQLiteStatementCache::~SQLiteStatementCache() {
+  clear();
+}
+
+sqlite3_stmt* SQLiteStatementCache::take(const std::string& sql,
+                                         size_t& tail) {
+  WriteLock lock(mutex_);
+  auto it = index_.find(sql);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+
+  auto entry = it->second;
+  auto* stmt = entry->stmt;
+  tail = entry->tail;
+  index_.erase(it);
+  entries_.erase(entry);
+  return stmt;
+}
+
+void SQLiteStatementCache::put(std::string sql,
+                               size_t tail,
+                               sqlite3_stmt* stmt) {
+  sqlite3_reset(stmt);
+  // The query profiler reads these counters once per execution.
+  for (auto op : {SQLITE_STMTSTATUS_VM_STEP,
+                  SQLITE_STMTSTATUS_FULLSCAN_STEP,
+                  SQLITE_STMTSTATUS_SORT,
+                  SQLITE_STMTSTATUS_AUTOINDEX}) {
+    sqlite3_stmt_status(stmt, op, 1);
+  }
+
+  WriteLock lock(mutex_);
+  if (index_.count(sql) > 0) {
+    // The same SQL ran concurrently, keep the statement already cached.
+    sqlite3_finalize(stmt);
+    return;
+  }
+
+  entries_.push_front(Entry{std::move(sql), tail, stmt});
+  index_[entries_.front().sql] = entries_.begin();
+  while (entries_.size() > FLAGS_sql_statement_cache_size) {
+    auto& oldest = entries_.back();
+    sqlite3_finalize(oldest.stmt);
+    index_.erase(oldest.sql);
+    entries_.pop_back();
+  }
+}
+
+void SQLiteStatementCache::clear() {
+  WriteLock lock(mutex_);
+  for (auto& entry : entries_) {
+    sqlite3_finalize(entry.stmt);
+  }
+  entries_.clear();
+  index_.clear();
+}
+
+size_t SQLiteStatementCache::size() const {
+  WriteLock lock(mutex_);
+  return entries_.size();
+}
+
 RecursiveLock SQLiteDBInstance::attachLock() const {
   if (isPrimary()) {
     return RecursiveLock(kPrimaryAttachMutex);
@@ -430,6 +509,7 @@ void SQLiteDBInstance::clearAffectedTables() {
 
 SQLiteDBInstance::~SQLiteDBInstance() {
   if (!isPrimary() && db_ != nullptr) {
+    statements_.clear();
     sqlite3_close(db_);
   } else {
     db_ = nullptr;
@@ -486,6 +566,8 @@ void SQLiteDBManager::resetPrimary() {
 
   {
     WriteLock create_lock(self.create_mutex_);
+    // Statements must be finalized before the database can be closed.
+    self.statements_.clear();
     sqlite3_close(self.db_);
     self.db_ = nullptr;
   }
@@ -536,6 +618,7 @@ SQLiteDBInstanceRef SQLiteDBManager::getConnection(bool primary) {
 
 SQLiteDBManager::~SQLiteDBManager() {
   connection_ = nullptr;
+  statements_.clear();
   if (db_ != nullptr) {
     sqlite3_close(db_);
     db_ = nullptr;
@@ -638,9 +721,10 @@ Status queryInternal(const std::string& query,
   return status;
 }
 
-Status readRows(sqlite3_stmt* prepared_statement,
-                QueryDataTyped& results,
-                const SQLiteDBInstanceRef& instance) {
+/// Step a prepared statement to completion, the caller owns the statement.
+static Status stepRows(sqlite3_stmt* prepared_statement,
+                       QueryDataTyped& results,
+                       const SQLiteDBInstanceRef& instance) {
   // Do nothing with a null prepared_statement (eg, if the sql was just
   // whitespace)
   if (prepared_statement == nullptr) {
@@ -682,13 +766,23 @@ Status readRows(sqlite3_stmt* prepared_statement,
       rc = sqlite3_step(prepared_statement);
     } while (SQLITE_ROW == rc);
   }
+  ScopedQueryProfile::recordStatement(prepared_statement);
   if (rc != SQLITE_DONE) {
-    auto s = Status::failure(sqlite3_errmsg(instance->db()));
+    return Status::failure(sqlite3_errmsg(instance->db()));
+  }
+  return Status::success();
+}
+
+Status readRows(sqlite3_stmt* prepared_statement,
+                QueryDataTyped& results,
+                const SQLiteDBInstanceRef& instance) {
+  auto s = stepRows(prepared_statement, results, instance);
+  if (!s.ok()) {
     sqlite3_finalize(prepared_statement);
     return s;
   }
 
-  rc = sqlite3_finalize(prepared_statement);
+  int rc = sqlite3_finalize(prepared_statement);
   if (rc != SQLITE_OK) {
     return Status::failure(sqlite3_errmsg(instance->db()));
   }
@@ -705,6 +799,9 @@ Status queryInternal(const std::string& query,
   const char* leftover_sql = nullptr; /* Tail of unprocessed SQL */
   const char* sql = query.c_str(); /* SQL to be processed */
 
+  /* Recurring queries reuse statements prepared on the primary database. */
+  auto* statements = instance->statements();
+
   /* The big while loop.  One iteration per statement */
   while ((sql[0] != '\0') && (SQLITE_OK == rc)) {
     const auto lock = instance->attachLock();
@@ -713,17 +810,41 @@ Status queryInternal(const std::string& query,
     while (isspace(sql[0])) {
       sql++;
     }
-    rc = sqlite3_prepare_v2(
-        instance->db(), sql, -1, &prepared_statement, &leftover_sql);
-    if (rc != SQLITE_OK) {
-      Status s = Status::failure(sqlite3_errmsg(instance->db()));
-      sqlite3_finalize(prepared_statement);
-      return s;
+
+    std::string statement_key;
+    size_t tail = 0;
+    prepared_statement = nullptr;
+    if (statements != nullptr) {
+      statement_key = sql;
+      prepared_statement = statements->take(statement_key, tail);
     }
 
-    Status s = readRows(prepared_statement, results, instance);
-    if (!s.ok()) {
-      return s;
+    if (prepared_statement != nullptr) {
+      leftover_sql = sql + tail;
+    } else {
+      rc = sqlite3_prepare_v2(
+          instance->db(), sql, -1, &prepared_statement, &leftover_sql);
+      if (rc != SQLITE_OK) {
+        Status s = Status::failure(sqlite3_errmsg(instance->db()));
+        sqlite3_finalize(prepared_statement);
+        return s;
+      }
+    }
+
+    if (statements == nullptr || prepared_statement == nullptr) {
+      Status s = readRows(prepared_statement, results, instance);
+      if (!s.ok()) {
+        return s;
+      }
+    } else {
+      Status s = stepRows(prepared_statement, results, instance);
+      if (!s.ok()) {
+        sqlite3_finalize(prepared_statement);
+        return s;
+      }
+      statements->put(std::move(statement_key),
+                      static_cast<size_t>(leftover_sql - sql),
+                      prepared_statement);
     }
 
     sql = leftover_sql;
@@ -10,8 +10,10 @@
 #pragma once
 
 #include <atomic>
+#include <list>
 #include <map>
 #include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <sqlite3.h>
@@ -86,6 +88,51 @@ const std::unordered_set<std::string> kAllowedSQLitePragmas = {
 
 class SQLiteDBManager;
 
+/**
+ * @brief A least-recently-used cache of prepared statements.
+ *
+ * Statements are keyed on the SQL text they were prepared from, including any
+ * trailing statements, and remember the length of text they consumed.
+ * A statement is removed while it executes so it is never stepped twice.
+ */
+class SQLiteStatementCache : private boost::noncopyable {
+ public:
+  ~SQLiteStatementCache();
+
+  /**
+   * @brief Remove and return a prepared statement for the SQL text.
+   *
+   * @param sql The SQL text starting at the statement.
+   * @param tail Output length of text the statement consumed.
+   * @return The statement or nullptr if none is cached.
+   */
+  sqlite3_stmt* take(const std::string& sql, size_t& tail);
+
+  /// Reset a statement and return it to the cache, evicting the oldest.
+  void put(std::string sql, size_t tail, sqlite3_stmt* stmt);
+
+  /// Finalize every cached statement, the schema is changing.
+  void clear();
+
+  /// The number of cached statements.
+  size_t size() const;
+
+ private:
+  struct Entry {
+    std::string sql;
+    size_t tail{0};
+    sqlite3_stmt* stmt{nullptr};
+  };
+
+  /// Cached statements, most recently used first.
+  std::list<Entry> entries_;
+
+  /// Lookup from SQL text into the entries.
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+
+  mutable Mutex mutex_;
+};
+
 /**
  * @brief An RAII wrapper around an `sqlite3` object.
  *
@@ -139,6 +186,15 @@ class SQLiteDBInstance : private boost::noncopyable {
   /// Lock the database for attaching virtual tables.
   RecursiveLock attachLock() const;
 
+  /**
+   * @brief The prepared statement cache for this database.
+   *
+   * Instances of the primary database share the manager's cache, a transient
+   * database keeps its own until it is closed. Returns nullptr if statement
+   * caching is disabled.
+   */
+  SQLiteStatementCache* statements() const;
+
  private:
   /// Handle the primary/forwarding requests for table attribute accesses.
   TableAttributes getAttributes() const;
@@ -184,6 +240,9 @@ class SQLiteDBInstance : private boost::noncopyable {
   /// Vector of tables that need their constraints cleared after execution.
   std::map<std::string, std::shared_ptr<VirtualTableContent>> affected_tables_;
 
+  /// Prepared statements for a transient database.
+  mutable SQLiteStatementCache statements_;
+
  private:
   friend class SQLiteDBManager;
   friend class SQLInternal;
@@ -274,6 +333,9 @@ class SQLiteDBManager : private boost::noncopyable {
   /// A write mutex for initializing the primary database.
   Mutex create_mutex_;
 
+  /// Prepared statements for the primary database.
+  SQLiteStatementCache statements_;
+
   /// Member variable to hold set of disabled tables.
   std::unordered_set<std::string> disabled_tables_;
 
@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+
+#include <osquery/sql/table_statistics.h>
+
+namespace osquery {
+
+/// Weight of the newest sample once enough calls have been observed.
+const uint64_t kStatisticsWindow{16};
+
+TableStatistics& TableStatistics::get() {
+  static TableStatistics instance;
+  return instance;
+}
+
+void TableStatistics::record(const std::string& table,
+                             bool constrained,
+                             size_t rows,
+                             uint64_t micros) {
+  WriteLock lock(mutex_);
+  auto& stats = tables_[table][constrained ? 1 : 0];
+
+  // A cumulative average until the window fills, then exponential decay so
+  // the estimates follow changes to the host (e.g., the number of processes).
+  stats.calls++;
+  auto weight = static_cast<double>(std::min(stats.calls, kStatisticsWindow));
+  stats.rows += (static_cast<double>(rows) - stats.rows) / weight;
+  stats.micros += (static_cast<double>(micros) - stats.micros) / weight;
+}
+
+bool TableStatistics::lookup(const std::string& table,
+                             bool constrained,
+                             TableCallStatistics& stats) const {
+  ReadLock lock(mutex_);
+  auto it = tables_.find(table);
+  if (it == tables_.end()) {
+    return false;
+  }
+
+  const auto& observed = it->second[constrained ? 1 : 0];
+  if (observed.calls == 0) {
+    return false;
+  }
+
+  stats = observed;
+  return true;
+}
+
+void TableStatistics::reset() {
+  WriteLock lock(mutex_);
+  tables_.clear();
+}
+} // namespace osquery
@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/utils/mutex.h>
+
+namespace osquery {
+
+/// Observed behavior of a table's generate calls.
+struct TableCallStatistics {
+  /// Number of generate calls observed.
+  uint64_t calls{0};
+
+  /// Moving average of rows returned per call.
+  double rows{0};
+
+  /// Moving average of generate latency in microseconds.
+  double micros{0};
+};
+
+/**
+ * @brief Runtime statistics for table generate calls, used by the planner.
+ *
+ * SQLite chooses JOIN orders using the estimated cost and rows provided by
+ * xBestIndex. The spec only describes which columns are indexed, so each call
+ * into a table is recorded here. Calls are kept separately for scans and for
+ * calls bound by index constraints, which are usually much cheaper.
+ */
+class TableStatistics : private boost::noncopyable {
+ public:
+  /// Access the process-wide statistics.
+  static TableStatistics& get();
+
+  /**
+   * @brief Record a single generate call.
+   *
+   * @param table The table name.
+   * @param constrained True if the call was bound by index constraints.
+   * @param rows The number of rows returned.
+   * @param micros The time spent generating rows.
+   */
+  void record(const std::string& table,
+              bool constrained,
+              size_t rows,
+              uint64_t micros);
+
+  /// Lookup the statistics for a table, false if none were recorded.
+  bool lookup(const std::string& table,
+              bool constrained,
+              TableCallStatistics& stats) const;
+
+  /// Forget all recorded statistics.
+  void reset();
+
+ private:
+  TableStatistics() = default;
+
+ private:
+  /// Statistics for each table, indexed by [scan, constrained].
+  std::unordered_map<std::string, std::array<TableCallStatistics, 2>> tables_;
+
+  /// Protect the statistics map.
+  mutable Mutex mutex_;
+};
+} // namespace osquery
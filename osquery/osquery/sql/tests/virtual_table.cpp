@@ -15,13 +15,16 @@
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry.h>
 #include <osquery/sql/dynamic_table_row.h>
+#include <osquery/sql/query_profile.h>
 #include <osquery/sql/sql.h>
+#include <osquery/sql/table_statistics.h>
 
 #include <osquery/sql/virtual_table.h>
 
 namespace osquery {
 
 DECLARE_bool(ignore_table_exceptions);
+DECLARE_bool(lazy_table_attach);
 
 class VirtualTableTests : public testing::Test {
  public:
@@ -923,6 +926,294 @@ TEST_F(VirtualTableTests, test_indexing_costs) {
   EXPECT_EQ(10U, j->scans);
 }
 
+class expensiveTablePlugin : public indexIOptimizedTablePlugin {
+ private:
+  TableAttributes attributes() const override {
+    return TableAttributes::EXPENSIVE;
+  }
+};
+
+TEST_F(VirtualTableTests, test_expensive_costs) {
+  auto dbc = SQLiteDBManager::getUnique();
+  auto table_registry = RegistryFactory::get().registry("table");
+
+  auto expensive = std::make_shared<expensiveTablePlugin>();
+  table_registry->add("expensive_i", expensive);
+  attachTableInternal("expensive_i", dbc, false);
+
+  auto i = std::make_shared<indexIOptimizedTablePlugin>();
+  table_registry->add("index_i_cheap", i);
+  attachTableInternal("index_i_cheap", dbc, false);
+
+  // Both tables can be constrained on i, the expensive table should not be
+  // scanned regardless of the JOIN order.
+  QueryData results;
+  queryInternal("SELECT * from expensive_i JOIN index_i_cheap using (i);",
+                results,
+                dbc);
+  dbc->clearAffectedTables();
+  EXPECT_EQ(1U, i->scans);
+  EXPECT_EQ(100U, expensive->scans);
+  EXPECT_EQ(100U, results.size());
+}
+
+TEST_F(VirtualTableTests, test_table_statistics) {
+  auto& statistics = TableStatistics::get();
+  statistics.reset();
+
+  TableCallStatistics observed;
+  EXPECT_FALSE(statistics.lookup("stats_table", false, observed));
+
+  statistics.record("stats_table", false, 100, 1000);
+  statistics.record("stats_table", false, 200, 3000);
+  ASSERT_TRUE(statistics.lookup("stats_table", false, observed));
+  EXPECT_EQ(2U, observed.calls);
+  EXPECT_DOUBLE_EQ(150, observed.rows);
+  EXPECT_DOUBLE_EQ(2000, observed.micros);
+
+  // Constrained calls are tracked separately.
+  EXPECT_FALSE(statistics.lookup("stats_table", true, observed));
+
+  // Queries record each generate call.
+  auto dbc = SQLiteDBManager::getUnique();
+  auto table_registry = RegistryFactory::get().registry("table");
+  auto i = std::make_shared<indexIOptimizedTablePlugin>();
+  table_registry->add("index_i_stats", i);
+  attachTableInternal("index_i_stats", dbc, false);
+
+  QueryData results;
+  queryInternal(
+      "SELECT * from index_i_stats WHERE i IN (1, 2, 3);", results, dbc);
+  ASSERT_TRUE(statistics.lookup("index_i_stats", true, observed));
+  EXPECT_EQ(3U, observed.calls);
+  EXPECT_DOUBLE_EQ(1, observed.rows);
+  EXPECT_FALSE(statistics.lookup("index_i_stats", false, observed));
+  statistics.reset();
+}
+
+TEST_F(VirtualTableTests, test_query_profile) {
+  auto dbc = SQLiteDBManager::getUnique();
+  auto table_registry = RegistryFactory::get().registry("table");
+  table_registry->add("profile_scan",
+                      std::make_shared<defaultScanTablePlugin>());
+  table_registry->add("profile_yield", std::make_shared<yieldTablePlugin>());
+  attachTableInternal("profile_scan", dbc, false);
+  attachTableInternal("profile_yield", dbc, false);
+
+  // Nothing is recorded without an active profile.
+  EXPECT_EQ(nullptr, ScopedQueryProfile::active());
+
+  QueryProfile profile;
+  QueryData results;
+  {
+    ScopedQueryProfile scope(profile);
+    EXPECT_EQ(&profile, ScopedQueryProfile::active());
+    queryInternal("SELECT * FROM profile_scan LIMIT 3;", results, dbc);
+    queryInternal("SELECT * FROM profile_yield;", results, dbc);
+  }
+  EXPECT_EQ(nullptr, ScopedQueryProfile::active());
+  EXPECT_EQ(13U, results.size());
+
+  EXPECT_EQ(2U, profile.statements);
+  EXPECT_GT(profile.vm_steps, 0U);
+
+  // All rows are generated even if SQLite only reads a few of them.
+  ASSERT_EQ(1U, profile.tables.count("profile_scan"));
+  const auto& scan = profile.tables.at("profile_scan");
+  EXPECT_EQ(1U, scan.filters);
+  EXPECT_EQ(10U, scan.rows_produced);
+  EXPECT_EQ(3U, scan.rows_consumed);
+
+  // Generator tables produce rows as they are read.
+  ASSERT_EQ(1U, profile.tables.count("profile_yield"));
+  const auto& yield = profile.tables.at("profile_yield");
+  EXPECT_EQ(1U, yield.filters);
+  EXPECT_EQ(10U, yield.rows_produced);
+  EXPECT_EQ(10U, yield.rows_consumed);
+
+  // Scheduled query profiles keep the latest execution.
+  QueryProfiles::get().reset();
+  QueryProfiles::get().record("pack_test_query", profile, 1);
+  QueryProfiles::get().record("pack_test_query", QueryProfile(), 2);
+  auto profiles = QueryProfiles::get().snapshot();
+  ASSERT_EQ(1U, profiles.size());
+  EXPECT_EQ(2U, profiles.at("pack_test_query").second);
+  EXPECT_TRUE(profiles.at("pack_test_query").first.tables.empty());
+  QueryProfiles::get().reset();
+}
+
+class reuseTablePlugin : public indexIOptimizedTablePlugin {
+ public:
+  TableRows generate(QueryContext& context) override {
+    constrained.push_back(context.constraints["i"].exists(EQUALS));
+    j_used.push_back(context.isColumnUsed("j"));
+    return indexIOptimizedTablePlugin::generate(context);
+  }
+
+  std::vector<bool> constrained;
+  std::vector<bool> j_used;
+};
+
+TEST_F(VirtualTableTests, test_prepared_statement_reuse) {
+  auto table_registry = RegistryFactory::get().registry("table");
+  auto reuse = std::make_shared<reuseTablePlugin>();
+  table_registry->add("reuse_scan", reuse);
+
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal("reuse_scan", dbc, false);
+  auto* statements = dbc->statements();
+  ASSERT_NE(statements, nullptr);
+  EXPECT_EQ(0U, statements->size());
+
+  const std::string query = "SELECT j FROM reuse_scan WHERE i = 3";
+  for (size_t run = 0; run < 2; run++) {
+    QueryData results;
+    auto status = queryInternal(query, results, dbc);
+    dbc->clearAffectedTables();
+    ASSERT_TRUE(status.ok());
+    ASSERT_EQ(1U, results.size());
+    EXPECT_EQ("30", results[0]["j"]);
+    EXPECT_EQ(1U, statements->size());
+  }
+
+  // The reused statement restores the cleared constraints and used columns.
+  EXPECT_EQ(std::vector<bool>({true, true}), reuse->constrained);
+  EXPECT_EQ(std::vector<bool>({true, true}), reuse->j_used);
+
+  // Changing the attached tables finalizes the cached statements.
+  detachTableInternal("reuse_scan", dbc);
+  EXPECT_EQ(0U, statements->size());
+}
+
+class lazyScanTablePlugin : public defaultScanTablePlugin {
+ private:
+  std::vector<std::string> aliases() const override {
+    return {"lazy_scan_alias"};
+  }
+};
+
+TEST_F(VirtualTableTests, test_lazy_table_attach) {
+  auto table_registry = RegistryFactory::get().registry("table");
+  auto lazy = std::make_shared<lazyScanTablePlugin>();
+  table_registry->add("lazy_scan", lazy);
+
+  FLAGS_lazy_table_attach = true;
+  auto dbc = SQLiteDBManager::getUnique();
+  FLAGS_lazy_table_attach = false;
+
+  // The table schema is not created when attaching.
+  QueryData results;
+  queryInternal(
+      "SELECT * FROM sqlite_temp_master WHERE tbl_name = 'lazy_scan';",
+      results,
+      dbc);
+  EXPECT_TRUE(results.empty());
+  EXPECT_EQ(0U, lazy->scans);
+
+  // The first reference connects the table.
+  results.clear();
+  queryInternal("SELECT count(*) AS c FROM lazy_scan;", results, dbc);
+  dbc->clearAffectedTables();
+  ASSERT_EQ(1U, results.size());
+  EXPECT_EQ("10", results[0]["c"]);
+
+  // Aliases are available as views.
+  results.clear();
+  queryInternal("SELECT count(*) AS c FROM lazy_scan_alias;", results, dbc);
+  dbc->clearAffectedTables();
+  ASSERT_EQ(1U, results.size());
+  EXPECT_EQ("10", results[0]["c"]);
+  EXPECT_EQ(2U, lazy->scans);
+
+  // Detaching a table that was never created by name keeps its module.
+  FLAGS_lazy_table_attach = true;
+  EXPECT_TRUE(detachTableInternal("lazy_scan", dbc).ok());
+  results.clear();
+  EXPECT_TRUE(
+      queryInternal("SELECT count(*) AS c FROM lazy_scan;", results, dbc).ok());
+  dbc->clearAffectedTables();
+  ASSERT_EQ(1U, results.size());
+  EXPECT_EQ("10", results[0]["c"]);
+
+  // Removing a table created by name also removes its module.
+  attachTableInternal("lazy_scan", dbc, false);
+  EXPECT_TRUE(detachTableInternal("lazy_scan", dbc).ok());
+  FLAGS_lazy_table_attach = false;
+  results.clear();
+  EXPECT_FALSE(
+      queryInternal("SELECT count(*) AS c FROM lazy_scan;", results, dbc).ok());
+  dbc->clearAffectedTables();
+}
+
+class lazyColumnsTablePlugin : public defaultScanTablePlugin {
+ private:
+  TableColumns columns() const override {
+    definitions++;
+    return {
+        std::make_tuple("i", INTEGER_TYPE, ColumnOptions::DEFAULT),
+        std::make_tuple("text", INTEGER_TYPE, ColumnOptions::DEFAULT),
+    };
+  }
+
+ public:
+  // The number of times the table schema was requested.
+  mutable size_t definitions{0};
+};
+
+TEST_F(VirtualTableTests, test_lazy_table_attach_many) {
+  auto table_registry = RegistryFactory::get().registry("table");
+  std::vector<std::shared_ptr<lazyColumnsTablePlugin>> tables;
+  for (size_t i = 0; i < 20; i++) {
+    tables.push_back(std::make_shared<lazyColumnsTablePlugin>());
+    table_registry->add("lazy_many_" + std::to_string(i), tables.back());
+  }
+
+  std::vector<size_t> definitions;
+  for (const auto& table : tables) {
+    definitions.push_back(table->definitions);
+  }
+
+  FLAGS_lazy_table_attach = true;
+  auto dbc = SQLiteDBManager::getUnique();
+
+  // Creating the connection neither requests nor creates any schema.
+  QueryData results;
+  queryInternal(
+      "SELECT * FROM sqlite_temp_master WHERE tbl_name LIKE 'lazy_many_%';",
+      results,
+      dbc);
+  EXPECT_TRUE(results.empty());
+  for (size_t i = 0; i < tables.size(); i++) {
+    EXPECT_EQ(definitions[i], tables[i]->definitions);
+  }
+
+  // Only the table used by a query is connected.
+  results.clear();
+  queryInternal("SELECT count(*) AS c FROM lazy_many_0;", results, dbc);
+  dbc->clearAffectedTables();
+  ASSERT_EQ(1U, results.size());
+  EXPECT_EQ("10", results[0]["c"]);
+  EXPECT_LT(definitions[0], tables[0]->definitions);
+  for (size_t i = 1; i < tables.size(); i++) {
+    EXPECT_EQ(definitions[i], tables[i]->definitions);
+  }
+
+  // Detaching connected and unused lazy tables keeps both usable.
+  EXPECT_TRUE(detachTableInternal("lazy_many_0", dbc).ok());
+  EXPECT_TRUE(detachTableInternal("lazy_many_1", dbc).ok());
+  for (const auto& name : {"lazy_many_0", "lazy_many_1"}) {
+    results.clear();
+    EXPECT_TRUE(queryInternal("SELECT count(*) AS c FROM " + std::string(name),
+                              results,
+                              dbc)
+                    .ok());
+    dbc->clearAffectedTables();
+    ASSERT_EQ(1U, results.size());
+    EXPECT_EQ("10", results[0]["c"]);
+  }
+  FLAGS_lazy_table_attach = false;
+}
+
 class colsUsedTablePlugin : public TablePlugin {
  private:
   TableColumns columns() const override {
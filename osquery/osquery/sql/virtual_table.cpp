@@ -8,6 +8,9 @@
  */
 
 #include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <unordered_set>
 
 #include <osquery/core/core.h>
@@ -18,7 +21,9 @@
 #include <osquery/process/process.h>
 #include <osquery/registry/registry_factory.h>
 #include <osquery/sql/dynamic_table_row.h>
+#include <osquery/sql/table_statistics.h>
 #include <osquery/sql/virtual_table.h>
+#include <osquery/utils/conversions/split.h>
 #include <osquery/utils/conversions/tryto.h>
 
 namespace osquery {
@@ -46,6 +51,16 @@ FLAG(bool,
 
 SHELL_FLAG(bool, planner, false, "Enable osquery runtime planner output");
 
+FLAG(bool,
+     lazy_table_attach,
+     false,
+     "Create table schemas when they are first used within a query");
+
+FLAG(bool,
+     planner_statistics,
+     true,
+     "Use observed table rows and latency to estimate query plan costs");
+
 DECLARE_bool(disable_events);
 
 RecursiveMutex kAttachMutex;
@@ -66,6 +81,12 @@ static std::atomic<size_t> kConstraintIndexID{0};
 /// We consider the max-cost as an error-state, e.g., unusable constraints.
 const double kMaxIndexCost{1000000};
 
+/// Scanning a table marked expensive is worse than any other scan.
+const double kExpensiveScanCost{kMaxIndexCost * 2};
+
+/// A missing required constraint must remain the worst possible choice.
+const double kMissingRequiredCost{kMaxIndexCost * 4};
+
 static inline std::string opString(unsigned char op) {
   switch (op) {
   case EQUALS:
@@ -349,9 +370,22 @@ int xDestroy(sqlite3_vtab* p) {
 int xNext(sqlite3_vtab_cursor* cur) {
   BaseCursor* pCur = (BaseCursor*)cur;
   if (pCur->uses_generator) {
-    pCur->generator->operator()();
+    if (pCur->profile != nullptr) {
+      // Generators produce rows lazily, each step is part of generate.
+      auto step_start = std::chrono::steady_clock::now();
+      pCur->generator->operator()();
+      pCur->profile->generate_micros +=
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - step_start)
+              .count();
+    } else {
+      pCur->generator->operator()();
+    }
     if (*pCur->generator) {
       pCur->current = pCur->generator->get();
+      if (pCur->profile != nullptr) {
+        pCur->profile->rows_produced++;
+      }
     }
   }
   pCur->row++;
@@ -675,10 +709,15 @@ int xCreate(sqlite3* db,
     }
   }
 
-  // Create the requested 'aliases'.
-  for (const auto& view : views) {
-    statement = "CREATE VIEW " + view + " AS SELECT * FROM " + name;
-    sqlite3_exec(db, statement.c_str(), nullptr, nullptr, nullptr);
+  // Create the requested 'aliases'. An eponymous table is connected while
+  // another statement is being prepared, its aliases were created on attach.
+  bool eponymous = (argc > 1 && argv[1] != nullptr &&
+                    std::strcmp(argv[1], "temp") != 0);
+  if (!eponymous) {
+    for (const auto& view : views) {
+      statement = "CREATE VIEW " + view + " AS SELECT * FROM " + name;
+      sqlite3_exec(db, statement.c_str(), nullptr, nullptr, nullptr);
+    }
   }
 
   *ppVtab = (sqlite3_vtab*)pVtab;
@@ -697,6 +736,11 @@ int xColumn(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col) {
     return SQLITE_ERROR;
   }
 
+  if (pCur->profile != nullptr && pCur->consumed_row != pCur->row) {
+    pCur->consumed_row = pCur->row;
+    pCur->profile->rows_consumed++;
+  }
+
   TableRowHolder& row =
       pCur->uses_generator ? pCur->current : pCur->rows[pCur->row];
   return row->get_column(ctx, cur->pVtab, col);
@@ -712,6 +756,92 @@ static inline bool sensibleComparison(ColumnType type, unsigned char op) {
   return true;
 }
 
+/**
+ * @brief Translate SQLite's colUsed mask into the used column names.
+ *
+ * Aliased columns are moved onto the column they alias.
+ *
+ * @return true if a REQUIRED column is used.
+ */
+static bool planUsedColumns(VirtualTableContent& content,
+                            UsedColumnsBitset& colsUsedBitset,
+                            UsedColumns& colsUsed) {
+  bool hasRequiredColumns = false;
+  if (!colsUsedBitset.any()) {
+    return hasRequiredColumns;
+  }
+
+  const auto& columns = content.columns;
+  for (size_t i = 0; i < columns.size(); i++) {
+    // Check whether the column is used. colUsed has one bit for each of the
+    // first 63 columns, and the 64th bit indicates that at least one other
+    // column is used.
+
+    auto bit = i < 63 ? i : 63U;
+    if (!colsUsedBitset[bit]) {
+      continue;
+    }
+
+    auto column_name = std::get<0>(columns[i]);
+    if (content.aliases.count(column_name)) {
+      colsUsedBitset.reset(bit);
+      auto real_column_index = content.aliases[column_name];
+      bit = real_column_index < 63 ? real_column_index : 63U;
+      colsUsedBitset.set(bit);
+      column_name = std::get<0>(columns[real_column_index]);
+    }
+    colsUsed.insert(column_name);
+
+    const auto& options = std::get<2>(columns[i]);
+    if (options & ColumnOptions::REQUIRED) {
+      hasRequiredColumns = true;
+    }
+  }
+  return hasRequiredColumns;
+}
+
+/**
+ * @brief Restore the constraint set and used columns of an index.
+ *
+ * The per-query plan state is cleared after each query but a prepared
+ * statement may be reused, calling xFilter with an index planned by an
+ * earlier query. xBestIndex encodes the plan into idxStr as the colUsed mask
+ * followed by a "column:op" term for each xFilter argument.
+ */
+static void restorePlan(VirtualTableContent& content,
+                        int idxNum,
+                        const char* idxStr) {
+  auto terms = osquery::split(idxStr, ";");
+  if (terms.empty()) {
+    return;
+  }
+
+  auto col_used = tryTo<unsigned long long>(terms[0]).takeOr(~0ULL);
+  UsedColumnsBitset colsUsedBitset(col_used);
+  UsedColumns colsUsed;
+  planUsedColumns(content, colsUsedBitset, colsUsed);
+
+  ConstraintSet constraints;
+  for (size_t i = 1; i < terms.size(); i++) {
+    auto term = osquery::split(terms[i], ":");
+    if (term.size() != 2) {
+      continue;
+    }
+    auto column = tryTo<size_t>(term[0]).takeOr(content.columns.size());
+    auto op = tryTo<unsigned int>(term[1]).takeOr(0U);
+    if (column >= content.columns.size()) {
+      continue;
+    }
+    constraints.push_back(std::make_pair(
+        std::get<0>(content.columns[column]),
+        Constraint(static_cast<unsigned char>(op))));
+  }
+
+  content.constraints[idxNum] = std::move(constraints);
+  content.colsUsed[idxNum] = std::move(colsUsed);
+  content.colsUsedBitsets[idxNum] = colsUsedBitset;
+}
+
 static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   auto* pVtab = (VirtualTable*)tab;
   const auto& columns = pVtab->content->columns;
@@ -719,6 +849,9 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   pVtab->instance->addAffectedTable(pVtab->content);
 
   ConstraintSet constraints;
+  // The encoded plan, see restorePlan.
+  auto idx_plan =
+      std::to_string(static_cast<unsigned long long>(pIdxInfo->colUsed));
   // Keep track of the index used for each valid constraint.
   // Expect this index to correspond with argv within xFilter.
   size_t expr_index = 0;
@@ -729,6 +862,9 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   bool hasRequiredColumns = false;
   bool hasRequiredConstraints = false;
 
+  // Equality constraints may be IN lists, with a scan per value.
+  bool hasEqualityConstraints = false;
+
   // Expressions operating on the same virtual table are loosely identified by
   // the consecutive sets of terms each of the constraint sets are applied onto.
   // Subsequent attempts from failed (unusable) constraints replace the set,
@@ -778,6 +914,11 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
       // name lookup through out all cursor constraint lists.
       constraints.push_back(
           std::make_pair(name, Constraint(constraint_info.op)));
+      idx_plan += ";" + std::to_string(constraint_info.iColumn) + ":" +
+                  std::to_string(constraint_info.op);
+      if (constraint_info.op == EQUALS) {
+        hasEqualityConstraints = true;
+      }
 
       // important: if we specify an index, it means xFilter will be called
       // once for every row.  So if you have an IN() list with 50 items,
@@ -801,44 +942,53 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   // track columns used
   UsedColumns colsUsed;
   UsedColumnsBitset colsUsedBitset(pIdxInfo->colUsed);
-  if (colsUsedBitset.any()) {
-    for (size_t i = 0; i < columns.size(); i++) {
-      // Check whether the column is used. colUsed has one bit for each of the
-      // first 63 columns, and the 64th bit indicates that at least one other
-      // column is used.
-
-      auto bit = i < 63 ? i : 63U;
-      if (!colsUsedBitset[bit]) {
-        continue;
-      }
+  hasRequiredColumns =
+      planUsedColumns(*pVtab->content, colsUsedBitset, colsUsed);
 
-      auto column_name = std::get<0>(columns[i]);
-      if (pVtab->content->aliases.count(column_name)) {
-        colsUsedBitset.reset(bit);
-        auto real_column_index = pVtab->content->aliases[column_name];
-        bit = real_column_index < 63 ? real_column_index : 63U;
-        colsUsedBitset.set(bit);
-        column_name = std::get<0>(columns[real_column_index]);
-      }
-      colsUsed.insert(column_name);
+  // Return max-cost if a required constraint is not present.
+  // For example, you can't do a hash of a file if path not provided.
+  if (hasRequiredColumns && !hasRequiredConstraints) {
+    cost = kMissingRequiredCost;
+  } else {
+    // Tables that are only cheap when constrained should not drive a JOIN.
+    bool constrained = !constraints.empty();
+    if (!constrained && (pVtab->content->attributes &
+                         TableAttributes::EXPENSIVE) > 0) {
+      cost = kExpensiveScanCost;
+    }
 
-      const auto& options = std::get<2>(columns[i]);
-      if (options & ColumnOptions::REQUIRED) {
-        hasRequiredColumns = true;
-      }
+    // Refine the spec-based cost using previous calls into this table. When
+    // constraints are used within a JOIN, xFilter is called once per outer row
+    // so both the per-call latency and the row estimate matter to SQLite.
+    TableCallStatistics observed;
+    if (FLAGS_planner_statistics &&
+        TableStatistics::get().lookup(
+            pVtab->content->name, constrained, observed)) {
+      cost += observed.micros / 1000;
+      pIdxInfo->estimatedRows =
+          std::max<sqlite3_int64>(1, std::llround(observed.rows));
     }
   }
 
-  // Return max-cost if a required constraint is not present.
-  // For example, you can't do a hash of a file if path not provided.
-  if (hasRequiredColumns && !hasRequiredConstraints) {
-    cost = kMaxIndexCost;
+  // Event subscribers emit rows from a time-sorted index, so a single
+  // ascending ORDER BY time does not require SQLite to sort the output.
+  auto time_ordered =
+      (pVtab->content->attributes & (TableAttributes::EVENT_BASED |
+                                     TableAttributes::TIME_ORDERED)) > 0;
+  if (time_ordered && pIdxInfo->nOrderBy == 1 && !hasEqualityConstraints) {
+    const auto& order_by = pIdxInfo->aOrderBy[0];
+    if (!order_by.desc && order_by.iColumn >= 0 &&
+        static_cast<size_t>(order_by.iColumn) < columns.size() &&
+        std::get<0>(columns[order_by.iColumn]) == "time") {
+      pIdxInfo->orderByConsumed = 1;
+    }
   }
 
   pIdxInfo->idxNum = static_cast<int>(kConstraintIndexID++);
   if (FLAGS_planner) {
     plan("xBestIndex Recording constraint set for table: " +
          pVtab->content->name + " [cost=" + std::to_string(cost) +
+         " rows=" + std::to_string(pIdxInfo->estimatedRows) +
          " size=" + std::to_string(constraints.size()) +
          " idx=" + std::to_string(pIdxInfo->idxNum) + "]");
   }
@@ -846,6 +996,8 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   pVtab->content->constraints[pIdxInfo->idxNum] = std::move(constraints);
   pVtab->content->colsUsed[pIdxInfo->idxNum] = std::move(colsUsed);
   pVtab->content->colsUsedBitsets[pIdxInfo->idxNum] = colsUsedBitset;
+  pIdxInfo->idxStr = sqlite3_mprintf("%s", idx_plan.c_str());
+  pIdxInfo->needToFreeIdxStr = 1;
   pIdxInfo->estimatedCost = cost;
 
   return SQLITE_OK;
@@ -864,11 +1016,24 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
     sleepFor(FLAGS_table_delay);
   }
   pVtab->instance->addAffectedTable(content);
+  if (idxStr != nullptr && content->colsUsedBitsets.count(idxNum) == 0) {
+    // The statement was prepared, and planned, by an earlier query.
+    restorePlan(*content, idxNum, idxStr);
+  }
 
   pCur->row = 0;
   pCur->n = 0;
+  pCur->consumed_row = std::numeric_limits<size_t>::max();
   QueryContext context(content);
 
+  auto* query_profile = ScopedQueryProfile::active();
+  pCur->profile =
+      (query_profile != nullptr) ? &query_profile->tables[content->name]
+                                 : nullptr;
+  if (pCur->profile != nullptr) {
+    pCur->profile->filters++;
+  }
+
   // The SQLite instance communicates to the TablePlugin via the context.
   context.useCache(pVtab->instance->useCache());
 
@@ -995,6 +1160,7 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
 
   // Generate the row data set.
   plan("Scanning rows for cursor (" + std::to_string(pCur->id) + ")");
+  auto generate_start = std::chrono::steady_clock::now();
   if (Registry::get().exists("table", pVtab->content->name, true)) {
     auto plugin = Registry::get().plugin("table", pVtab->content->name);
     auto table = std::dynamic_pointer_cast<TablePlugin>(plugin);
@@ -1008,6 +1174,15 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
                       std::move(context)));
         if (*pCur->generator) {
           pCur->current = pCur->generator->get();
+          if (pCur->profile != nullptr) {
+            pCur->profile->rows_produced++;
+          }
+        }
+        if (pCur->profile != nullptr) {
+          pCur->profile->generate_micros +=
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - generate_start)
+                  .count();
         }
         return SQLITE_OK;
       }
@@ -1038,6 +1213,18 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
   // Set the number of rows.
   pCur->n = pCur->rows.size();
 
+  // Feed the observed cost of this call back into future plans.
+  auto generate_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - generate_start);
+  TableStatistics::get().record(pVtab->content->name,
+                                argc > 0,
+                                pCur->n,
+                                generate_micros.count());
+  if (pCur->profile != nullptr) {
+    pCur->profile->generate_micros += generate_micros.count();
+    pCur->profile->rows_produced += pCur->n;
+  }
+
   if (FLAGS_planner) {
     plan("xFilter " + pVtab->content->name +
          " generate returned row count:" + std::to_string(pCur->n));
@@ -1083,6 +1270,14 @@ struct sqlite3_module* getVirtualTableModule(const std::string& table_name,
 } // namespace sqlite
 } // namespace tables
 
+/// Cached statements may reference a table that is being changed.
+static void clearStatements(const SQLiteDBInstanceRef& instance) {
+  auto* statements = instance->statements();
+  if (statements != nullptr) {
+    statements->clear();
+  }
+}
+
 Status attachTableInternal(const std::string& name,
                            const SQLiteDBInstanceRef& instance,
                            bool is_extension) {
@@ -1102,6 +1297,7 @@ Status attachTableInternal(const std::string& name,
   // Note, if the clientData API is used then this will save a registry call
   // within xCreate.
   auto lock(instance->attachLock());
+  clearStatements(instance);
 
   int rc = sqlite3_create_module(
       instance->db(), name.c_str(), module, (void*)&(*instance));
@@ -1122,13 +1318,71 @@ Status attachTableInternal(const std::string& name,
   return Status(rc, getStringForSQLiteReturnCode(rc));
 }
 
+/**
+ * @brief Attach a table without creating its schema.
+ *
+ * The module's xCreate and xConnect are the same method, so SQLite treats
+ * each module as an eponymous virtual table. The first statement referencing
+ * the table by name connects it and declares the schema. Only the aliases,
+ * which are views, must be created up front.
+ */
+static Status attachTableLazy(const std::string& name,
+                              const std::vector<std::string>& aliases,
+                              const SQLiteDBInstanceRef& instance) {
+  if (SQLiteDBManager::isDisabled(name)) {
+    VLOG(1) << "Table " << name << " is disabled, not attaching";
+    return Status(0, getStringForSQLiteReturnCode(0));
+  }
+
+  struct sqlite3_module* module =
+      tables::sqlite::getVirtualTableModule(name, false);
+  if (module == nullptr) {
+    VLOG(1) << "Failed to retrieve the virtual table module for \"" << name
+            << "\"";
+    return Status(1);
+  }
+
+  auto lock(instance->attachLock());
+  clearStatements(instance);
+  int rc = sqlite3_create_module(
+      instance->db(), name.c_str(), module, (void*)&(*instance));
+  if (rc != SQLITE_OK && rc != SQLITE_MISUSE) {
+    LOG(ERROR) << "Error attaching table: " << name << " (" << rc << ")";
+    return Status(rc, getStringForSQLiteReturnCode(rc));
+  }
+
+  for (const auto& alias : aliases) {
+    auto format =
+        "CREATE VIEW IF NOT EXISTS " + alias + " AS SELECT * FROM " + name;
+    sqlite3_exec(instance->db(), format.c_str(), nullptr, nullptr, nullptr);
+  }
+
+  return Status(0, getStringForSQLiteReturnCode(0));
+}
+
 Status detachTableInternal(const std::string& name,
                            const SQLiteDBInstanceRef& instance) {
   auto lock(instance->attachLock());
+  clearStatements(instance);
+
+  // Only a table created by name is removed, a lazily attached one is kept.
+  bool created = sqlite3_table_column_metadata(instance->db(),
+                                               "temp",
+                                               name.c_str(),
+                                               nullptr,
+                                               nullptr,
+                                               nullptr,
+                                               nullptr,
+                                               nullptr,
+                                               nullptr) == SQLITE_OK;
+
   auto format = "DROP TABLE IF EXISTS temp." + name;
   int rc = sqlite3_exec(instance->db(), format.c_str(), nullptr, nullptr, 0);
   if (rc != SQLITE_OK) {
     LOG(ERROR) << "Error detaching table: " << name << " (" << rc << ")";
+  } else if (FLAGS_lazy_table_attach && created) {
+    // Remove the module so the eponymous table cannot be connected again.
+    rc = sqlite3_create_module(instance->db(), name.c_str(), nullptr, nullptr);
   }
 
   return Status(rc, getStringForSQLiteReturnCode(rc));
@@ -1166,6 +1420,16 @@ void attachVirtualTables(const SQLiteDBInstanceRef& instance) {
   bool is_extension = false;
 
   for (const auto& name : RegistryFactory::get().names("table")) {
+    if (FLAGS_lazy_table_attach) {
+      // Internal tables are attached without requesting their columns.
+      auto table = std::dynamic_pointer_cast<TablePlugin>(
+          RegistryFactory::get().plugin("table", name));
+      if (table != nullptr) {
+        attachTableLazy(name, table->aliases(), instance);
+        continue;
+      }
+    }
+
     auto status =
         Registry::call("table", name, {{"action", "columns"}}, response);
     if (status.ok()) {
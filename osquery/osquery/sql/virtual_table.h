@@ -9,11 +9,13 @@
 
 #pragma once
 
+#include <limits>
 #include <memory>
 
 #include <boost/noncopyable.hpp>
 
 #include <osquery/core/tables.h>
+#include <osquery/sql/query_profile.h>
 #include <osquery/sql/sqlite_util.h>
 
 namespace osquery {
@@ -58,6 +60,12 @@ struct BaseCursor : private boost::noncopyable {
 
   /// Total number of rows.
   size_t n{0};
+
+  /// Query profile entry for this table, if the query is being profiled.
+  TableProfile* profile{nullptr};
+
+  /// Last row counted as consumed by the query profile.
+  size_t consumed_row{std::numeric_limits<size_t>::max()};
 };
 
 /**
@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <osquery/system/usersgroups/linux/users_groups_cache.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/filesystem/filesystem.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+DECLARE_bool(users_groups_nss);
+
+const std::string kPasswd =
+    "# comment\n"
+    "root:x:0:0:root:/root:/bin/bash\n"
+    "alice:x:1000:1000::/home/alice:/bin/zsh\n"
+    "toor:x:0:0:second root:/root:/bin/sh\n"
+    "+nisuser::::::\n"
+    "broken:x:abc:0::/:/bin/false\n"
+    "short:x:1001\n"
+    "\n";
+
+const std::string kGroup =
+    "root:x:0:\n"
+    "wheel:x:10:alice,bob\n"
+    "users:x:100:alice\n"
+    "alice:x:1000:alice\n"
+    "wheel2:x:10:carol\n";
+
+class UsersGroupsCacheTests : public testing::Test {
+ public:
+  UsersGroupsCacheTests()
+      : dir_(fs::temp_directory_path() /
+             fs::unique_path("osquery.usersgroups.%%%%.%%%%")) {}
+
+  void SetUp() override {
+    fs::create_directories(dir_);
+    nss_ = FLAGS_users_groups_nss;
+    FLAGS_users_groups_nss = false;
+  }
+
+  void TearDown() override {
+    FLAGS_users_groups_nss = nss_;
+    fs::remove_all(dir_);
+  }
+
+ protected:
+  fs::path dir_;
+
+ private:
+  bool nss_{true};
+};
+
+TEST_F(UsersGroupsCacheTests, test_parse_passwd) {
+  auto users = parsePasswd(kPasswd);
+  ASSERT_EQ(3U, users.size());
+
+  EXPECT_EQ("root", users[0].username);
+  EXPECT_EQ(0U, users[0].uid);
+  EXPECT_EQ("/bin/bash", users[0].shell);
+
+  EXPECT_EQ("alice", users[1].username);
+  EXPECT_EQ(1000U, users[1].uid);
+  EXPECT_EQ(1000U, users[1].gid);
+  EXPECT_EQ("", users[1].description);
+  EXPECT_EQ("/home/alice", users[1].directory);
+
+  EXPECT_EQ("toor", users[2].username);
+}
+
+TEST_F(UsersGroupsCacheTests, test_parse_group) {
+  auto groups = parseGroup(kGroup);
+  ASSERT_EQ(5U, groups.size());
+
+  EXPECT_EQ("root", groups[0].groupname);
+  EXPECT_TRUE(groups[0].members.empty());
+  EXPECT_EQ(10U, groups[1].gid);
+  EXPECT_EQ(std::vector<std::string>({"alice", "bob"}), groups[1].members);
+}
+
+TEST_F(UsersGroupsCacheTests, test_index_lookups) {
+  UsersGroupsIndex index(parsePasswd(kPasswd), parseGroup(kGroup), false);
+
+  // Every entry is enumerated, the first entry of an id is looked up.
+  EXPECT_EQ(3U, index.getUsers().size());
+  auto root = index.getUserByUid(0);
+  ASSERT_TRUE(root.has_value());
+  EXPECT_EQ("root", root->username);
+  ASSERT_TRUE(index.getUserByName("toor").has_value());
+  EXPECT_FALSE(index.getUserByUid(4242).has_value());
+  EXPECT_FALSE(index.getUserByName("nobody").has_value());
+
+  EXPECT_EQ(4U, index.getGroups().size());
+  auto wheel = index.getGroupByGid(10);
+  ASSERT_TRUE(wheel.has_value());
+  EXPECT_EQ("wheel", wheel->groupname);
+  EXPECT_FALSE(index.getGroupByGid(4242).has_value());
+
+  // The primary group comes first and is not repeated.
+  auto alice = index.getUserByName("alice");
+  ASSERT_TRUE(alice.has_value());
+  EXPECT_EQ(std::vector<gid_t>({1000, 10, 100}),
+            index.getGroupsForUser(*alice));
+  EXPECT_EQ(std::vector<gid_t>({0}), index.getGroupsForUser(*root));
+}
+
+TEST_F(UsersGroupsCacheTests, test_cache_reload) {
+  auto passwd = (dir_ / "passwd").string();
+  auto group = (dir_ / "group").string();
+  ASSERT_TRUE(writeTextFile(passwd, kPasswd).ok());
+  ASSERT_TRUE(writeTextFile(group, kGroup).ok());
+
+  UsersGroupsCache cache(passwd, group, (dir_ / "nsswitch.conf").string());
+  auto index = cache.getIndex();
+  EXPECT_EQ(3U, index->getUsers().size());
+
+  // An unchanged system shares the index.
+  EXPECT_EQ(index, cache.getIndex());
+
+  // Adding a user changes the passwd file.
+  auto bob = "bob:x:1002:100::/home/bob:/bin/sh\n";
+  ASSERT_TRUE(writeTextFile(passwd, bob).ok());
+  auto reloaded = cache.getIndex();
+  EXPECT_NE(index, reloaded);
+  EXPECT_EQ(4U, reloaded->getUsers().size());
+  EXPECT_TRUE(reloaded->getUserByUid(1002).has_value());
+
+  cache.clear();
+  EXPECT_NE(reloaded, cache.getIndex());
+}
+
+} // namespace osquery
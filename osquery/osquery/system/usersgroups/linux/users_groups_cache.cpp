@@ -0,0 +1,445 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <limits>
+
+#include <grp.h>
+#include <pwd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+
+#include <osquery/core/flags.h>
+#include <osquery/filesystem/filesystem.h>
+#include <osquery/logger/logger.h>
+#include <osquery/system/usersgroups/linux/users_groups_cache.h>
+#include <osquery/utils/conversions/tryto.h>
+
+namespace osquery {
+
+FLAG(bool,
+     users_groups_nss,
+     true,
+     "Enumerate users and groups through NSS, false reads /etc/passwd and "
+     "/etc/group directly");
+
+FLAG(uint64,
+     users_groups_cache_ttl,
+     300,
+     "Seconds users and groups enumerated through NSS are cached while "
+     "/etc/passwd, /etc/group and /etc/nsswitch.conf are unchanged");
+
+namespace {
+
+/// Initial size of the buffers of the reentrant NSS getters.
+const std::size_t kNSSBufferSize{16384};
+
+/// NSS getters fail with ERANGE until the buffer grows to this size.
+const std::size_t kNSSBufferMaxSize{16 * 1024 * 1024};
+
+std::vector<std::string> splitFields(const std::string& line, char delim) {
+  std::vector<std::string> fields;
+  boost::split(fields, line, [delim](char c) { return c == delim; });
+  return fields;
+}
+
+std::optional<std::uint32_t> parseId(const std::string& field) {
+  auto id = tryTo<long long>(field, 10);
+  if (id.isError() || id.get() < 0 ||
+      id.get() > std::numeric_limits<std::uint32_t>::max()) {
+    return std::nullopt;
+  }
+  return static_cast<std::uint32_t>(id.get());
+}
+
+/// Skip blank lines, comments and NIS compat entries.
+bool isEntry(const std::string& line) {
+  return !line.empty() && line[0] != '#' && line[0] != '+' && line[0] != '-';
+}
+
+User makeUser(const struct passwd* pwd) {
+  User user;
+  user.uid = pwd->pw_uid;
+  user.gid = pwd->pw_gid;
+  if (pwd->pw_name != nullptr) {
+    user.username = pwd->pw_name;
+  }
+
+  if (pwd->pw_gecos != nullptr) {
+    user.description = pwd->pw_gecos;
+  }
+
+  if (pwd->pw_dir != nullptr) {
+    user.directory = pwd->pw_dir;
+  }
+
+  if (pwd->pw_shell != nullptr) {
+    user.shell = pwd->pw_shell;
+  }
+  return user;
+}
+
+Group makeGroup(const struct group* grp) {
+  Group group;
+  group.gid = grp->gr_gid;
+  if (grp->gr_name != nullptr) {
+    group.groupname = grp->gr_name;
+  }
+
+  if (grp->gr_mem != nullptr) {
+    for (auto member = grp->gr_mem; *member != nullptr; ++member) {
+      group.members.push_back(*member);
+    }
+  }
+  return group;
+}
+
+/**
+ * @brief Call a reentrant NSS getter, growing the buffer on ERANGE.
+ *
+ * Returns true if the getter found an entry.
+ */
+template <typename Entry, typename Getter>
+bool callNSS(std::vector<char>& buffer, Entry& entry, Getter getter) {
+  while (true) {
+    Entry* result{nullptr};
+    auto error = getter(&entry, buffer.data(), buffer.size(), &result);
+    if (error == ERANGE && buffer.size() < kNSSBufferMaxSize) {
+      buffer.resize(buffer.size() * 2);
+      continue;
+    }
+    return error == 0 && result != nullptr;
+  }
+}
+
+} // namespace
+
+std::vector<User> parsePasswd(const std::string& content) {
+  std::vector<User> users;
+  for (const auto& line : splitFields(content, '\n')) {
+    if (!isEntry(line)) {
+      continue;
+    }
+
+    auto fields = splitFields(line, ':');
+    if (fields.size() != 7) {
+      continue;
+    }
+
+    auto uid = parseId(fields[2]);
+    auto gid = parseId(fields[3]);
+    if (!uid.has_value() || !gid.has_value()) {
+      continue;
+    }
+
+    User user;
+    user.uid = *uid;
+    user.gid = *gid;
+    user.username = std::move(fields[0]);
+    user.description = std::move(fields[4]);
+    user.directory = std::move(fields[5]);
+    user.shell = std::move(fields[6]);
+    users.push_back(std::move(user));
+  }
+  return users;
+}
+
+std::vector<Group> parseGroup(const std::string& content) {
+  std::vector<Group> groups;
+  for (const auto& line : splitFields(content, '\n')) {
+    if (!isEntry(line)) {
+      continue;
+    }
+
+    auto fields = splitFields(line, ':');
+    if (fields.size() != 4) {
+      continue;
+    }
+
+    auto gid = parseId(fields[2]);
+    if (!gid.has_value()) {
+      continue;
+    }
+
+    Group group;
+    group.gid = *gid;
+    group.groupname = std::move(fields[0]);
+    if (!fields[3].empty()) {
+      group.members = splitFields(fields[3], ',');
+    }
+    groups.push_back(std::move(group));
+  }
+  return groups;
+}
+
+UsersGroupsIndex::UsersGroupsIndex(std::vector<User> users,
+                                   std::vector<Group> groups,
+                                   bool nss)
+    : users_(std::move(users)), nss_(nss) {
+  for (std::size_t i = 0; i < users_.size(); ++i) {
+    uid_index_.emplace(users_[i].uid, i);
+    username_index_.emplace(users_[i].username, i);
+  }
+
+  for (auto& group : groups) {
+    for (const auto& member : group.members) {
+      member_index_[member].push_back(group.gid);
+    }
+
+    if (gid_index_.emplace(group.gid, groups_.size()).second) {
+      groups_.push_back(std::move(group));
+    }
+  }
+}
+
+std::shared_ptr<UsersGroupsIndex> UsersGroupsIndex::loadFromNSS() {
+  std::vector<char> buffer(kNSSBufferSize);
+
+  std::vector<User> users;
+  struct passwd pwd;
+  setpwent();
+  while (callNSS(buffer, pwd, [](auto... args) {
+    return getpwent_r(args...);
+  })) {
+    users.push_back(makeUser(&pwd));
+  }
+  endpwent();
+
+  std::vector<Group> groups;
+  struct group grp;
+  setgrent();
+  while (callNSS(buffer, grp, [](auto... args) {
+    return getgrent_r(args...);
+  })) {
+    groups.push_back(makeGroup(&grp));
+  }
+  endgrent();
+
+  return std::make_shared<UsersGroupsIndex>(
+      std::move(users), std::move(groups), true);
+}
+
+std::shared_ptr<UsersGroupsIndex> UsersGroupsIndex::loadFromFiles(
+    const std::string& passwd_path, const std::string& group_path) {
+  std::string passwd;
+  if (!readFile(passwd_path, passwd).ok()) {
+    VLOG(1) << "Cannot read users from " << passwd_path;
+  }
+
+  std::string group;
+  if (!readFile(group_path, group).ok()) {
+    VLOG(1) << "Cannot read groups from " << group_path;
+  }
+
+  return std::make_shared<UsersGroupsIndex>(
+      parsePasswd(passwd), parseGroup(group), false);
+}
+
+const std::vector<User>& UsersGroupsIndex::getUsers() const {
+  return users_;
+}
+
+const std::vector<Group>& UsersGroupsIndex::getGroups() const {
+  return groups_;
+}
+
+std::optional<User> UsersGroupsIndex::getUserByUid(uid_t uid) const {
+  auto it = uid_index_.find(uid);
+  if (it != uid_index_.end()) {
+    return users_[it->second];
+  }
+
+  if (!nss_) {
+    return std::nullopt;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto lookup = uid_lookups_.find(uid);
+  if (lookup != uid_lookups_.end()) {
+    return lookup->second;
+  }
+
+  std::optional<User> user;
+  std::vector<char> buffer(kNSSBufferSize);
+  struct passwd pwd;
+  if (callNSS(buffer, pwd, [uid](auto... args) {
+        return getpwuid_r(uid, args...);
+      })) {
+    user = makeUser(&pwd);
+  }
+  uid_lookups_.emplace(uid, user);
+  return user;
+}
+
+std::optional<User> UsersGroupsIndex::getUserByName(
+    const std::string& username) const {
+  auto it = username_index_.find(username);
+  if (it != username_index_.end()) {
+    return users_[it->second];
+  }
+
+  if (!nss_) {
+    return std::nullopt;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto lookup = username_lookups_.find(username);
+  if (lookup != username_lookups_.end()) {
+    return lookup->second;
+  }
+
+  std::optional<User> user;
+  std::vector<char> buffer(kNSSBufferSize);
+  struct passwd pwd;
+  if (callNSS(buffer, pwd, [&username](auto... args) {
+        return getpwnam_r(username.c_str(), args...);
+      })) {
+    user = makeUser(&pwd);
+  }
+  username_lookups_.emplace(username, user);
+  return user;
+}
+
+std::optional<Group> UsersGroupsIndex::getGroupByGid(gid_t gid) const {
+  auto it = gid_index_.find(gid);
+  if (it != gid_index_.end()) {
+    return groups_[it->second];
+  }
+
+  if (!nss_) {
+    return std::nullopt;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto lookup = gid_lookups_.find(gid);
+  if (lookup != gid_lookups_.end()) {
+    return lookup->second;
+  }
+
+  std::optional<Group> group;
+  std::vector<char> buffer(kNSSBufferSize);
+  struct group grp;
+  if (callNSS(buffer, grp, [gid](auto... args) {
+        return getgrgid_r(gid, args...);
+      })) {
+    group = makeGroup(&grp);
+  }
+  gid_lookups_.emplace(gid, group);
+  return group;
+}
+
+std::vector<gid_t> UsersGroupsIndex::getGroupsForUser(const User& user) const {
+  if (!nss_) {
+    std::vector<gid_t> gids{user.gid};
+    auto it = member_index_.find(user.username);
+    if (it != member_index_.end()) {
+      for (auto gid : it->second) {
+        if (std::find(gids.begin(), gids.end(), gid) == gids.end()) {
+          gids.push_back(gid);
+        }
+      }
+    }
+    return gids;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto lookup = group_lists_.find(user.username);
+  if (lookup != group_lists_.end()) {
+    return lookup->second;
+  }
+
+  // Memberships may come from NSS sources that cannot be enumerated.
+  int count = 64;
+  std::vector<gid_t> gids(count);
+  if (getgrouplist(user.username.c_str(), user.gid, gids.data(), &count) < 0) {
+    gids.resize(count);
+    if (getgrouplist(
+            user.username.c_str(), user.gid, gids.data(), &count) < 0) {
+      TLOG << "Could not get users group list";
+      count = 0;
+    }
+  }
+  gids.resize(count);
+  group_lists_.emplace(user.username, gids);
+  return gids;
+}
+
+bool UsersGroupsCache::FileStamp::operator==(const FileStamp& other) const {
+  return exists == other.exists && inode == other.inode &&
+         size == other.size && mtime_ns == other.mtime_ns;
+}
+
+UsersGroupsCache::UsersGroupsCache(std::string passwd_path,
+                                   std::string group_path,
+                                   std::string nsswitch_path)
+    : passwd_path_(std::move(passwd_path)),
+      group_path_(std::move(group_path)),
+      nsswitch_path_(std::move(nsswitch_path)) {}
+
+UsersGroupsCache& UsersGroupsCache::get() {
+  static UsersGroupsCache cache(
+      "/etc/passwd", "/etc/group", "/etc/nsswitch.conf");
+  return cache;
+}
+
+std::vector<UsersGroupsCache::FileStamp> UsersGroupsCache::getStamps() const {
+  std::vector<FileStamp> stamps;
+  for (const auto& path : {passwd_path_, group_path_, nsswitch_path_}) {
+    FileStamp stamp;
+    struct stat info;
+    if (::stat(path.c_str(), &info) == 0) {
+      stamp.exists = true;
+      stamp.inode = info.st_ino;
+      stamp.size = info.st_size;
+      stamp.mtime_ns =
+          static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 +
+          info.st_mtim.tv_nsec;
+    }
+    stamps.push_back(stamp);
+  }
+  return stamps;
+}
+
+std::shared_ptr<const UsersGroupsIndex> UsersGroupsCache::getIndex() {
+  bool nss = FLAGS_users_groups_nss;
+  auto stamps = getStamps();
+  auto now = std::chrono::steady_clock::now();
+
+  // Concurrent queries wait for a single reload.
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto ttl = std::chrono::seconds(FLAGS_users_groups_cache_ttl);
+  auto expired = nss && now - loaded_ >= ttl;
+  if (index_ != nullptr && nss == nss_ && stamps == stamps_ && !expired) {
+    return index_;
+  }
+
+  if (nss) {
+    index_ = UsersGroupsIndex::loadFromNSS();
+  } else {
+    index_ = UsersGroupsIndex::loadFromFiles(passwd_path_, group_path_);
+  }
+  VLOG(1) << "Loaded " << index_->getUsers().size() << " users and "
+          << index_->getGroups().size() << " groups";
+
+  nss_ = nss;
+  stamps_ = std::move(stamps);
+  loaded_ = now;
+  return index_;
+}
+
+void UsersGroupsCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  index_.reset();
+}
+
+} // namespace osquery
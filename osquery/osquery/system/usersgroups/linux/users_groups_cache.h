@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/utils/status/status.h>
+
+namespace osquery {
+
+struct User {
+  uid_t uid{0};
+  gid_t gid{0};
+  std::string username;
+  std::string description;
+  std::string directory;
+  std::string shell;
+};
+
+struct Group {
+  gid_t gid{0};
+  std::string groupname;
+  std::vector<std::string> members;
+};
+
+/// Parse the content of an /etc/passwd formatted file.
+std::vector<User> parsePasswd(const std::string& content);
+
+/// Parse the content of an /etc/group formatted file.
+std::vector<Group> parseGroup(const std::string& content);
+
+/**
+ * @brief A snapshot of the users and groups of the system, indexed by id.
+ *
+ * Lookups are hash lookups into the snapshot. When the snapshot was
+ * enumerated through NSS, ids and names missing from it are resolved with
+ * the reentrant NSS getters and remembered, since NSS sources such as LDAP
+ * may not allow enumeration.
+ */
+class UsersGroupsIndex : private boost::noncopyable {
+ public:
+  UsersGroupsIndex(std::vector<User> users,
+                   std::vector<Group> groups,
+                   bool nss);
+
+  /// Enumerate users and groups through NSS.
+  static std::shared_ptr<UsersGroupsIndex> loadFromNSS();
+
+  /// Read users and groups from passwd and group files, bypassing NSS.
+  static std::shared_ptr<UsersGroupsIndex> loadFromFiles(
+      const std::string& passwd_path, const std::string& group_path);
+
+  /// All enumerated users, duplicated uids are kept.
+  const std::vector<User>& getUsers() const;
+
+  /// All enumerated groups, the first entry of a gid wins.
+  const std::vector<Group>& getGroups() const;
+
+  std::optional<User> getUserByUid(uid_t uid) const;
+  std::optional<User> getUserByName(const std::string& username) const;
+  std::optional<Group> getGroupByGid(gid_t gid) const;
+
+  /// The primary and supplementary group ids of a user.
+  std::vector<gid_t> getGroupsForUser(const User& user) const;
+
+ private:
+  std::vector<User> users_;
+  std::vector<Group> groups_;
+  std::unordered_map<uid_t, std::size_t> uid_index_;
+  std::unordered_map<std::string, std::size_t> username_index_;
+  std::unordered_map<gid_t, std::size_t> gid_index_;
+
+  /// Supplementary group ids by member name, used without NSS.
+  std::unordered_map<std::string, std::vector<gid_t>> member_index_;
+
+  /// Resolve misses through NSS.
+  bool nss_{false};
+
+  /// NSS lookups of ids and names missing from the enumeration.
+  mutable std::mutex mutex_;
+  mutable std::unordered_map<uid_t, std::optional<User>> uid_lookups_;
+  mutable std::unordered_map<std::string, std::optional<User>>
+      username_lookups_;
+  mutable std::unordered_map<gid_t, std::optional<Group>> gid_lookups_;
+  mutable std::unordered_map<std::string, std::vector<gid_t>> group_lists_;
+};
+
+/**
+ * @brief Shares a UsersGroupsIndex between queries until the system changes.
+ *
+ * The index is reloaded when the passwd, group or nsswitch.conf file
+ * changes. An index enumerated through NSS is also reloaded once it is
+ * older than users_groups_cache_ttl, as remote directories change without
+ * touching local files.
+ */
+class UsersGroupsCache : private boost::noncopyable {
+ public:
+  UsersGroupsCache(std::string passwd_path,
+                   std::string group_path,
+                   std::string nsswitch_path);
+
+  /// The cache of the system files, shared by tables.
+  static UsersGroupsCache& get();
+
+  /// Return the current index, reloading it if it is stale.
+  std::shared_ptr<const UsersGroupsIndex> getIndex();
+
+  /// Drop the current index, the next getIndex reloads it.
+  void clear();
+
+ private:
+  /// Identity of a source file, changes when the file is modified.
+  struct FileStamp {
+    bool exists{false};
+    ino_t inode{0};
+    off_t size{0};
+    std::int64_t mtime_ns{0};
+
+    bool operator==(const FileStamp& other) const;
+  };
+
+  std::vector<FileStamp> getStamps() const;
+
+ private:
+  const std::string passwd_path_;
+  const std::string group_path_;
+  const std::string nsswitch_path_;
+
+  std::mutex mutex_;
+  std::shared_ptr<UsersGroupsIndex> index_;
+  std::vector<FileStamp> stamps_;
+  bool nss_{false};
+  std::chrono::steady_clock::time_point loaded_;
+};
+
+} // namespace osquery
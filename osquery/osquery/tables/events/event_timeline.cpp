@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <osquery/core/tables.h>
+#include <osquery/events/eventfactory.h>
+#include <osquery/events/eventsubscriber.h>
+#include <osquery/events/eventtimeline.h>
+#include <osquery/sql/dynamic_table_row.h>
+
+namespace osquery {
+namespace tables {
+
+void genEventTimeline(RowYield& yield, QueryContext& context) {
+  EventTime start = 0, stop = 0;
+  if (!EventSubscriberPlugin::getTimeBounds(context, start, stop)) {
+    return;
+  }
+
+  auto names = context.constraints["source"].getAll(EQUALS);
+
+  // Keep the subscribers alive while their indexes are merged.
+  std::vector<EventSubscriberRef> subscribers;
+  std::vector<EventTimeline::Source> sources;
+  for (const auto& name : EventFactory::subscriberNames()) {
+    if (!names.empty() && names.count(name) == 0) {
+      continue;
+    }
+
+    auto subscriber = EventFactory::getEventSubscriber(name);
+    if (subscriber == nullptr) {
+      continue;
+    }
+
+    sources.push_back(EventTimeline::getSource(*subscriber));
+    subscribers.push_back(std::move(subscriber));
+  }
+
+  // Rows are read lazily, a LIMIT stops the merge and the backing store reads.
+  EventTimeline timeline(
+      std::move(sources), start, stop, context.isColumnUsed("data"));
+
+  EventTimeline::Event event;
+  while (timeline.next(event)) {
+    auto r = make_table_row();
+    r["time"] = BIGINT(event.time);
+    r["source"] = event.source;
+    r["eid"] = EventSubscriberPlugin::toIndex(event.eid);
+    r["data"] = std::move(event.data);
+    yield(std::move(r));
+  }
+}
+
+} // namespace tables
+} // namespace osquery
@@ -30,16 +30,21 @@ void decorateFileEvent(const std::string& path, bool hash, Row& r) {
   }
 
   if (hash) {
-    auto hashes = hashMultiFromFile(
-        HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
-    r["md5"] = std::move(hashes.md5);
-    r["sha1"] = std::move(hashes.sha1);
-    r["sha256"] = std::move(hashes.sha256);
-    // Hashed determines the success/status of hashing, -1 failed, 1 success.
-    r["hashed"] = (r.at("md5").empty()) ? "-1" : "1";
+    setFileEventHashes(
+        hashMultiFromFile(
+            HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path),
+        r);
   } else {
     // Alternatively if hashing wasn't needed hashed is a 0.
     r["hashed"] = "0";
   }
 }
+
+void setFileEventHashes(const MultiHashes& hashes, Row& r) {
+  r["md5"] = hashes.md5;
+  r["sha1"] = hashes.sha1;
+  r["sha256"] = hashes.sha256;
+  // Hashed determines the success/status of hashing, -1 failed, 1 success.
+  r["hashed"] = (hashes.md5.empty()) ? "-1" : "1";
+}
 }
@@ -13,6 +13,7 @@
 #include <string>
 
 #include <osquery/core/tables.h>
+#include <osquery/hashing/hashing.h>
 
 namespace osquery {
 
@@ -30,4 +31,12 @@ extern const std::set<std::string> kCommonFileColumns;
  * @param r The output parameter row structure.
  */
 void decorateFileEvent(const std::string& path, bool hash, Row& r);
+
+/**
+ * @brief Set the hash columns of a file event from hashes of its target path.
+ *
+ * @param hashes The MD5, SHA1, and SHA256 hashes of the target path.
+ * @param r The output parameter row structure.
+ */
+void setFileEventHashes(const MultiHashes& hashes, Row& r);
 }
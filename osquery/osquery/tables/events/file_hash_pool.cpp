@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <osquery/hashing/hashing.h>
+#include <osquery/numeric_monitoring/numeric_monitoring.h>
+#include <osquery/tables/events/event_utils.h>
+#include <osquery/tables/events/file_hash_pool.h>
+
+namespace osquery {
+
+FileHashPool::FileHashPool(std::size_t workers,
+                           std::size_t max_backlog,
+                           std::chrono::milliseconds window,
+                           Completion completion)
+    : max_backlog_(max_backlog),
+      window_(window),
+      completion_(std::move(completion)) {
+  workers_.reserve(workers);
+  for (std::size_t i = 0; i < workers; ++i) {
+    workers_.emplace_back([this]() { work(); });
+  }
+}
+
+FileHashPool::~FileHashPool() {
+  stop();
+}
+
+bool FileHashPool::enqueue(const std::string& path, Row& r) {
+  // Hard links share content, so repeated events are keyed by inode.
+  auto inode = r.find("inode");
+  auto key =
+      (inode != r.end() && !inode->second.empty()) ? inode->second : path;
+
+  std::size_t backlog = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_ || workers_.empty()) {
+      return false;
+    }
+
+    auto job = jobs_.find(key);
+    if (job != jobs_.end()) {
+      job->second.rows.push_back(std::move(r));
+      monitoring::record("file_events.hash_coalesced",
+                         1,
+                         monitoring::PreAggregationType::Sum);
+      return true;
+    }
+
+    if (jobs_.size() >= max_backlog_) {
+      monitoring::record("file_events.hash_dropped",
+                         1,
+                         monitoring::PreAggregationType::Sum);
+      return false;
+    }
+
+    auto& added = jobs_[key];
+    added.path = path;
+    added.ready = Clock::now() + window_;
+    added.rows.push_back(std::move(r));
+    order_.push_back(key);
+    backlog = jobs_.size();
+  }
+
+  queued_.notify_one();
+  monitoring::record("file_events.hash_backlog",
+                     backlog,
+                     monitoring::PreAggregationType::Max);
+  return true;
+}
+
+void FileHashPool::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  ++draining_;
+  queued_.notify_all();
+  idle_.wait(lock, [this]() { return jobs_.empty() && active_ == 0; });
+  --draining_;
+}
+
+void FileHashPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+
+  queued_.notify_all();
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+std::size_t FileHashPool::backlog() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return jobs_.size();
+}
+
+void FileHashPool::work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (order_.empty()) {
+      if (stopping_) {
+        break;
+      }
+      queued_.wait(lock);
+      continue;
+    }
+
+    // Every job shares the same window, the oldest one is ready first.
+    auto ready = jobs_.at(order_.front()).ready;
+    if (!stopping_ && draining_ == 0 && Clock::now() < ready) {
+      queued_.wait_until(lock, ready);
+      continue;
+    }
+
+    auto key = std::move(order_.front());
+    order_.pop_front();
+    auto job = std::move(jobs_.at(key));
+    jobs_.erase(key);
+    ++active_;
+
+    lock.unlock();
+    complete(job);
+    lock.lock();
+
+    --active_;
+    if (jobs_.empty() && active_ == 0) {
+      idle_.notify_all();
+    }
+  }
+}
+
+void FileHashPool::complete(Job& job) {
+  auto hashes = hashMultiFromFile(
+      HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, job.path);
+
+  for (auto& row : job.rows) {
+    setFileEventHashes(hashes, row);
+  }
+  completion_(job.rows);
+}
+
+} // namespace osquery
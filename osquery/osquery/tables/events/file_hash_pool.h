@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <osquery/core/tables.h>
+
+namespace osquery {
+
+/**
+ * @brief Hash the targets of file events outside of the publisher thread.
+ *
+ * File event rows that need hashing are queued and completed by a small pool
+ * of worker threads. Rows for the same file arriving within the coalescing
+ * window share a single hash of the file, taken once the window has passed.
+ * Every queued row is handed back, hashed, to the completion callback.
+ *
+ * Rows carry no event time: the callback stores them when they complete,
+ * as inline hashing does, so an events query that already advanced past
+ * the event time still returns them.
+ */
+class FileHashPool final {
+ public:
+  /// Receives the hashed rows of a file, in the order they were queued.
+  using Completion = std::function<void(std::vector<Row>&)>;
+
+  /**
+   * @brief Start the hashing workers.
+   *
+   * @param workers Number of hashing threads.
+   * @param max_backlog Maximum number of files waiting to be hashed.
+   * @param window How long to wait for repeated events before hashing.
+   * @param completion Called from a worker with each set of hashed rows.
+   */
+  FileHashPool(std::size_t workers,
+               std::size_t max_backlog,
+               std::chrono::milliseconds window,
+               Completion completion);
+
+  /// Hashes anything still queued, then joins the workers.
+  ~FileHashPool();
+
+  FileHashPool(const FileHashPool&) = delete;
+  FileHashPool& operator=(const FileHashPool&) = delete;
+
+  /**
+   * @brief Queue a row for hashing.
+   *
+   * The row is moved from only if it was queued.
+   *
+   * @param path The file to hash.
+   * @param r The decorated file event row.
+   * @return false if the backlog is full or the pool is stopping.
+   */
+  bool enqueue(const std::string& path, Row& r);
+
+  /// Hash every queued file now and wait until the rows are completed.
+  void flush();
+
+  /// Hash every queued file now and stop the workers.
+  void stop();
+
+  /// Number of files waiting to be hashed.
+  std::size_t backlog() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Job final {
+    std::string path;
+    Clock::time_point ready;
+    std::vector<Row> rows;
+  };
+
+  void work();
+
+  void complete(Job& job);
+
+ private:
+  const std::size_t max_backlog_;
+
+  const std::chrono::milliseconds window_;
+
+  Completion completion_;
+
+  mutable std::mutex mutex_;
+
+  /// Signals workers that a job was queued or became ready.
+  std::condition_variable queued_;
+
+  /// Signals flush that the workers went idle.
+  std::condition_variable idle_;
+
+  /// Queued files keyed by inode (or path), in the order they become ready.
+  std::unordered_map<std::string, Job> jobs_;
+  std::deque<std::string> order_;
+
+  /// Number of jobs being hashed.
+  std::size_t active_{0};
+
+  /// Treat every queued job as ready (flush and stop).
+  std::size_t draining_{0};
+
+  bool stopping_{false};
+
+  std::vector<std::thread> workers_;
+};
+
+} // namespace osquery
@@ -0,0 +1,30 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <osquery/core/tables.h>
+#include <osquery/events/linux/bpf/bpferrorstate.h>
+
+namespace osquery {
+namespace tables {
+
+QueryData genBPFPublisherStats(QueryContext& context) {
+  const auto& stats = getBPFPublisherStats();
+
+  Row r;
+  r["lost_events"] = BIGINT(stats.lost_events.load());
+  r["invalid_events"] = BIGINT(stats.invalid_events.load());
+  r["probe_errors"] = BIGINT(stats.probe_errors.load());
+  r["late_events"] = BIGINT(stats.late_events.load());
+  r["processed_events"] = BIGINT(stats.processed_events.load());
+  r["queued_events"] = BIGINT(stats.queued_events.load());
+  return {r};
+}
+
+} // namespace tables
+} // namespace osquery
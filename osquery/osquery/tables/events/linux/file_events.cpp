@@ -7,19 +7,37 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include <osquery/config/config.h>
+#include <osquery/core/flags.h>
 #include <osquery/core/tables.h>
 #include <osquery/events/eventsubscriber.h>
 #include <osquery/events/linux/inotify.h>
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry_factory.h>
 #include <osquery/tables/events/event_utils.h>
+#include <osquery/tables/events/file_hash_pool.h>
 
 namespace osquery {
 
+FLAG(uint32,
+     file_events_hash_workers,
+     2,
+     "Threads hashing file_events targets (0 hashes in the event callback)");
+
+FLAG(uint64,
+     file_events_hash_backlog,
+     10000,
+     "Maximum number of file_events targets waiting to be hashed");
+
+FLAG(uint64,
+     file_events_hash_window_ms,
+     500,
+     "Milliseconds to coalesce repeated file_events for a file before hashing");
+
 /**
  * @brief Track time, action changes to /etc/passwd
  *
@@ -28,9 +46,25 @@ namespace osquery {
 class FileEventSubscriber : public EventSubscriber<INotifyEventPublisher> {
  public:
   Status init() override {
+    if (FLAGS_file_events_hash_workers > 0) {
+      hash_pool_ = std::make_unique<FileHashPool>(
+          FLAGS_file_events_hash_workers,
+          FLAGS_file_events_hash_backlog,
+          std::chrono::milliseconds(FLAGS_file_events_hash_window_ms),
+          [this](std::vector<Row>& rows) {
+            // Stored at completion, events queries may have read past the
+            // time of the original events while they were hashed.
+            addBatch(rows, getTime());
+          });
+    }
     return Status(0);
   }
 
+  /// Hash and store the events still waiting in the hashing pool.
+  void tearDown() override {
+    hash_pool_.reset();
+  }
+
   /// Walk the configuration's file paths, create subscriptions.
   void configure() override;
 
@@ -43,6 +77,10 @@ class FileEventSubscriber : public EventSubscriber<INotifyEventPublisher> {
    * @return Was the callback successful.
    */
   Status Callback(const ECRef& ec, const SCRef& sc);
+
+ private:
+  /// Hashes CREATED and UPDATED targets off the publisher thread.
+  std::unique_ptr<FileHashPool> hash_pool_;
 };
 
 /**
@@ -114,13 +152,21 @@ Status FileEventSubscriber::Callback(const ECRef& ec, const SCRef& sc) {
   r["category"] = sc->category;
   r["transaction_id"] = INTEGER(ec->event->cookie);
 
-  if ((sc->mask & kFileAccessMasks) != kFileAccessMasks) {
-    // Add hashing and 'join' against the file table for stat-information.
-    decorateFileEvent(
-        ec->path, (ec->action == "CREATED" || ec->action == "UPDATED"), r);
-  } else {
-    // The access event on Linux would generate additional events if hashed.
-    decorateFileEvent(ec->path, false, r);
+  // The access event on Linux would generate additional events if hashed.
+  bool hash = (sc->mask & kFileAccessMasks) != kFileAccessMasks &&
+              (ec->action == "CREATED" || ec->action == "UPDATED");
+
+  // Add 'join' against the file table for stat-information.
+  decorateFileEvent(ec->path, hash && hash_pool_ == nullptr, r);
+
+  if (hash && hash_pool_ != nullptr) {
+    // The row is stored once the pool has hashed the target.
+    if (hash_pool_->enqueue(ec->path, r)) {
+      return Status::success();
+    }
+
+    VLOG(1) << "Hashing backlog is full, not hashing: " << ec->path;
+    r["hashed"] = "-1";
   }
 
   // A callback is somewhat useless unless it changes the EventSubscriber
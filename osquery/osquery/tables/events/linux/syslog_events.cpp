@@ -51,8 +51,8 @@ class SyslogEventSubscriber : public EventSubscriber<SyslogEventPublisher> {
 REGISTER(SyslogEventSubscriber, "event_subscriber", "syslog_events");
 
 Status SyslogEventSubscriber::Callback(const ECRef& ec, const SCRef& sc) {
-  Row r(ec->fields);
-  add(r);
+  auto rows = ec->rows;
+  addBatch(rows);
   return Status::success();
 }
 }
@@ -0,0 +1,28 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <osquery/core/tables.h>
+#include <osquery/events/linux/syslog.h>
+
+namespace osquery {
+namespace tables {
+
+QueryData genSyslogPublisherStats(QueryContext& context) {
+  const auto& stats = getSyslogPublisherStats();
+
+  Row r;
+  r["lines"] = BIGINT(stats.lines.load());
+  r["batches"] = BIGINT(stats.batches.load());
+  r["parse_errors"] = BIGINT(stats.parse_errors.load());
+  r["overflowed_lines"] = BIGINT(stats.overflowed_lines.load());
+  return {r};
+}
+
+} // namespace tables
+} // namespace osquery
@@ -7,18 +7,25 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <chrono>
+
 #include <gtest/gtest.h>
 
+#include <boost/filesystem.hpp>
+
 #include <osquery/config/config.h>
 #include <osquery/config/tests/test_utils.h>
 #include <osquery/core/flags.h>
 #include <osquery/core/system.h>
 #include <osquery/database/database.h>
 #include <osquery/events/events.h>
+#include <osquery/filesystem/filesystem.h>
+#include <osquery/hashing/hashing.h>
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry.h>
 #include <osquery/sql/sql.h>
 #include <osquery/tables/events/event_utils.h>
+#include <osquery/tables/events/file_hash_pool.h>
 
 namespace osquery {
 
@@ -120,4 +127,106 @@ TEST_F(FileEventsTableTests, test_configure_subscriptions) {
   }
 }
 #endif /* WIN32 */
+
+class FileHashPoolTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = (boost::filesystem::temp_directory_path() /
+             boost::filesystem::unique_path("osquery.tests.hash.%%%%.%%%%"))
+                .string();
+    ASSERT_TRUE(writeTextFile(path_, "file_events hash pool").ok());
+  }
+
+  void TearDown() override {
+    boost::filesystem::remove(path_);
+  }
+
+  Row makeRow(const std::string& inode, const std::string& action) {
+    Row r;
+    r["target_path"] = path_;
+    r["action"] = action;
+    r["inode"] = inode;
+    r["hashed"] = "0";
+    return r;
+  }
+
+ protected:
+  std::string path_;
+};
+
+TEST_F(FileHashPoolTests, test_coalesce_repeated_events) {
+  std::vector<std::vector<Row>> completed;
+  FileHashPool pool(
+      1, 10, std::chrono::minutes(1), [&completed](std::vector<Row>& rows) {
+        completed.push_back(rows);
+      });
+
+  auto created = makeRow("42", "CREATED");
+  auto updated = makeRow("42", "UPDATED");
+  auto updated_again = makeRow("42", "UPDATED");
+  EXPECT_TRUE(pool.enqueue(path_, created));
+  EXPECT_TRUE(pool.enqueue(path_, updated));
+  EXPECT_TRUE(pool.enqueue(path_, updated_again));
+
+  // All three events wait on a single hash of the file.
+  EXPECT_EQ(pool.backlog(), 1U);
+  EXPECT_TRUE(completed.empty());
+
+  pool.flush();
+  EXPECT_EQ(pool.backlog(), 0U);
+
+  // Rows come back together, in the order they were queued.
+  ASSERT_EQ(completed.size(), 1U);
+  ASSERT_EQ(completed[0].size(), 3U);
+  EXPECT_EQ(completed[0][0].at("action"), "CREATED");
+  EXPECT_EQ(completed[0][1].at("action"), "UPDATED");
+  EXPECT_EQ(completed[0][2].at("action"), "UPDATED");
+
+  auto sha256 = hashFromFile(HASH_TYPE_SHA256, path_);
+  for (const auto& row : completed[0]) {
+    EXPECT_EQ(row.at("sha256"), sha256);
+    EXPECT_EQ(row.at("hashed"), "1");
+    EXPECT_FALSE(row.at("md5").empty());
+  }
+}
+
+TEST_F(FileHashPoolTests, test_backlog_limit) {
+  std::vector<Row> completed;
+  auto collect = [&completed](std::vector<Row>& rows) {
+    completed.insert(completed.end(), rows.begin(), rows.end());
+  };
+  FileHashPool pool(1, 1, std::chrono::minutes(1), collect);
+
+  auto first = makeRow("1", "UPDATED");
+  EXPECT_TRUE(pool.enqueue(path_, first));
+
+  // A different file is refused and left to the caller.
+  auto second = makeRow("2", "UPDATED");
+  EXPECT_FALSE(pool.enqueue(path_, second));
+  EXPECT_EQ(second.at("inode"), "2");
+
+  // Stopping hashes what is queued and refuses new rows.
+  pool.stop();
+  ASSERT_EQ(completed.size(), 1U);
+  EXPECT_EQ(completed[0].at("inode"), "1");
+  EXPECT_EQ(completed[0].at("hashed"), "1");
+
+  auto third = makeRow("3", "UPDATED");
+  EXPECT_FALSE(pool.enqueue(path_, third));
+}
+
+TEST_F(FileHashPoolTests, test_missing_file) {
+  std::vector<Row> completed;
+  auto collect = [&completed](std::vector<Row>& rows) {
+    completed.insert(completed.end(), rows.begin(), rows.end());
+  };
+  FileHashPool pool(1, 10, std::chrono::milliseconds(0), collect);
+
+  auto removed = makeRow("", "UPDATED");
+  EXPECT_TRUE(pool.enqueue(path_ + ".missing", removed));
+  pool.flush();
+
+  ASSERT_EQ(completed.size(), 1U);
+  EXPECT_EQ(completed[0].at("hashed"), "-1");
+}
 } // namespace osquery
@@ -18,6 +18,7 @@
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/fileops.h>
 #include <osquery/filesystem/filesystem.h>
+#include <osquery/filesystem/parsed_file_cache.h>
 #include <osquery/logger/logger.h>
 #include <osquery/utils/conversions/split.h>
 #include <osquery/worker/ipc/platform_table_container_ipc.h>
@@ -62,23 +63,26 @@ QueryData parseEtcHostsContent(const std::string& content) {
   return results;
 }
 
+ParsedFileCache<QueryData> kEtcHostsCache(
+    [](const std::string& path, const std::string& content, QueryData& rows) {
+      rows = parseEtcHostsContent(content);
+      return Status::success();
+    });
+
 QueryData genEtcHostsImpl(QueryContext& context, Logger& logger) {
-  std::string content;
   QueryData qres = {};
 
-  auto s = readFile(kEtcHosts, content, 0, false, false, false);
+  std::shared_ptr<const QueryData> rows;
+  auto s = kEtcHostsCache.get(kEtcHosts.string(), rows, false);
   if (s.ok()) {
-    qres = parseEtcHostsContent(content);
+    qres = *rows;
   } else {
     logger.log(google::GLOG_WARNING, s.getMessage());
   }
 
 #ifdef WIN32
-  content.clear();
-  QueryData qres_ics = {};
-  if (readFile(kEtcHostsIcs, content).ok()) {
-    qres_ics = parseEtcHostsContent(content);
-    qres.insert(qres.end(), qres_ics.begin(), qres_ics.end());
+  if (kEtcHostsCache.get(kEtcHostsIcs.string(), rows).ok()) {
+    qres.insert(qres.end(), rows->begin(), rows->end());
   }
 #endif
 
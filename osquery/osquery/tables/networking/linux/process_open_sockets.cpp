@@ -11,6 +11,7 @@
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/filesystem/linux/proc.h>
+#include <osquery/tables/networking/linux/socket_snapshot.h>
 
 namespace osquery {
 namespace tables {
@@ -47,37 +48,40 @@ QueryData genOpenSockets(QueryContext& context) {
    * under /proc/<pid>/fd and search for links of the type socket:[<inode>].
    * Extract the inode and fd (filename) and index it by inode number. The inode
    * can then be used to correlate pid and fd with the socket information
-   * collected on step 3. The map generated in this step will only contain
-   * sockets associated with pids in the list, so it will also be used to filter
-   * the sockets later if pid_filter is set.
+   * collected on step 3. When filtering by pid only the listed pids are read,
+   * otherwise the shared snapshot of every process is used.
    *
    * 2. Collect the inode for the network namespace associated with each pid.
    * Every time a new namespace is found execute step 3 to get socket basic
    * information.
    *
    * 3. Collect basic socket information for all sockets under a specifc network
-   * namespace. This is done by reading through files under /proc/<pid>/net for
-   * the first pid we find in a certain namespace. Notice this will collect
-   * information for all sockets on the namespace not only for sockets
-   * associated with the specific pid, therefore only needs to be run once. From
-   * this step we collect the inodes of each of the sockets, and will use that
-   * to correlate the socket information with the information collect on steps
-   * 1 and 2.
+   * namespace. See getNetNamespaceSockets: the decoded sockets of a namespace
+   * are shared between queries for a short time, so a JOIN calling this table
+   * once per pid decodes them only once.
    */
 
-  /* Use a set to record the namespaces already processed */
-  std::set<ino_t> netns_list;
-  SocketInodeToProcessInfoMap inode_proc_map;
-  SocketInfoList socket_list;
-  for (const auto& pid : pids) {
-    /* Step 1 */
-    status = procGetSocketInodeToProcessInfoMap(pid, inode_proc_map);
-    if (!status.ok()) {
-      VLOG(1) << "Results for process_open_sockets might be incomplete. Failed "
-                 "to acquire socket inode to process map for pid "
-              << pid << ": " << status.what();
+  /* Step 1 */
+  SocketOwnersRef inode_proc_map;
+  if (pid_filter) {
+    auto owners = std::make_shared<SocketInodeToProcessInfoMap>();
+    for (const auto& pid : pids) {
+      status = procGetSocketInodeToProcessInfoMap(pid, *owners);
+      if (!status.ok()) {
+        VLOG(1)
+            << "Results for process_open_sockets might be incomplete. Failed "
+               "to acquire socket inode to process map for pid "
+            << pid << ": " << status.what();
+      }
     }
+    inode_proc_map = std::move(owners);
+  } else {
+    inode_proc_map = getSocketOwners();
+  }
 
+  /* Record the namespaces already processed */
+  std::map<ino_t, NetNamespaceSocketsRef> netns_list;
+  for (const auto& pid : pids) {
     /* Step 2 */
     ino_t ns;
     ProcessNamespaceList namespaces;
@@ -96,65 +100,17 @@ QueryData genOpenSockets(QueryContext& context) {
     }
 
     if (netns_list.count(ns) == 0) {
-      netns_list.insert(ns);
-
       /* Step 3 */
-      for (const auto& pair : kLinuxProtocolNames) {
-        status = procGetSocketList(AF_INET, pair.first, ns, pid, socket_list);
-        if (!status.ok()) {
-          VLOG(1)
-              << "Results for process_open_sockets might be incomplete. Failed "
-                 "to acquire basic socket information for AF_INET "
-              << pair.second << ": " << status.what();
-        }
-
-        status = procGetSocketList(AF_INET6, pair.first, ns, pid, socket_list);
-        if (!status.ok()) {
-          VLOG(1)
-              << "Results for process_open_sockets might be incomplete. Failed "
-                 "to acquire basic socket information for AF_INET6 "
-              << pair.second << ": " << status.what();
-        }
-      }
-      status = procGetSocketList(AF_UNIX, IPPROTO_IP, ns, pid, socket_list);
-      if (!status.ok()) {
-        VLOG(1)
-            << "Results for process_open_sockets might be incomplete. Failed "
-               "to acquire basic socket information for AF_UNIX: "
-            << status.what();
-      }
-
-      // protocol is 0, we want all protocols here.
-      status = procGetSocketList(AF_PACKET, 0, ns, pid, socket_list);
-      if (!status.ok()) {
-        VLOG(1)
-            << "Results for process_open_sockets might be incomplete. Failed "
-               "to acquire basic socket information for AF_PACKET: "
-            << status.what();
-      }
+      netns_list[ns] = getNetNamespaceSockets(ns, pid);
     }
   }
 
-  /* Finally correlate all the information. Go through all the sockets
-   * collected on step 3 and correlate that with the pid and fd collected from
-   * step 1. If filtering only take sockets for which the inode is available on
-   * the inode to process information map.
-   */
-  for (const auto& info : socket_list) {
+  auto add_row = [&results](const SocketInfo& info,
+                            const std::string& pid,
+                            const std::string& fd) {
     Row r;
-    auto proc_it = inode_proc_map.find(info.socket);
-    if (proc_it != inode_proc_map.end()) {
-      r["pid"] = proc_it->second.pid;
-      r["fd"] = proc_it->second.fd;
-    } else if (!pid_filter) {
-      r["pid"] = "-1";
-      r["fd"] = "-1";
-    } else {
-      /* If we're filtering by pid we only care about sockets associated with
-       * pids on the list.*/
-      continue;
-    }
-
+    r["pid"] = pid;
+    r["fd"] = fd;
     r["socket"] = info.socket;
     r["family"] = std::to_string(info.family);
     r["protocol"] = std::to_string(info.protocol);
@@ -167,6 +123,38 @@ QueryData genOpenSockets(QueryContext& context) {
     r["net_namespace"] = std::to_string(info.net_ns);
 
     results.push_back(std::move(r));
+  };
+
+  /* Finally correlate all the information. When filtering, look up each
+   * socket owned by the listed pids in the namespaces collected on step 3.
+   * Otherwise go through all the sockets collected on step 3 and correlate
+   * them with the pid and fd collected from step 1.
+   */
+  if (pid_filter) {
+    for (const auto& owner : *inode_proc_map) {
+      for (const auto& netns : netns_list) {
+        const auto& index = netns.second->inode_index;
+        auto socket_it = index.find(owner.first);
+        if (socket_it != index.end()) {
+          add_row(netns.second->sockets[socket_it->second],
+                  owner.second.pid,
+                  owner.second.fd);
+          break;
+        }
+      }
+    }
+    return results;
+  }
+
+  for (const auto& netns : netns_list) {
+    for (const auto& info : netns.second->sockets) {
+      auto proc_it = inode_proc_map->find(info.socket);
+      if (proc_it != inode_proc_map->end()) {
+        add_row(info, proc_it->second.pid, proc_it->second.fd);
+      } else {
+        add_row(info, "-1", "-1");
+      }
+    }
   }
 
   return results;
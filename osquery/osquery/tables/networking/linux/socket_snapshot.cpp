@@ -0,0 +1,360 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <osquery/core/flags.h>
+#include <osquery/filesystem/filesystem.h>
+#include <osquery/logger/logger.h>
+#include <osquery/tables/networking/linux/inet_diag.h>
+#include <osquery/tables/networking/linux/socket_snapshot.h>
+#include <osquery/utils/mutex.h>
+#include <osquery/utils/scope_guard.h>
+
+#ifndef NETLINK_SOCK_DIAG
+#define NETLINK_SOCK_DIAG 4
+#endif
+
+#ifndef SOCK_DIAG_BY_FAMILY
+#define SOCK_DIAG_BY_FAMILY 20
+#endif
+
+namespace osquery {
+
+FLAG(uint64,
+     socket_snapshot_ms,
+     1000,
+     "Milliseconds decoded socket tables are shared between queries (0 to "
+     "disable)");
+
+namespace {
+
+using SnapshotClock = std::chrono::steady_clock;
+
+/// Size of the buffer used to receive sock_diag responses.
+const std::size_t kSockDiagBufferSize{32 * 1024};
+
+/// Request sockets in every TCP state.
+const std::uint32_t kSockDiagAllStates{~0U};
+
+/// Pending connection requests, reported as SYN_RECV by /proc/net/tcp.
+const std::uint8_t kTcpNewSynRecv{12};
+
+struct SocketSnapshots final {
+  Mutex mutex;
+
+  using NamespaceEntry =
+      std::pair<SnapshotClock::time_point, NetNamespaceSocketsRef>;
+  std::map<ino_t, NamespaceEntry> namespaces;
+
+  SnapshotClock::time_point owners_time;
+  SocketOwnersRef owners;
+};
+
+SocketSnapshots& socketSnapshots() {
+  static SocketSnapshots snapshots;
+  return snapshots;
+}
+
+bool isSnapshotFresh(const SnapshotClock::time_point& time) {
+  if (FLAGS_socket_snapshot_ms == 0) {
+    return false;
+  }
+
+  return SnapshotClock::now() - time <
+         std::chrono::milliseconds(FLAGS_socket_snapshot_ms);
+}
+
+std::string getTcpState(std::uint8_t state) {
+  if (state == kTcpNewSynRecv) {
+    return "SYN_RECV";
+  }
+
+  if (state == 0 || state >= tcp_states.size()) {
+    return "UNKNOWN";
+  }
+
+  return tcp_states[state];
+}
+
+void readProcSocketList(int family,
+                        int protocol,
+                        ino_t net_ns,
+                        const std::string& pid,
+                        SocketInfoList& result) {
+  auto status = procGetSocketList(family, protocol, net_ns, pid, result);
+  if (!status.ok()) {
+    VLOG(1) << "Results for process_open_sockets might be incomplete. Failed "
+               "to acquire basic socket information for family "
+            << family << " protocol " << protocol << ": " << status.what();
+  }
+}
+
+NetNamespaceSocketsRef buildNetNamespaceSockets(ino_t net_ns,
+                                                const std::string& pid) {
+  auto snapshot = std::make_shared<NetNamespaceSockets>();
+  auto& sockets = snapshot->sockets;
+
+  // sock_diag only answers for the namespace of the requesting socket.
+  ino_t own_net_ns = 0;
+  bool use_netlink =
+      net_ns != 0 &&
+      procGetNamespaceInode(own_net_ns, "net", kLinuxProcPath + "/self/ns")
+          .ok() &&
+      own_net_ns == net_ns;
+
+  for (const auto& pair : kLinuxProtocolNames) {
+    for (int family : {AF_INET, AF_INET6}) {
+      bool dumped = false;
+      if (use_netlink &&
+          (pair.first == IPPROTO_TCP || pair.first == IPPROTO_UDP)) {
+        auto status =
+            netlinkGetSocketList(family, pair.first, net_ns, sockets);
+        dumped = status.ok();
+        if (!dumped) {
+          VLOG(1) << "Falling back to /proc for family " << family
+                  << " protocol " << pair.first << ": " << status.what();
+        }
+      }
+
+      if (!dumped) {
+        readProcSocketList(family, pair.first, net_ns, pid, sockets);
+      }
+    }
+  }
+
+  readProcSocketList(AF_UNIX, IPPROTO_IP, net_ns, pid, sockets);
+
+  // protocol is 0, we want all protocols here.
+  readProcSocketList(AF_PACKET, 0, net_ns, pid, sockets);
+
+  snapshot->inode_index.reserve(sockets.size());
+  for (std::size_t i = 0; i < sockets.size(); ++i) {
+    // Sockets without an owner (e.g. TIME_WAIT) share the inode 0.
+    if (sockets[i].socket != "0") {
+      snapshot->inode_index.emplace(sockets[i].socket, i);
+    }
+  }
+
+  return snapshot;
+}
+
+SocketOwnersRef buildSocketOwners() {
+  auto owners = std::make_shared<SocketInodeToProcessInfoMap>();
+
+  std::set<std::string> pids;
+  auto status = procProcesses(pids);
+  if (!status.ok()) {
+    VLOG(1) << "Failed to acquire pid list: " << status.what();
+    return owners;
+  }
+
+  for (const auto& pid : pids) {
+    status = procGetSocketInodeToProcessInfoMap(pid, *owners);
+    if (!status.ok()) {
+      VLOG(1) << "Results for process_open_sockets might be incomplete. Failed "
+                 "to acquire socket inode to process map for pid "
+              << pid << ": " << status.what();
+    }
+  }
+
+  return owners;
+}
+
+} // namespace
+
+NetNamespaceSocketsRef getNetNamespaceSockets(ino_t net_ns,
+                                              const std::string& pid) {
+  auto& snapshots = socketSnapshots();
+
+  // Decode while holding the lock so concurrent readers wait for one snapshot.
+  WriteLock lock(snapshots.mutex);
+  auto it = snapshots.namespaces.find(net_ns);
+  if (it != snapshots.namespaces.end() && isSnapshotFresh(it->second.first)) {
+    return it->second.second;
+  }
+
+  // Namespaces of exited processes are never asked for again, drop every
+  // expired snapshot instead of only replacing this one.
+  for (auto entry = snapshots.namespaces.begin();
+       entry != snapshots.namespaces.end();) {
+    if (isSnapshotFresh(entry->second.first)) {
+      ++entry;
+    } else {
+      entry = snapshots.namespaces.erase(entry);
+    }
+  }
+
+  auto snapshot = buildNetNamespaceSockets(net_ns, pid);
+  if (FLAGS_socket_snapshot_ms > 0) {
+    snapshots.namespaces[net_ns] = {SnapshotClock::now(), snapshot};
+  }
+  return snapshot;
+}
+
+SocketOwnersRef getSocketOwners() {
+  auto& snapshots = socketSnapshots();
+
+  WriteLock lock(snapshots.mutex);
+  if (snapshots.owners != nullptr && isSnapshotFresh(snapshots.owners_time)) {
+    return snapshots.owners;
+  }
+
+  auto owners = buildSocketOwners();
+  if (FLAGS_socket_snapshot_ms > 0) {
+    snapshots.owners_time = SnapshotClock::now();
+    snapshots.owners = owners;
+  }
+  return owners;
+}
+
+void clearSocketSnapshots() {
+  auto& snapshots = socketSnapshots();
+
+  WriteLock lock(snapshots.mutex);
+  snapshots.namespaces.clear();
+  snapshots.owners.reset();
+}
+
+Status netlinkParseSocketList(int protocol,
+                              ino_t net_ns,
+                              const void* data,
+                              std::size_t size,
+                              SocketInfoList& result,
+                              bool& done) {
+  done = false;
+
+  int remaining = static_cast<int>(size);
+  auto header = static_cast<const struct nlmsghdr*>(data);
+  for (; NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+    if (header->nlmsg_type == NLMSG_DONE) {
+      done = true;
+      return Status::success();
+    }
+
+    if (header->nlmsg_type == NLMSG_ERROR) {
+      auto error = static_cast<const struct nlmsgerr*>(NLMSG_DATA(header));
+      return Status::failure("sock_diag request failed: " +
+                             std::string(std::strerror(-error->error)));
+    }
+
+    if (header->nlmsg_type != SOCK_DIAG_BY_FAMILY ||
+        header->nlmsg_len < NLMSG_LENGTH(sizeof(struct inet_diag_msg))) {
+      continue;
+    }
+
+    auto message = static_cast<const struct inet_diag_msg*>(NLMSG_DATA(header));
+
+    SocketInfo socket_info = {};
+    socket_info.socket = std::to_string(message->idiag_inode);
+    socket_info.net_ns = net_ns;
+    socket_info.family = message->idiag_family;
+    socket_info.protocol = protocol;
+
+    char addr_buffer[INET6_ADDRSTRLEN] = {0};
+    inet_ntop(message->idiag_family,
+              message->id.idiag_src,
+              addr_buffer,
+              sizeof(addr_buffer));
+    socket_info.local_address = addr_buffer;
+    socket_info.local_port = ntohs(message->id.idiag_sport);
+
+    addr_buffer[0] = '\0';
+    inet_ntop(message->idiag_family,
+              message->id.idiag_dst,
+              addr_buffer,
+              sizeof(addr_buffer));
+    socket_info.remote_address = addr_buffer;
+    socket_info.remote_port = ntohs(message->id.idiag_dport);
+
+    if (protocol == IPPROTO_TCP) {
+      socket_info.state = getTcpState(message->idiag_state);
+    }
+
+    result.push_back(std::move(socket_info));
+  }
+
+  return Status::success();
+}
+
+Status netlinkGetSocketList(int family,
+                            int protocol,
+                            ino_t net_ns,
+                            SocketInfoList& result) {
+  int socket_fd =
+      socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+  if (socket_fd < 0) {
+    return Status::failure("Cannot open NETLINK_SOCK_DIAG socket");
+  }
+
+  auto const socket_guard =
+      scope_guard::create([socket_fd]() { close(socket_fd); });
+
+  struct {
+    struct nlmsghdr header;
+    struct inet_diag_req_v2 request;
+  } message = {};
+
+  message.header.nlmsg_len = sizeof(message);
+  message.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+  message.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  message.request.sdiag_family = static_cast<__u8>(family);
+  message.request.sdiag_protocol = static_cast<__u8>(protocol);
+  message.request.idiag_states = kSockDiagAllStates;
+
+  struct sockaddr_nl kernel = {};
+  kernel.nl_family = AF_NETLINK;
+
+  if (sendto(socket_fd,
+             &message,
+             sizeof(message),
+             0,
+             reinterpret_cast<struct sockaddr*>(&kernel),
+             sizeof(kernel)) < 0) {
+    return Status::failure("Cannot write sock_diag request: " +
+                           std::string(std::strerror(errno)));
+  }
+
+  SocketInfoList sockets;
+  std::vector<char> buffer(kSockDiagBufferSize);
+
+  bool done = false;
+  while (!done) {
+    auto bytes = recv(socket_fd, buffer.data(), buffer.size(), 0);
+    if (bytes < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes <= 0) {
+      return Status::failure("Cannot read sock_diag response: " +
+                             std::string(std::strerror(errno)));
+    }
+
+    auto status = netlinkParseSocketList(
+        protocol, net_ns, buffer.data(), bytes, sockets, done);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  result.insert(result.end(),
+                std::make_move_iterator(sockets.begin()),
+                std::make_move_iterator(sockets.end()));
+  return Status::success();
+}
+
+} // namespace osquery
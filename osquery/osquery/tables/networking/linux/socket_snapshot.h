@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <osquery/filesystem/linux/proc.h>
+#include <osquery/utils/status/status.h>
+
+namespace osquery {
+
+/// The decoded sockets of a single network namespace.
+struct NetNamespaceSockets final {
+  SocketInfoList sockets;
+
+  /// Position of each socket within sockets, keyed by socket inode.
+  std::unordered_map<std::string, std::size_t> inode_index;
+};
+
+using NetNamespaceSocketsRef = std::shared_ptr<const NetNamespaceSockets>;
+using SocketOwnersRef = std::shared_ptr<const SocketInodeToProcessInfoMap>;
+
+/**
+ * @brief Return the decoded sockets of a network namespace.
+ *
+ * TCP and UDP sockets of the namespace osquery runs in are dumped with
+ * NETLINK_SOCK_DIAG. The remaining families, other namespaces, and any failed
+ * netlink request are read from the /proc/<pid>/net files of pid.
+ *
+ * The result is shared with every caller asking for the same namespace until
+ * it is older than --socket_snapshot_ms, so a JOIN or several socket tables
+ * queried together decode the socket tables only once.
+ *
+ * @param net_ns The network namespace inode, 0 if unknown.
+ * @param pid A process within the namespace.
+ */
+NetNamespaceSocketsRef getNetNamespaceSockets(ino_t net_ns,
+                                              const std::string& pid);
+
+/**
+ * @brief Return the process and descriptor owning each socket inode.
+ *
+ * This walks /proc/<pid>/fd of every process and is shared in the same way
+ * as getNetNamespaceSockets.
+ */
+SocketOwnersRef getSocketOwners();
+
+/// Drop every shared socket snapshot.
+void clearSocketSnapshots();
+
+/**
+ * @brief Dump the sockets of the calling thread's network namespace.
+ *
+ * The output parameter result is only appended to if the whole dump succeeds.
+ *
+ * @param family AF_INET or AF_INET6.
+ * @param protocol IPPROTO_TCP or IPPROTO_UDP.
+ * @param net_ns The network namespace to set in the SocketInfo entries.
+ * @param result The output parameter.
+ */
+Status netlinkGetSocketList(int family,
+                            int protocol,
+                            ino_t net_ns,
+                            SocketInfoList& result);
+
+/**
+ * @brief Decode a buffer of SOCK_DIAG_BY_FAMILY netlink responses.
+ *
+ * @param protocol The protocol the dump was requested for.
+ * @param net_ns The network namespace to set in the SocketInfo entries.
+ * @param data The received buffer.
+ * @param size The number of bytes received.
+ * @param result The output parameter.
+ * @param done Set to true when the end of the dump was reached.
+ */
+Status netlinkParseSocketList(int protocol,
+                              ino_t net_ns,
+                              const void* data,
+                              std::size_t size,
+                              SocketInfoList& result,
+                              bool& done);
+
+} // namespace osquery
@@ -0,0 +1,242 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <osquery/core/flags.h>
+#include <osquery/tables/networking/linux/inet_diag.h>
+#include <osquery/tables/networking/linux/socket_snapshot.h>
+
+namespace osquery {
+
+DECLARE_uint64(socket_snapshot_ms);
+
+namespace {
+
+const std::uint16_t kSockDiagByFamily{20};
+
+void appendMessage(std::vector<char>& buffer,
+                   std::uint16_t type,
+                   const void* payload,
+                   std::size_t payload_size) {
+  auto offset = buffer.size();
+  buffer.resize(offset + NLMSG_SPACE(payload_size));
+
+  auto header = reinterpret_cast<struct nlmsghdr*>(buffer.data() + offset);
+  header->nlmsg_len = NLMSG_LENGTH(payload_size);
+  header->nlmsg_type = type;
+  if (payload_size > 0) {
+    std::memcpy(NLMSG_DATA(header), payload, payload_size);
+  }
+}
+
+struct inet_diag_msg makeDiagMessage(int family,
+                                     const std::string& local,
+                                     std::uint16_t local_port,
+                                     const std::string& remote,
+                                     std::uint16_t remote_port,
+                                     std::uint8_t state,
+                                     std::uint32_t inode) {
+  struct inet_diag_msg message = {};
+  message.idiag_family = static_cast<__u8>(family);
+  message.idiag_state = state;
+  message.idiag_inode = inode;
+  message.id.idiag_sport = htons(local_port);
+  message.id.idiag_dport = htons(remote_port);
+  inet_pton(family, local.c_str(), message.id.idiag_src);
+  inet_pton(family, remote.c_str(), message.id.idiag_dst);
+  return message;
+}
+
+} // namespace
+
+class SocketSnapshotTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    snapshot_ms_ = FLAGS_socket_snapshot_ms;
+    clearSocketSnapshots();
+  }
+
+  void TearDown() override {
+    FLAGS_socket_snapshot_ms = snapshot_ms_;
+    clearSocketSnapshots();
+  }
+
+ private:
+  std::uint64_t snapshot_ms_{0};
+};
+
+TEST_F(SocketSnapshotTests, test_parse_sock_diag_messages) {
+  std::vector<char> buffer;
+
+  auto listen =
+      makeDiagMessage(AF_INET, "127.0.0.1", 8080, "0.0.0.0", 0, 10, 1234);
+  appendMessage(buffer, kSockDiagByFamily, &listen, sizeof(listen));
+
+  auto established =
+      makeDiagMessage(AF_INET6, "::1", 443, "fe80::1", 51000, 1, 5678);
+  appendMessage(buffer, kSockDiagByFamily, &established, sizeof(established));
+
+  // A pending connection request has no inode.
+  auto request =
+      makeDiagMessage(AF_INET, "10.0.0.1", 22, "10.0.0.2", 40000, 12, 0);
+  appendMessage(buffer, kSockDiagByFamily, &request, sizeof(request));
+
+  SocketInfoList sockets;
+  bool done = true;
+  auto status = netlinkParseSocketList(
+      IPPROTO_TCP, 42, buffer.data(), buffer.size(), sockets, done);
+  ASSERT_TRUE(status.ok()) << status.what();
+  EXPECT_FALSE(done);
+  ASSERT_EQ(sockets.size(), 3U);
+
+  EXPECT_EQ(sockets[0].socket, "1234");
+  EXPECT_EQ(sockets[0].net_ns, 42U);
+  EXPECT_EQ(sockets[0].family, AF_INET);
+  EXPECT_EQ(sockets[0].protocol, IPPROTO_TCP);
+  EXPECT_EQ(sockets[0].local_address, "127.0.0.1");
+  EXPECT_EQ(sockets[0].local_port, 8080U);
+  EXPECT_EQ(sockets[0].remote_address, "0.0.0.0");
+  EXPECT_EQ(sockets[0].remote_port, 0U);
+  EXPECT_EQ(sockets[0].state, "LISTEN");
+
+  EXPECT_EQ(sockets[1].socket, "5678");
+  EXPECT_EQ(sockets[1].family, AF_INET6);
+  EXPECT_EQ(sockets[1].local_address, "::1");
+  EXPECT_EQ(sockets[1].local_port, 443U);
+  EXPECT_EQ(sockets[1].remote_address, "fe80::1");
+  EXPECT_EQ(sockets[1].remote_port, 51000U);
+  EXPECT_EQ(sockets[1].state, "ESTABLISHED");
+
+  EXPECT_EQ(sockets[2].socket, "0");
+  EXPECT_EQ(sockets[2].state, "SYN_RECV");
+
+  // The end of the dump is reported and UDP sockets have no state.
+  buffer.clear();
+  auto udp = makeDiagMessage(AF_INET, "0.0.0.0", 53, "0.0.0.0", 0, 7, 99);
+  appendMessage(buffer, kSockDiagByFamily, &udp, sizeof(udp));
+  int end = 0;
+  appendMessage(buffer, NLMSG_DONE, &end, sizeof(end));
+
+  sockets.clear();
+  status = netlinkParseSocketList(
+      IPPROTO_UDP, 42, buffer.data(), buffer.size(), sockets, done);
+  ASSERT_TRUE(status.ok()) << status.what();
+  EXPECT_TRUE(done);
+  ASSERT_EQ(sockets.size(), 1U);
+  EXPECT_EQ(sockets[0].local_port, 53U);
+  EXPECT_TRUE(sockets[0].state.empty());
+}
+
+TEST_F(SocketSnapshotTests, test_parse_sock_diag_error) {
+  std::vector<char> buffer;
+
+  struct nlmsgerr error = {};
+  error.error = -EPERM;
+  appendMessage(buffer, NLMSG_ERROR, &error, sizeof(error));
+
+  SocketInfoList sockets;
+  bool done = false;
+  auto status = netlinkParseSocketList(
+      IPPROTO_TCP, 0, buffer.data(), buffer.size(), sockets, done);
+  EXPECT_FALSE(status.ok());
+  EXPECT_TRUE(sockets.empty());
+}
+
+TEST_F(SocketSnapshotTests, test_snapshot_finds_listening_socket) {
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(listener, 0);
+
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  auto bind_address = reinterpret_cast<struct sockaddr*>(&address);
+  ASSERT_EQ(bind(listener, bind_address, sizeof(address)), 0);
+  ASSERT_EQ(listen(listener, 1), 0);
+
+  socklen_t length = sizeof(address);
+  getsockname(listener, bind_address, &length);
+
+  struct stat info;
+  ASSERT_EQ(fstat(listener, &info), 0);
+  auto inode = std::to_string(info.st_ino);
+
+  ProcessNamespaceList namespaces;
+  auto pid = std::to_string(getpid());
+  procGetProcessNamespaces(pid, namespaces, {"net"});
+  auto sockets = getNetNamespaceSockets(namespaces["net"], pid);
+  auto owners = getSocketOwners();
+  close(listener);
+
+  auto socket_it = sockets->inode_index.find(inode);
+  ASSERT_NE(socket_it, sockets->inode_index.end());
+
+  const auto& socket_info = sockets->sockets[socket_it->second];
+  EXPECT_EQ(socket_info.family, AF_INET);
+  EXPECT_EQ(socket_info.protocol, IPPROTO_TCP);
+  EXPECT_EQ(socket_info.local_address, "127.0.0.1");
+  EXPECT_EQ(socket_info.local_port, ntohs(address.sin_port));
+  EXPECT_EQ(socket_info.state, "LISTEN");
+
+  auto owner_it = owners->find(inode);
+  ASSERT_NE(owner_it, owners->end());
+  EXPECT_EQ(owner_it->second.pid, pid);
+}
+
+TEST_F(SocketSnapshotTests, test_snapshot_is_shared) {
+  auto pid = std::to_string(getpid());
+
+  FLAGS_socket_snapshot_ms = 60 * 1000;
+  auto first = getNetNamespaceSockets(0, pid);
+  auto second = getNetNamespaceSockets(0, pid);
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_EQ(getSocketOwners().get(), getSocketOwners().get());
+
+  clearSocketSnapshots();
+  EXPECT_NE(getNetNamespaceSockets(0, pid).get(), first.get());
+
+  // A zero lifetime decodes the socket tables for every request.
+  FLAGS_socket_snapshot_ms = 0;
+  first = getNetNamespaceSockets(0, pid);
+  second = getNetNamespaceSockets(0, pid);
+  EXPECT_NE(first.get(), second.get());
+}
+
+TEST_F(SocketSnapshotTests, test_expired_snapshots_are_dropped) {
+  auto pid = std::to_string(getpid());
+
+  // A fresh snapshot of another namespace is kept.
+  FLAGS_socket_snapshot_ms = 60 * 1000;
+  std::weak_ptr<const NetNamespaceSockets> first =
+      getNetNamespaceSockets(1, pid);
+  getNetNamespaceSockets(2, pid);
+  EXPECT_FALSE(first.expired());
+
+  // An expired one is dropped by the next snapshot, whatever its namespace.
+  FLAGS_socket_snapshot_ms = 1;
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  getNetNamespaceSockets(3, pid);
+  EXPECT_TRUE(first.expired());
+}
+
+} // namespace osquery
@@ -7,23 +7,48 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iterator>
 #include <map>
 #include <set>
+#include <vector>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include <boost/filesystem.hpp>
 #include <boost/noncopyable.hpp>
 
 #include <tsk/libtsk.h>
 
+#include <osquery/core/flags.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/hashing/hashing.h>
 #include <osquery/logger/logger.h>
+#include <osquery/tables/sleuthkit/sleuthkit_utils.h>
 #include <osquery/utils/conversions/tryto.h>
 
 namespace fs = boost::filesystem;
 
 namespace osquery {
+
+FLAG(uint64,
+     device_file_workers,
+     4,
+     "Max number of partitions device_file walks concurrently when no "
+     "partition is constrained");
+
+FLAG(uint64,
+     device_file_read_ahead,
+     4096,
+     "KB of directory blocks device_file asks the kernel to read ahead before "
+     "each directory level of a walk, 0 disables");
+
 namespace tables {
 
 const std::map<TSK_FS_META_TYPE_ENUM, std::string> kTSKTypeNames{
@@ -36,6 +61,98 @@ const std::map<TSK_FS_META_TYPE_ENUM, std::string> kTSKTypeNames{
     {TSK_FS_META_TYPE_SOCK, "socket"},
 };
 
+/// Runs of consecutive filesystem blocks, as first block and block count.
+using BlockRuns = std::vector<std::pair<TSK_DADDR_T, TSK_DADDR_T>>;
+
+/// Block runs collected by a file walk, up to a number of blocks.
+struct BlockRunsWalk {
+  BlockRuns runs;
+  TSK_DADDR_T remaining{0};
+};
+
+TSK_WALK_RET_ENUM collectBlockRuns(TskFsFile* file,
+                                   TSK_OFF_T offset,
+                                   TSK_DADDR_T addr,
+                                   char* buffer,
+                                   size_t size,
+                                   TSK_FS_BLOCK_FLAG_ENUM flags,
+                                   void* ptr) {
+  auto* walk = static_cast<BlockRunsWalk*>(ptr);
+  if (walk->remaining == 0) {
+    return TSK_WALK_STOP;
+  }
+
+  // Resident content is read with the metadata.
+  if ((flags & TSK_FS_BLOCK_FLAG_RES) || addr == 0) {
+    return TSK_WALK_CONT;
+  }
+
+  auto& runs = walk->runs;
+  if (!runs.empty() && runs.back().first + runs.back().second == addr) {
+    runs.back().second++;
+  } else {
+    runs.emplace_back(addr, 1);
+  }
+  walk->remaining--;
+  return TSK_WALK_CONT;
+}
+
+/**
+ * @brief Ask the kernel to read device blocks before TSK requests them.
+ *
+ * TSK reads a raw device with small synchronous reads. Hinting the blocks
+ * of the directories a walk visits next lets the kernel fetch them while the
+ * current directory is processed.
+ */
+class DeviceReadAhead : private boost::noncopyable {
+ public:
+  explicit DeviceReadAhead(const std::string& device_path) {
+#ifndef WIN32
+    fd_ = ::open(device_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+      VLOG(1) << "Cannot open " << device_path << " for read ahead";
+    }
+#endif
+  }
+
+  ~DeviceReadAhead() {
+#ifndef WIN32
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+#endif
+  }
+
+  /// Hint the runs of blocks of a filesystem.
+  void prefetch(TskFsInfo* fs, const BlockRuns& runs) {
+#ifndef WIN32
+    if (fd_ < 0) {
+      return;
+    }
+
+    auto block_size = static_cast<off_t>(fs->getBlockSize());
+    for (const auto& run : runs) {
+      auto offset =
+          fs->getOffset() + static_cast<off_t>(run.first) * block_size;
+      auto size = static_cast<off_t>(run.second) * block_size;
+#ifdef __APPLE__
+      struct radvisory advice;
+      advice.ra_offset = offset;
+      advice.ra_count = static_cast<int>(size);
+      ::fcntl(fd_, F_RDADVISE, &advice);
+#else
+      ::posix_fadvise(fd_, offset, size, POSIX_FADV_WILLNEED);
+#endif
+    }
+#endif
+  }
+
+ private:
+#ifndef WIN32
+  int fd_{-1};
+#endif
+};
+
 class DeviceHelper : private boost::noncopyable {
  public:
   explicit DeviceHelper(const std::string& device_path)
@@ -64,10 +181,16 @@ class DeviceHelper : private boost::noncopyable {
       std::function<void(const std::string&, TskFsFile*, const std::string&)>
           predicate);
 
-  /// Provide a partition description for context and iterate from path.
+  /**
+   * @brief Provide a partition description for context and iterate from path.
+   *
+   * Only files whose path starts with prefix are yielded, directories that
+   * cannot contain such a path are not walked.
+   */
   void generateFiles(const std::string& partition,
                      TskFsInfo* fs,
                      const std::string& path,
+                     const std::string& prefix,
                      QueryData& results,
                      TSK_INUM_T inode = 0);
 
@@ -104,6 +227,9 @@ class DeviceHelper : private boost::noncopyable {
   /// Image structure.
   std::shared_ptr<TskImgInfo> image_{nullptr};
 
+  /// Read ahead hints for raw images, the blocks of other formats are mapped.
+  std::unique_ptr<DeviceReadAhead> read_ahead_{nullptr};
+
   /// Volume structure.
   std::shared_ptr<TskVsInfo> volume_{nullptr};
 
@@ -128,6 +254,11 @@ bool DeviceHelper::open() {
     return opened_result_;
   }
 
+  if (FLAGS_device_file_read_ahead > 0 &&
+      image_->getType() == TSK_IMG_TYPE_RAW) {
+    read_ahead_ = std::make_unique<DeviceReadAhead>(device_path_);
+  }
+
   // Attempt to open the device image volumn.
   status = volume_->open(&*image_, 0, TSK_VS_TYPE_DETECT);
   opened_result_ = (status == 0);
@@ -200,6 +331,7 @@ void DeviceHelper::generateFile(const std::string& partition,
 void DeviceHelper::generateFiles(const std::string& partition,
                                  TskFsInfo* fs,
                                  const std::string& path,
+                                 const std::string& prefix,
                                  QueryData& results,
                                  TSK_INUM_T inode) {
   if (stack_++ > 1024) {
@@ -212,6 +344,13 @@ void DeviceHelper::generateFiles(const std::string& partition,
     return;
   }
 
+  // Blocks of the directories walked next.
+  BlockRunsWalk read_ahead;
+  if (read_ahead_ != nullptr) {
+    read_ahead.remaining =
+        FLAGS_device_file_read_ahead * 1024 / fs->getBlockSize();
+  }
+
   // Iterate through the directory.
   std::map<TSK_INUM_T, std::string> additional;
   for (size_t i = 0; i < dir->getSize(); i++) {
@@ -234,14 +373,25 @@ void DeviceHelper::generateFiles(const std::string& partition,
     std::string leaf;
     auto* name = file->getName();
     if (name != nullptr) {
-      leaf = (fs::path(path) / name->getName()).string();
+      leaf = (path == "/") ? path + name->getName()
+                           : path + "/" + name->getName();
     }
 
     if (meta->getType() == TSK_FS_META_TYPE_REG) {
-      generateFile(partition, file, fs, leaf, results);
+      if (matchesPrefix(leaf, prefix)) {
+        generateFile(partition, file, fs, leaf, results);
+      }
     } else if (meta->getType() == TSK_FS_META_TYPE_DIR) {
-      if (name != nullptr && !TSK_FS_ISDOT(name->getName())) {
+      if (name != nullptr && !TSK_FS_ISDOT(name->getName()) &&
+          mayContainPrefix(leaf, prefix)) {
         additional[meta->getAddr()] = leaf;
+        if (read_ahead.remaining > 0) {
+          file->walk(static_cast<TSK_FS_FILE_WALK_FLAG_ENUM>(
+                         TSK_FS_FILE_WALK_FLAG_AONLY |
+                         TSK_FS_FILE_WALK_FLAG_NOSPARSE),
+                     collectBlockRuns,
+                     &read_ahead);
+        }
       }
     }
 
@@ -253,10 +403,14 @@ void DeviceHelper::generateFiles(const std::string& partition,
   }
   delete dir;
 
+  if (!read_ahead.runs.empty()) {
+    read_ahead_->prefetch(fs, read_ahead.runs);
+  }
+
   // If we are recursing.
   for (const auto& d : additional) {
-    if (std::find(loops_.begin(), loops_.end(), d.second) == loops_.end()) {
-      generateFiles(partition, fs, d.second, results, d.first);
+    if (loops_.count(d.second) == 0) {
+      generateFiles(partition, fs, d.second, prefix, results, d.first);
       loops_.insert(d.second);
     }
   }
@@ -365,69 +519,132 @@ QueryData genDeviceHash(QueryContext& context) {
   return results;
 }
 
-QueryData genDeviceFile(QueryContext& context) {
-  QueryData results;
+void genPartitionFiles(const std::string& dev,
+                       const std::string& partition,
+                       const std::set<std::string>& paths,
+                       const std::set<std::string>& inodes,
+                       const std::string& prefix,
+                       QueryData& results) {
+  // For each require device path, open a device helper that checks the
+  // image, checks the volume, and allows partition iteration.
+  DeviceHelper dh(dev);
+  dh.partitions(([&results, &dh, &partition, &inodes, &paths, &prefix](
+                     const TskVsPartInfo* part) {
+    // The table also requires a partition for searching.
+    auto address = std::to_string(part->getAddr());
+    if (address != partition) {
+      // If this partition does not match the requested, continue.
+      return;
+    }
+
+    auto* fs = new TskFsInfo();
+    auto status = fs->open(part, TSK_FS_TYPE_DETECT);
+    // Cannot retrieve file information without accessing the filesystem.
+    if (status) {
+      delete fs;
+      return;
+    }
+
+    // If no inodes or paths were provided as constraints assume a walk of
+    // the partition, or of the paths matching a LIKE prefix, was requested.
+    if (inodes.empty() && paths.empty()) {
+      dh.generateFiles(address, fs, "/", prefix, results);
+      dh.resetStack();
+    }
 
+    // For each path the canonical name must be mapped to an inode address.
+    for (const auto& path : paths) {
+      auto* file = new TskFsFile();
+      if (file->open(fs, file, path.c_str()) == 0) {
+        dh.generateFile(address, file, fs, path, results);
+      }
+      delete file;
+    }
+
+    dh.inodes(inodes,
+              fs,
+              ([&results, &address, &dh, &fs](const std::string& inode,
+                                              TskFsFile* file,
+                                              const std::string& path) {
+                dh.generateFile(address, file, fs, path, results);
+              }));
+    delete fs;
+  }));
+}
+
+/// Walk the partitions of a device, each with its own TSK handles.
+void genDevicePartitionsFiles(const std::string& dev,
+                              const std::vector<std::string>& partitions,
+                              const std::set<std::string>& paths,
+                              const std::set<std::string>& inodes,
+                              const std::string& prefix,
+                              QueryData& results) {
+  std::vector<QueryData> partition_results(partitions.size());
+  std::atomic<size_t> next{0};
+  auto run = [&]() {
+    for (auto i = next++; i < partitions.size(); i = next++) {
+      genPartitionFiles(
+          dev, partitions[i], paths, inodes, prefix, partition_results[i]);
+    }
+  };
+
+  auto workers = std::min<size_t>(
+      std::max<std::uint64_t>(FLAGS_device_file_workers, 1), partitions.size());
+  std::vector<std::future<void>> futures;
+  for (size_t i = 1; i < workers; ++i) {
+    futures.push_back(std::async(std::launch::async, run));
+  }
+  run();
+  for (auto& future : futures) {
+    future.get();
+  }
+
+  // Rows keep the order of the partitions.
+  for (auto& rows : partition_results) {
+    std::move(rows.begin(), rows.end(), std::back_inserter(results));
+  }
+}
+
+QueryData genDeviceFile(QueryContext& context) {
   auto devices = context.constraints["device"].getAll(EQUALS);
-  // This table requires two or more columns to determine an action.
+  // This table requires a device, and walks every partition unless one is
+  // requested.
   auto parts = context.constraints["partition"].getAll(EQUALS);
   // Additionally, paths or inodes can be used to search.
   auto paths = context.constraints["path"].getAll(EQUALS);
   auto inodes = context.constraints["inode"].getAll(EQUALS);
 
-  if (devices.empty() || parts.size() != 1) {
-    TLOG << "Device files require at least one device and a single partition";
+  if (devices.empty() || parts.size() > 1) {
+    TLOG << "Device files require at least one device and at most one "
+            "partition";
     return {};
   }
 
-  for (const auto& dev : devices) {
-    // For each require device path, open a device helper that checks the
-    // image, checks the volume, and allows partition iteration.
-    DeviceHelper dh(dev);
-    dh.partitions(([&results, &dh, &parts, &inodes, &paths](
-                       const TskVsPartInfo* part) {
-      // The table also requires a partition for searching.
-      auto address = std::to_string(part->getAddr());
-      if (address != *parts.begin()) {
-        // If this partition does not match the requested, continue.
-        return;
-      }
-
-      auto* fs = new TskFsInfo();
-      auto status = fs->open(part, TSK_FS_TYPE_DETECT);
-      // Cannot retrieve file information without accessing the filesystem.
-      if (status) {
-        delete fs;
-        return;
-      }
-
-      // If no inodes or paths were provided as constraints assume a walk of
-      // the partition was requested.
-      if (inodes.empty() && paths.empty()) {
-        dh.generateFiles(address, fs, "/", results);
-        dh.resetStack();
-      }
+  // Every LIKE constraint must match, walk below the longest literal prefix.
+  std::string prefix;
+  for (const auto& pattern : context.constraints["path"].getAll(LIKE)) {
+    auto like_prefix = getLikePrefix(pattern);
+    if (like_prefix.size() > prefix.size()) {
+      prefix = std::move(like_prefix);
+    }
+  }
 
-      // For each path the canonical name must be mapped to an inode address.
-      for (const auto& path : paths) {
-        auto* file = new TskFsFile();
-        if (file->open(fs, file, path.c_str()) == 0) {
-          dh.generateFile(address, file, fs, path, results);
-        }
-        delete file;
-      }
+  // SQLite calls xFilter once for each partition of an IN list, so only a
+  // walk of every partition of a device has partitions to run concurrently.
+  QueryData results;
+  for (const auto& dev : devices) {
+    if (!parts.empty()) {
+      genPartitionFiles(dev, *parts.begin(), paths, inodes, prefix, results);
+      continue;
+    }
 
-      dh.inodes(inodes,
-                fs,
-                ([&results, &address, &dh, &fs](const std::string& inode,
-                                                TskFsFile* file,
-                                                const std::string& path) {
-                  dh.generateFile(address, file, fs, path, results);
-                }));
-      delete fs;
+    std::vector<std::string> partitions;
+    DeviceHelper dh(dev);
+    dh.partitions(([&partitions](const TskVsPartInfo* part) {
+      partitions.push_back(std::to_string(part->getAddr()));
     }));
+    genDevicePartitionsFiles(dev, partitions, paths, inodes, prefix, results);
   }
-
   return results;
 }
 
@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+#include <cctype>
+
+#include <osquery/tables/sleuthkit/sleuthkit_utils.h>
+
+namespace osquery {
+namespace tables {
+
+namespace {
+
+/// Compare ASCII letters case-insensitively, as the SQLite LIKE operator.
+bool startsWithNoCase(const std::string& value,
+                      const std::string& prefix,
+                      size_t size) {
+  if (value.size() < size || prefix.size() < size) {
+    return false;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    if (std::tolower(static_cast<unsigned char>(value[i])) !=
+        std::tolower(static_cast<unsigned char>(prefix[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+std::string getLikePrefix(const std::string& pattern) {
+  return pattern.substr(0, pattern.find_first_of("%_"));
+}
+
+bool matchesPrefix(const std::string& path, const std::string& prefix) {
+  return startsWithNoCase(path, prefix, prefix.size());
+}
+
+bool mayContainPrefix(const std::string& directory, const std::string& prefix) {
+  auto path = directory;
+  if (path.empty() || path.back() != '/') {
+    path += "/";
+  }
+  return startsWithNoCase(path, prefix, std::min(path.size(), prefix.size()));
+}
+
+} // namespace tables
+} // namespace osquery
@@ -0,0 +1,41 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <string>
+
+namespace osquery {
+namespace tables {
+
+/**
+ * @brief The literal start of a LIKE pattern, before its first wildcard.
+ *
+ * Both '%' and '_' end the literal prefix.
+ */
+std::string getLikePrefix(const std::string& pattern);
+
+/**
+ * @brief A file path matches the literal prefix of a path LIKE constraint.
+ *
+ * ASCII letters are compared case-insensitively, as the SQLite LIKE operator.
+ * An empty prefix matches every path.
+ */
+bool matchesPrefix(const std::string& path, const std::string& prefix);
+
+/**
+ * @brief A directory may contain files matching the prefix.
+ *
+ * This is true if the prefix starts with the directory, or if the prefix
+ * ends within the directory path, for example "/et" and the "/etc" directory.
+ */
+bool mayContainPrefix(const std::string& directory, const std::string& prefix);
+
+} // namespace tables
+} // namespace osquery
@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <gtest/gtest.h>
+
+#include <osquery/tables/sleuthkit/sleuthkit_utils.h>
+
+namespace osquery {
+namespace tables {
+
+class SleuthkitTests : public testing::Test {};
+
+TEST_F(SleuthkitTests, test_get_like_prefix) {
+  EXPECT_EQ(getLikePrefix("/etc/%"), "/etc/");
+  EXPECT_EQ(getLikePrefix("/etc/pa_swd"), "/etc/pa");
+  EXPECT_EQ(getLikePrefix("/etc/passwd"), "/etc/passwd");
+  EXPECT_EQ(getLikePrefix("%passwd"), "");
+  EXPECT_EQ(getLikePrefix("_etc"), "");
+  EXPECT_EQ(getLikePrefix(""), "");
+}
+
+TEST_F(SleuthkitTests, test_matches_prefix) {
+  EXPECT_TRUE(matchesPrefix("/etc/passwd", "/etc/"));
+  EXPECT_TRUE(matchesPrefix("/etc/passwd", "/etc/passwd"));
+  EXPECT_TRUE(matchesPrefix("/etc/passwd", ""));
+  EXPECT_FALSE(matchesPrefix("/etc", "/etc/"));
+  EXPECT_FALSE(matchesPrefix("/var/log", "/etc/"));
+
+  // ASCII letters are folded, as the LIKE operator does.
+  EXPECT_TRUE(matchesPrefix("/Windows/System32/cmd.exe", "/windows/system"));
+  EXPECT_TRUE(matchesPrefix("/etc/passwd", "/ETC/"));
+  EXPECT_FALSE(matchesPrefix("/etc/passwd", "/etc/shadow"));
+}
+
+TEST_F(SleuthkitTests, test_may_contain_prefix) {
+  // Every directory may contain a match for an empty prefix.
+  EXPECT_TRUE(mayContainPrefix("/", ""));
+  EXPECT_TRUE(mayContainPrefix("/var", ""));
+
+  // The root directory contains every absolute path.
+  EXPECT_TRUE(mayContainPrefix("/", "/etc/"));
+  EXPECT_TRUE(mayContainPrefix("/", "/"));
+
+  // The prefix continues below the directory.
+  EXPECT_TRUE(mayContainPrefix("/etc", "/etc/ssh/"));
+  EXPECT_TRUE(mayContainPrefix("/etc/ssh", "/etc/ssh/sshd"));
+  EXPECT_FALSE(mayContainPrefix("/var", "/etc/ssh/"));
+  EXPECT_FALSE(mayContainPrefix("/etcetera", "/etc/"));
+
+  // The prefix ends within a path component.
+  EXPECT_TRUE(mayContainPrefix("/etc", "/et"));
+  EXPECT_TRUE(mayContainPrefix("/etc/pam.d", "/etc/pa"));
+  EXPECT_TRUE(mayContainPrefix("/etc/pam.d/sub", "/etc/pa"));
+  EXPECT_FALSE(mayContainPrefix("/etc/ssh", "/etc/pa"));
+
+  // A directory named as the prefix without its separator.
+  EXPECT_TRUE(mayContainPrefix("/etc", "/etc"));
+
+  // ASCII letters are folded.
+  EXPECT_TRUE(mayContainPrefix("/Windows", "/windows/system32"));
+  EXPECT_TRUE(mayContainPrefix("/windows", "/WIN"));
+}
+
+} // namespace tables
+} // namespace osquery
@@ -11,6 +11,7 @@
 
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
+#include <osquery/filesystem/parsed_file_cache.h>
 #include <osquery/logger/logger.h>
 #include <osquery/tables/system/linux/apt_sources.h>
 #include <osquery/utils/conversions/join.h>
@@ -119,36 +120,28 @@ std::string getCacheFilename(const std::vector<std::string>& cache_file) {
   return filename;
 }
 
-void genAptUrl(const std::string& source,
-               const std::string& line,
-               QueryData& results,
-               Logger& logger) {
-  AptSource apt_source;
-  if (!parseAptSourceLine(line, apt_source).ok()) {
-    return;
-  }
-
-  Row r;
-  r["source"] = source;
-  r["base_uri"] = std::move(apt_source.base_uri);
-  r["name"] = std::move(apt_source.name);
-
-  std::vector<std::string> cache_files;
-  auto cache_filename = getCacheFilename(apt_source.cache_file);
-  resolveFilePattern("/var/lib/apt/lists/" + cache_filename + "_%Release",
-                     cache_files,
-                     GLOB_FILES);
-  if (cache_files.empty()) {
-    return;
-  }
+/// Parse the deb lines of a sources list, other lines are skipped.
+Status parseAptSourceList(const std::string& path,
+                          const std::string& content,
+                          std::vector<AptSource>& apt_sources) {
+  for (const auto& line : osquery::split(content, "\n")) {
+    // Skip empty lines
+    if (line.empty()) {
+      continue;
+    }
 
-  std::string content;
-  auto s = readFile(cache_files[0], content, 0, false, false, false);
-  if (!s.ok()) {
-    logger.log(google::GLOG_WARNING, s.getMessage());
-    return;
+    AptSource apt_source;
+    if (parseAptSourceLine(line, apt_source).ok()) {
+      apt_sources.push_back(std::move(apt_source));
+    }
   }
+  return Status::success();
+}
 
+/// Parse the headers of a cached Release file into apt_sources columns.
+Status parseAptRelease(const std::string& path,
+                       const std::string& content,
+                       Row& release) {
   for (const auto& header : osquery::split(content, "\n")) {
     if (header.empty()) {
       continue;
@@ -163,17 +156,52 @@ void genAptUrl(const std::string& source,
     }
 
     if (fields[0] == "Codename") {
-      r["release"] = fields[1];
+      release["release"] = fields[1];
     } else if (fields[0] == "Version") {
-      r["version"] = fields[1];
+      release["version"] = fields[1];
     } else if (fields[0] == "Origin") {
-      r["maintainer"] = fields[1];
+      release["maintainer"] = fields[1];
     } else if (fields[0] == "Components") {
-      r["components"] = fields[1];
+      release["components"] = fields[1];
     } else if (fields[0] == "Architectures") {
-      r["architectures"] = fields[1];
+      release["architectures"] = fields[1];
     }
   }
+  return Status::success();
+}
+
+ParsedFileCache<std::vector<AptSource>> kAptSourceListCache(
+    parseAptSourceList);
+ParsedFileCache<Row> kAptReleaseCache(parseAptRelease);
+
+void genAptUrl(const std::string& source,
+               const AptSource& apt_source,
+               QueryData& results,
+               Logger& logger) {
+  Row r;
+  r["source"] = source;
+  r["base_uri"] = apt_source.base_uri;
+  r["name"] = apt_source.name;
+
+  std::vector<std::string> cache_files;
+  auto cache_filename = getCacheFilename(apt_source.cache_file);
+  resolveFilePattern("/var/lib/apt/lists/" + cache_filename + "_%Release",
+                     cache_files,
+                     GLOB_FILES);
+  if (cache_files.empty()) {
+    return;
+  }
+
+  std::shared_ptr<const Row> release;
+  auto s = kAptReleaseCache.get(cache_files[0], release, false);
+  if (!s.ok()) {
+    logger.log(google::GLOG_WARNING, s.getMessage());
+    return;
+  }
+
+  for (const auto& field : *release) {
+    r[field.first] = field.second;
+  }
   r["pid_with_namespace"] = "0";
   results.push_back(r);
 }
@@ -181,20 +209,15 @@ void genAptUrl(const std::string& source,
 static void genAptSource(const std::string& source,
                          QueryData& results,
                          Logger& logger) {
-  std::string content;
-
-  auto s = readFile(source, content, 0, false, false, false);
+  std::shared_ptr<const std::vector<AptSource>> apt_sources;
+  auto s = kAptSourceListCache.get(source, apt_sources, false);
   if (!s.ok()) {
     logger.log(google::GLOG_WARNING, s.getMessage());
     return;
   }
 
-  for (const auto& line : osquery::split(content, "\n")) {
-    // Skip empty lines
-    if (line.empty()) {
-      continue;
-    }
-    genAptUrl(source, line, results, logger);
+  for (const auto& apt_source : *apt_sources) {
+    genAptUrl(source, apt_source, results, logger);
   }
 }
 
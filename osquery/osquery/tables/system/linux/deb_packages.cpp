@@ -11,6 +11,7 @@
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
+#include <osquery/tables/system/linux/package_cache.h>
 #include <osquery/utils/linux/idpkgquery.h>
 #include <osquery/worker/ipc/platform_table_container_ipc.h>
 #include <osquery/worker/logging/glog/glog_logger.h>
@@ -24,6 +25,11 @@ namespace {
 // information about status of installed or uninstalled packages
 const std::string kAdminDir{"/var/lib/dpkg"};
 
+PackageCache& getDebPackageCache() {
+  static PackageCache cache;
+  return cache;
+}
+
 void logError(Logger& logger,
               const std::string& message,
               const Error<IDpkgQuery::ErrorCode>& error,
@@ -62,12 +68,27 @@ QueryData genDebPackagesImpl(QueryContext& context, Logger& logger) {
   auto dropper = DropPrivileges::get();
   dropper->dropTo("nobody");
 
+  std::set<std::string> names;
+  if (context.hasConstraint("name", EQUALS)) {
+    names = context.constraints["name"].getAll(EQUALS);
+  }
+
   QueryData results;
+  auto& cache = getDebPackageCache();
 
   for (const auto& admindir : admindir_list) {
     if (!pathExists(admindir).ok()) {
       continue;
     }
+
+    // dpkg rewrites the status file, and journals into updates/, whenever
+    // the package database changes.
+    auto stamp =
+        PackageCache::stamp({admindir + "/status", admindir + "/updates"});
+    if (cache.lookup(admindir, stamp, names, results)) {
+      continue;
+    }
+
     auto dpkg_query_exp = IDpkgQuery::create(admindir);
     if (dpkg_query_exp.isError()) {
       logError(logger,
@@ -92,6 +113,7 @@ QueryData genDebPackagesImpl(QueryContext& context, Logger& logger) {
 
     auto package_list = package_list_exp.take();
 
+    QueryData rows;
     for (const auto& package : package_list) {
       Row r;
       r["name"] = package.name;
@@ -107,8 +129,11 @@ QueryData genDebPackagesImpl(QueryContext& context, Logger& logger) {
       r["admindir"] = admindir;
       r["pid_with_namespace"] = "0";
 
-      results.push_back(std::move(r));
+      rows.push_back(std::move(r));
     }
+
+    cache.update(admindir, stamp, std::move(rows));
+    cache.lookup(admindir, stamp, names, results);
   }
 
   return results;
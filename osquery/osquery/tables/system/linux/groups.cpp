@@ -13,8 +13,8 @@
 
 #include <osquery/core/core.h>
 #include <osquery/core/tables.h>
+#include <osquery/system/usersgroups/linux/users_groups_cache.h>
 #include <osquery/worker/ipc/platform_table_container_ipc.h>
-#include <osquery/worker/logging/glog/glog_logger.h>
 
 namespace osquery {
 namespace tables {
@@ -26,6 +26,13 @@ void setGroupRow(Row& r, const group* grp) {
   r["pid_with_namespace"] = "0";
 }
 
+void setGroupRow(Row& r, const Group& group) {
+  r["groupname"] = SQL_TEXT(group.groupname);
+  r["gid"] = INTEGER(group.gid);
+  r["gid_signed"] = INTEGER((int32_t)group.gid);
+  r["pid_with_namespace"] = "0";
+}
+
 QueryData genGroupsImpl(QueryContext& context, Logger& logger) {
   QueryData results;
   struct group* grp_result{nullptr};
@@ -71,12 +78,37 @@ QueryData genGroupsImpl(QueryContext& context, Logger& logger) {
   return results;
 }
 
+/// Groups of the host are looked up in the shared index, not through NSS.
+QueryData genCachedGroups(QueryContext& context) {
+  QueryData results;
+  auto index = UsersGroupsCache::get().getIndex();
+
+  if (context.constraints["gid"].exists(EQUALS)) {
+    auto gids = context.constraints["gid"].getAll<long long>(EQUALS);
+    for (const auto& gid : gids) {
+      auto group = index->getGroupByGid(gid);
+      if (group.has_value()) {
+        Row r;
+        setGroupRow(r, *group);
+        results.push_back(r);
+      }
+    }
+  } else {
+    for (const auto& group : index->getGroups()) {
+      Row r;
+      setGroupRow(r, group);
+      results.push_back(r);
+    }
+  }
+
+  return results;
+}
+
 QueryData genGroups(QueryContext& context) {
   if (hasNamespaceConstraint(context)) {
     return generateInNamespace(context, "groups", genGroupsImpl);
   } else {
-    GLOGLogger logger;
-    return genGroupsImpl(context, logger);
+    return genCachedGroups(context);
   }
 }
 } // namespace tables
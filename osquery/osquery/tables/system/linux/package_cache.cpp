@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <sys/stat.h>
+
+#include <boost/filesystem.hpp>
+
+#include <osquery/tables/system/linux/package_cache.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+namespace tables {
+
+namespace {
+
+void appendStamp(const std::string& path, std::string& stamp) {
+  struct stat file_stat;
+  stamp += path;
+  if (::stat(path.c_str(), &file_stat) != 0) {
+    stamp += ":-;";
+    return;
+  }
+
+  stamp += ":" + std::to_string(file_stat.st_ino) + ":" +
+           std::to_string(file_stat.st_size) + ":" +
+           std::to_string(file_stat.st_mtim.tv_sec) + "." +
+           std::to_string(file_stat.st_mtim.tv_nsec) + ";";
+}
+
+} // namespace
+
+std::string PackageCache::stamp(const std::vector<std::string>& paths) {
+  std::string stamp;
+  for (const auto& path : paths) {
+    appendStamp(path, stamp);
+
+    boost::system::error_code ec;
+    if (!fs::is_directory(path, ec)) {
+      continue;
+    }
+
+    // Directory iteration order is not stable, sort the entries.
+    std::set<std::string> entries;
+    for (fs::directory_iterator it(path, ec), end; !ec && it != end;
+         it.increment(ec)) {
+      entries.insert(it->path().string());
+    }
+    for (const auto& entry : entries) {
+      appendStamp(entry, stamp);
+    }
+  }
+  return stamp;
+}
+
+bool PackageCache::lookup(const std::string& key,
+                          const std::string& stamp,
+                          const std::set<std::string>& names,
+                          QueryData& results) const {
+  ReadLock lock(mutex_);
+  auto entry = entries_.find(key);
+  if (entry == entries_.end() || entry->second.stamp != stamp) {
+    return false;
+  }
+
+  const auto& cached = entry->second;
+  if (names.empty()) {
+    results.insert(results.end(), cached.rows.begin(), cached.rows.end());
+    return true;
+  }
+
+  for (const auto& name : names) {
+    auto range = cached.names.equal_range(name);
+    for (auto it = range.first; it != range.second; ++it) {
+      results.push_back(cached.rows[it->second]);
+    }
+  }
+  return true;
+}
+
+void PackageCache::update(const std::string& key,
+                          const std::string& stamp,
+                          QueryData rows) {
+  Entry entry;
+  entry.stamp = stamp;
+  entry.rows = std::move(rows);
+  for (size_t i = 0; i < entry.rows.size(); i++) {
+    auto name = entry.rows[i].find("name");
+    if (name != entry.rows[i].end()) {
+      entry.names.emplace(name->second, i);
+    }
+  }
+
+  WriteLock lock(mutex_);
+  entries_[key] = std::move(entry);
+}
+
+} // namespace tables
+} // namespace osquery
@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/core/sql/query_data.h>
+#include <osquery/utils/mutex.h>
+
+namespace osquery {
+namespace tables {
+
+/**
+ * @brief A parsed package inventory, re-read only when its database changes.
+ *
+ * Package databases change rarely but are expensive to open and parse. The
+ * rows for each database are kept along with a stamp of the database files
+ * (inode, size, and modification time) that must match for a cache hit.
+ */
+class PackageCache : private boost::noncopyable {
+ public:
+  /**
+   * @brief Build a change stamp for a set of files or directories.
+   *
+   * A directory stamp includes every file directly within the directory.
+   * Missing paths are part of the stamp, so creating them is a change.
+   */
+  static std::string stamp(const std::vector<std::string>& paths);
+
+  /**
+   * @brief Append the cached rows for a database if the stamp matches.
+   *
+   * @param key The package database (e.g., the dpkg admindir).
+   * @param stamp The current stamp of the database files.
+   * @param names Only rows with these package names, all rows if empty.
+   * @param results Output rows.
+   * @return false if the rows must be generated and updated.
+   */
+  bool lookup(const std::string& key,
+              const std::string& stamp,
+              const std::set<std::string>& names,
+              QueryData& results) const;
+
+  /// Replace the cached rows for a database.
+  void update(const std::string& key, const std::string& stamp, QueryData rows);
+
+ private:
+  struct Entry {
+    std::string stamp;
+    QueryData rows;
+    std::unordered_multimap<std::string, size_t> names;
+  };
+
+  /// Cached inventories for each database key.
+  std::map<std::string, Entry> entries_;
+
+  /// Protect the entries from concurrent queries.
+  mutable Mutex mutex_;
+};
+
+} // namespace tables
+} // namespace osquery
@@ -22,6 +22,7 @@
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
 #include <osquery/sql/dynamic_table_row.h>
+#include <osquery/tables/system/linux/package_cache.h>
 #include <osquery/worker/ipc/platform_table_container_ipc.h>
 #include <osquery/worker/logging/glog/glog_logger.h>
 
@@ -125,9 +126,38 @@ class RpmEnvironmentManager : public boost::noncopyable {
   Logger* logger_;
 };
 
+/**
+ * The database files of the BDB, sqlite and ndb rpmdb backends.
+ *
+ * The __db.* environment and sqlite -shm/-wal files are touched by every
+ * reader and are not stamped. The sqlite WAL is checkpointed into
+ * rpmdb.sqlite when the last connection closes.
+ */
+const std::vector<std::string> kRpmDatabaseFiles = {
+    "/var/lib/rpm/Packages",
+    "/var/lib/rpm/rpmdb.sqlite",
+    "/var/lib/rpm/Packages.db",
+    "/usr/lib/sysimage/rpm/Packages",
+    "/usr/lib/sysimage/rpm/rpmdb.sqlite",
+    "/usr/lib/sysimage/rpm/Packages.db",
+};
+
 QueryData genRpmPackagesImpl(QueryContext& context, Logger& logger) {
   QueryData results;
 
+  std::set<std::string> names;
+  if (context.hasConstraint("name", EQUALS)) {
+    names = context.constraints["name"].getAll(EQUALS);
+  }
+
+  // The rpmdb is rewritten in place by every transaction; the legacy and the
+  // sysimage locations are both stamped since either may be in use.
+  static PackageCache cache;
+  auto stamp = PackageCache::stamp(kRpmDatabaseFiles);
+  if (cache.lookup("rpm", stamp, names, results)) {
+    return results;
+  }
+
   auto dropper = DropPrivileges::get();
   if (!dropper->dropTo("nobody") && isUserAdmin()) {
     logger.log(google::GLOG_WARNING, "Cannot drop privileges for rpm_packages");
@@ -144,15 +174,11 @@ QueryData genRpmPackagesImpl(QueryContext& context, Logger& logger) {
     return results;
   }
 
+  // Read every package, the name constraints are applied by the cache.
   rpmts ts = rpmtsCreate();
-  rpmdbMatchIterator matches;
-  if (context.constraints["name"].exists(EQUALS)) {
-    auto name = (*context.constraints["name"].getAll(EQUALS).begin());
-    matches = rpmtsInitIterator(ts, RPMTAG_NAME, name.c_str(), name.size());
-  } else {
-    matches = rpmtsInitIterator(ts, RPMTAG_NAME, nullptr, 0);
-  }
+  rpmdbMatchIterator matches = rpmtsInitIterator(ts, RPMTAG_NAME, nullptr, 0);
 
+  QueryData rows;
   Header header;
   while ((header = rpmdbNextIterator(matches)) != nullptr) {
     Row r;
@@ -172,7 +198,7 @@ QueryData genRpmPackagesImpl(QueryContext& context, Logger& logger) {
     r["pid_with_namespace"] = "0";
 
     rpmtdFree(td);
-    results.push_back(r);
+    rows.push_back(std::move(r));
   }
 
   rpmdbFreeIterator(matches);
@@ -180,6 +206,8 @@ QueryData genRpmPackagesImpl(QueryContext& context, Logger& logger) {
   rpmFreeCrypto();
   rpmFreeRpmrc();
 
+  cache.update("rpm", stamp, std::move(rows));
+  cache.lookup("rpm", stamp, names, results);
   return results;
 }
 
@@ -8,12 +8,12 @@
  */
 
 #include <sys/shm.h>
-#include <pwd.h>
 
 #include <osquery/core/core.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
+#include <osquery/system/usersgroups/linux/users_groups_cache.h>
 
 namespace osquery {
 namespace tables {
@@ -38,6 +38,9 @@ QueryData genSharedMemory(QueryContext &context) {
     return {};
   }
 
+  // Owners are resolved in the shared users index.
+  auto index = UsersGroupsCache::get().getIndex();
+
   // Use a static pointer to access IPC permissions structure.
   struct shmid_ds shmseg;
   struct ipc_perm *ipcp = &shmseg.shm_perm;
@@ -52,14 +55,14 @@ QueryData genSharedMemory(QueryContext &context) {
     Row r;
     r["shmid"] = INTEGER(shmid);
 
-    struct passwd *pw = getpwuid(shmseg.shm_perm.uid);
-    if (pw != nullptr) {
-      r["owner_uid"] = BIGINT(pw->pw_uid);
+    auto owner = index->getUserByUid(shmseg.shm_perm.uid);
+    if (owner.has_value()) {
+      r["owner_uid"] = BIGINT(owner->uid);
     }
 
-    pw = getpwuid(shmseg.shm_perm.cuid);
-    if (pw != nullptr) {
-      r["creator_uid"] = BIGINT(pw->pw_uid);
+    auto creator = index->getUserByUid(shmseg.shm_perm.cuid);
+    if (creator.has_value()) {
+      r["creator_uid"] = BIGINT(creator->uid);
     }
 
     // Accessor, creator pids.
@@ -11,37 +11,47 @@
 
 #include <osquery/core/core.h>
 #include <osquery/core/tables.h>
+#include <osquery/system/usersgroups/linux/users_groups_cache.h>
 #include <osquery/utils/conversions/tryto.h>
 #include <osquery/worker/ipc/platform_table_container_ipc.h>
-#include <osquery/worker/logging/glog/glog_logger.h>
 
 namespace osquery {
 namespace tables {
 
-void genUser(const struct passwd* pwd, QueryData& results) {
+void genUser(const User& user, QueryData& results) {
   Row r;
-  r["uid"] = BIGINT(pwd->pw_uid);
-  r["gid"] = BIGINT(pwd->pw_gid);
-  r["uid_signed"] = BIGINT((int32_t)pwd->pw_uid);
-  r["gid_signed"] = BIGINT((int32_t)pwd->pw_gid);
+  r["uid"] = BIGINT(user.uid);
+  r["gid"] = BIGINT(user.gid);
+  r["uid_signed"] = BIGINT((int32_t)user.uid);
+  r["gid_signed"] = BIGINT((int32_t)user.gid);
+  r["username"] = SQL_TEXT(user.username);
+  r["description"] = SQL_TEXT(user.description);
+  r["directory"] = SQL_TEXT(user.directory);
+  r["shell"] = SQL_TEXT(user.shell);
+  r["pid_with_namespace"] = "0";
+  results.push_back(r);
+}
 
+void genUser(const struct passwd* pwd, QueryData& results) {
+  User user;
+  user.uid = pwd->pw_uid;
+  user.gid = pwd->pw_gid;
   if (pwd->pw_name != nullptr) {
-    r["username"] = SQL_TEXT(pwd->pw_name);
+    user.username = pwd->pw_name;
   }
 
   if (pwd->pw_gecos != nullptr) {
-    r["description"] = SQL_TEXT(pwd->pw_gecos);
+    user.description = pwd->pw_gecos;
   }
 
   if (pwd->pw_dir != nullptr) {
-    r["directory"] = SQL_TEXT(pwd->pw_dir);
+    user.directory = pwd->pw_dir;
   }
 
   if (pwd->pw_shell != nullptr) {
-    r["shell"] = SQL_TEXT(pwd->pw_shell);
+    user.shell = pwd->pw_shell;
   }
-  r["pid_with_namespace"] = "0";
-  results.push_back(r);
+  genUser(user, results);
 }
 
 QueryData genUsersImpl(QueryContext& context, Logger& logger) {
@@ -89,12 +99,44 @@ QueryData genUsersImpl(QueryContext& context, Logger& logger) {
   return results;
 }
 
+/// Users of the host are looked up in the shared index, not through NSS.
+QueryData genCachedUsers(QueryContext& context) {
+  QueryData results;
+  auto index = UsersGroupsCache::get().getIndex();
+
+  if (context.constraints["uid"].exists(EQUALS)) {
+    auto uids = context.constraints["uid"].getAll(EQUALS);
+    for (const auto& uid : uids) {
+      auto const auid_exp = tryTo<long>(uid, 10);
+      if (auid_exp.isValue()) {
+        auto user = index->getUserByUid(auid_exp.get());
+        if (user.has_value()) {
+          genUser(*user, results);
+        }
+      }
+    }
+  } else if (context.constraints["username"].exists(EQUALS)) {
+    auto usernames = context.constraints["username"].getAll(EQUALS);
+    for (const auto& username : usernames) {
+      auto user = index->getUserByName(username);
+      if (user.has_value()) {
+        genUser(*user, results);
+      }
+    }
+  } else {
+    for (const auto& user : index->getUsers()) {
+      genUser(user, results);
+    }
+  }
+
+  return results;
+}
+
 QueryData genUsers(QueryContext& context) {
   if (hasNamespaceConstraint(context)) {
     return generateInNamespace(context, "users", genUsersImpl);
   } else {
-    GLOGLogger logger;
-    return genUsersImpl(context, logger);
+    return genCachedUsers(context);
   }
 }
 } // namespace tables
@@ -119,6 +119,9 @@ class AugeasHandle {
   augeas* aug{nullptr};
   bool error{false};
 
+  /// The augeas tree is shared, concurrent queries load and match in turn.
+  std::mutex mutex;
+
   void initialize() {
     std::call_once(initialized, [this]() {
       this->aug = aug_init(
@@ -226,11 +229,13 @@ QueryData genAugeas(QueryContext& context) {
   }
 
   augeas* aug = kAugeasHandle.aug;
+  std::lock_guard<std::mutex> lock(kAugeasHandle.mutex);
 
   // Load everything. While it would be interesting to do this for
   // only the requested files, it's not clearly possible to
   // _unload_. So at present, load everything. (For reference, it
   // takes abvout 0.3 seconds to run aug_load on seph's laptop.)
+  // Once loaded, aug_load only parses the files whose mtime changed.
   int ret = aug_load(aug);
   if (ret != 0) {
     LOG(ERROR) << "An error has occurred while trying to load augeas: "
@@ -7,11 +7,14 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <iterator>
+#include <tuple>
 #include <vector>
 
 #include <osquery/core/core.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
+#include <osquery/filesystem/parsed_file_cache.h>
 
 #include <osquery/tables/system/posix/authorized_keys.h>
 #include <osquery/tables/system/system_utils.h>
@@ -47,7 +50,6 @@ bool KeyRingLabelOptExists(const std::string& line) {
 
 void GenerateKeyRow(const std::string& line,
                     const std::string& key_type,
-                    const std::string& uid,
                     const std::string& keys_file,
                     size_t key_type_pos,
                     QueryData& results) {
@@ -80,11 +82,84 @@ void GenerateKeyRow(const std::string& line,
 
   r["algorithm"] = key_type;
   r["key_file"] = keys_file;
-  r["uid"] = uid;
   r["pid_with_namespace"] = "0";
   results.push_back(r);
 }
 
+/// Parse the keys of an authorized_keys file, the uid is set per user.
+Status parseAuthorizedKeys(const std::string& keys_file,
+                           const std::string& keys_content,
+                           QueryData& rows) {
+  // Protocol 1 public key consist of: options, bits, exponent, modulus,
+  // comment; Protocol 2 public key consist of: options, keytype,
+  // base64-encoded key, comment.
+  for (const auto& line : split(keys_content, "\n")) {
+    if (!line.empty() && line[0] != '#') {
+      bool key_type_found = false;
+      // Iterate over known key types.
+      for (const auto& key_type : kSSHKeyTypes) {
+        auto key_type_start_pos = line.find(key_type);
+        if (key_type_start_pos == std::string::npos) {
+          continue;
+        }
+
+        auto key_type_end_pos = key_type_start_pos + key_type.length();
+        // Make sure key type is fully matched.
+        if (line[key_type_end_pos] != ' ' && line[key_type_end_pos] != '\t') {
+          continue;
+        }
+
+        GenerateKeyRow(line, key_type, keys_file, key_type_start_pos, rows);
+
+        key_type_found = true;
+        break;
+      }
+
+      // If key type can't be found and options are supplied,
+      // Check the existence of the 'zos-key-ring-label' parameter in the
+      // options section. If so, only options should be set in current row.
+      if (!key_type_found && KeyRingLabelOptExists(line)) {
+        Row r = {{"options", line},
+                 {"key_file", keys_file},
+                 {"pid_with_namespace", "0"}};
+        rows.push_back(r);
+      }
+    }
+  }
+  return Status::success();
+}
+
+ParsedFileCache<QueryData> kAuthorizedKeysCache(parseAuthorizedKeys);
+
+namespace {
+
+/// Keeps the messages of a parse worker for the query's logger.
+class BufferedLogger : public Logger {
+ public:
+  void log(int severity, const std::string& message) override {
+    messages_.emplace_back(false, severity, message);
+  }
+
+  void vlog(int severity, const std::string& message) override {
+    messages_.emplace_back(true, severity, message);
+  }
+
+  void replay(Logger& logger) const {
+    for (const auto& message : messages_) {
+      if (std::get<0>(message)) {
+        logger.vlog(std::get<1>(message), std::get<2>(message));
+      } else {
+        logger.log(std::get<1>(message), std::get<2>(message));
+      }
+    }
+  }
+
+ private:
+  std::vector<std::tuple<bool, int, std::string>> messages_;
+};
+
+} // namespace
+
 void genSSHkeysForUser(const std::string& uid,
                        const std::string& gid,
                        const std::string& directory,
@@ -94,61 +169,22 @@ void genSSHkeysForUser(const std::string& uid,
     boost::filesystem::path keys_file = directory;
     keys_file /= kfile;
 
-    std::string keys_content;
-
     if (!pathExists(keys_file).ok()) {
       // no authorized key file present, keep going
       continue;
     }
 
-    auto s = readFile(keys_file, keys_content, false, false, false);
+    std::shared_ptr<const QueryData> rows;
+    auto s = kAuthorizedKeysCache.get(keys_file.string(), rows);
     if (!s.ok()) {
       // Cannot read a specific keys file.
       logger.log(google::GLOG_ERROR, s.getMessage());
       return;
     }
 
-    // Protocol 1 public key consist of: options, bits, exponent, modulus,
-    // comment; Protocol 2 public key consist of: options, keytype,
-    // base64-encoded key, comment.
-    for (const auto& line : split(keys_content, "\n")) {
-      if (!line.empty() && line[0] != '#') {
-        bool key_type_found = false;
-        // Iterate over known key types.
-        for (const auto& key_type : kSSHKeyTypes) {
-          auto key_type_start_pos = line.find(key_type);
-          if (key_type_start_pos == std::string::npos) {
-            continue;
-          }
-
-          auto key_type_end_pos = key_type_start_pos + key_type.length();
-          // Make sure key type is fully matched.
-          if (line[key_type_end_pos] != ' ' && line[key_type_end_pos] != '\t') {
-            continue;
-          }
-
-          GenerateKeyRow(line,
-                         key_type,
-                         uid,
-                         keys_file.string(),
-                         key_type_start_pos,
-                         results);
-
-          key_type_found = true;
-          break;
-        }
-
-        // If key type can't be found and options are supplied,
-        // Check the existence of the 'zos-key-ring-label' parameter in the
-        // options section. If so, only options should be set in current row.
-        if (!key_type_found && KeyRingLabelOptExists(line)) {
-          Row r = {{"uid", uid},
-                   {"options", line},
-                   {"key_file", keys_file.string()},
-                   {"pid_with_namespace", "0"}};
-          results.push_back(r);
-        }
-      }
+    for (const auto& row : *rows) {
+      results.push_back(row);
+      results.back()["uid"] = uid;
     }
   }
 }
@@ -156,16 +192,29 @@ void genSSHkeysForUser(const std::string& uid,
 QueryData getAuthorizedKeysImpl(QueryContext& context, Logger& logger) {
   QueryData results;
 
-  // Iterate over each user
+  // Parse the keys of each user concurrently, keeping the user order.
   QueryData users = usersFromContext(context);
-  for (const auto& row : users) {
+  std::vector<QueryData> user_results(users.size());
+  std::vector<BufferedLogger> user_loggers(users.size());
+  parseFilesInParallel(users.size(), [&](size_t i) {
+    const auto& row = users[i];
     auto uid = row.find("uid");
     auto gid = row.find("gid");
     auto directory = row.find("directory");
     if (uid != row.end() && gid != row.end() && directory != row.end()) {
-      genSSHkeysForUser(
-          uid->second, gid->second, directory->second, results, logger);
+      genSSHkeysForUser(uid->second,
+                        gid->second,
+                        directory->second,
+                        user_results[i],
+                        user_loggers[i]);
     }
+  });
+
+  for (size_t i = 0; i < users.size(); ++i) {
+    user_loggers[i].replay(logger);
+    results.insert(results.end(),
+                   std::make_move_iterator(user_results[i].begin()),
+                   std::make_move_iterator(user_results[i].end()));
   }
 
   return results;
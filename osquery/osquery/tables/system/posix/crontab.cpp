@@ -14,6 +14,7 @@
 #include <osquery/core/core.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
+#include <osquery/filesystem/parsed_file_cache.h>
 #include <osquery/logger/logger.h>
 #include <osquery/utils/conversions/split.h>
 #include <osquery/worker/ipc/platform_table_container_ipc.h>
@@ -31,33 +32,6 @@ const std::vector<std::string> kCronSearchDirs = {
     "/var/spool/cron/crontabs/", // user linux:debian
 };
 
-std::vector<std::string> cronFromFile(const std::string& path, Logger& logger) {
-  std::string content;
-  std::vector<std::string> cron_lines;
-  if (!isReadable(path).ok()) {
-    return cron_lines;
-  }
-
-  auto s = readFile(path, content, false, false, false);
-  if (!s.ok()) {
-    logger.log(google::GLOG_WARNING, s.getMessage());
-    return cron_lines;
-  }
-
-  auto lines = split(content, "\n");
-
-  // Only populate the lines that are not comments or blank.
-  for (auto& line : lines) {
-    // Cheat and use a non-const iteration, to inline trim.
-    boost::trim(line);
-    if (line.size() > 0 && line.at(0) != '#') {
-      cron_lines.push_back(line);
-    }
-  }
-
-  return cron_lines;
-}
-
 void genCronLine(const std::string& path,
                  const std::string& line,
                  QueryData& results) {
@@ -103,6 +77,22 @@ void genCronLine(const std::string& path,
   results.push_back(r);
 }
 
+/// Parse the rows of a crontab, skipping comments and blank lines.
+Status parseCronTab(const std::string& path,
+                    const std::string& content,
+                    QueryData& rows) {
+  for (auto& line : split(content, "\n")) {
+    // Cheat and use a non-const iteration, to inline trim.
+    boost::trim(line);
+    if (line.size() > 0 && line.at(0) != '#') {
+      genCronLine(path, line, rows);
+    }
+  }
+  return Status::success();
+}
+
+ParsedFileCache<QueryData> kCronTabCache(parseCronTab);
+
 QueryData genCronTabImpl(QueryContext& context, Logger& logger) {
   QueryData results;
   std::vector<std::string> file_list;
@@ -114,10 +104,17 @@ QueryData genCronTabImpl(QueryContext& context, Logger& logger) {
   }
 
   for (const auto& file_path : file_list) {
-    auto lines = cronFromFile(file_path, logger);
-    for (const auto& line : lines) {
-      genCronLine(file_path, line, results);
+    if (!isReadable(file_path).ok()) {
+      continue;
+    }
+
+    std::shared_ptr<const QueryData> rows;
+    auto s = kCronTabCache.get(file_path, rows);
+    if (!s.ok()) {
+      logger.log(google::GLOG_WARNING, s.getMessage());
+      continue;
     }
+    results.insert(results.end(), rows->begin(), rows->end());
   }
 
   return results;
@@ -7,7 +7,9 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <iterator>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
@@ -16,6 +18,7 @@
 #include <osquery/core/core.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
+#include <osquery/filesystem/parsed_file_cache.h>
 #include <osquery/logger/logger.h>
 #include <osquery/tables/system/system_utils.h>
 #include <osquery/utils/conversions/split.h>
@@ -32,22 +35,19 @@ const std::string kSystemwideSshConfig = "/etc/ssh/ssh_config";
 const std::string kWindowsSystemwideSshConfig =
     "\\ProgramData\\ssh\\ssh_config";
 
-void genSshConfig(const std::string& uid,
-                  const std::string& gid,
-                  const fs::path& filepath,
-                  QueryData& results) {
-  std::string ssh_config_content;
-  if (!readFile(filepath, ssh_config_content).ok()) {
-    VLOG(1) << "Cannot read ssh_config file " << filepath;
-    return;
-  }
+/// The (block, option) pairs of an ssh_config file.
+using SshConfigOptions = std::vector<std::pair<std::string, std::string>>;
+
+Status parseSshConfig(const std::string& path,
+                      const std::string& content,
+                      SshConfigOptions& options) {
   // the ssh_config file consists of a number of host or match
   // blocks containing newline-separated options for each
   // block; a block is defined as everything following a
   // host or match keyword, until the next host or match
   // keyword, else EOF
   std::string block;
-  for (auto& line : split(ssh_config_content, "\n")) {
+  for (auto& line : split(content, "\n")) {
     boost::trim(line);
     boost::to_lower(line);
     if (line.empty() || line[0] == '#') {
@@ -57,14 +57,33 @@ void genSshConfig(const std::string& uid,
         boost::starts_with(line, "match ")) {
       block = line;
     } else {
-      Row r = {{"uid", uid},
-               {"block", block},
-               {"option", line},
-               {"ssh_config_file", filepath.string()}};
-      results.push_back(r);
+      options.emplace_back(block, line);
     }
   }
+  return Status::success();
 }
+
+ParsedFileCache<SshConfigOptions> kSshConfigCache(parseSshConfig);
+
+void genSshConfig(const std::string& uid,
+                  const std::string& gid,
+                  const fs::path& filepath,
+                  QueryData& results) {
+  std::shared_ptr<const SshConfigOptions> options;
+  if (!kSshConfigCache.get(filepath.string(), options).ok()) {
+    VLOG(1) << "Cannot read ssh_config file " << filepath;
+    return;
+  }
+
+  for (const auto& option : *options) {
+    Row r = {{"uid", uid},
+             {"block", option.first},
+             {"option", option.second},
+             {"ssh_config_file", filepath.string()}};
+    results.push_back(r);
+  }
+}
+
 void genSshConfigForUser(const std::string& uid,
                          const std::string& gid,
                          const std::string& directory,
@@ -74,18 +93,28 @@ void genSshConfigForUser(const std::string& uid,
 
   genSshConfig(uid, gid, ssh_config_file, results);
 }
+
 QueryData getSshConfigs(QueryContext& context) {
   QueryData results;
 
-  // Iterate over each user
+  // Parse the config of each user concurrently, keeping the user order.
   QueryData users = usersFromContext(context);
-  for (const auto& row : users) {
+  std::vector<QueryData> user_results(users.size());
+  parseFilesInParallel(users.size(), [&users, &user_results](size_t i) {
+    const auto& row = users[i];
     auto uid = row.find("uid");
     auto gid = row.find("gid");
     auto directory = row.find("directory");
     if (uid != row.end() && gid != row.end() && directory != row.end()) {
-      genSshConfigForUser(uid->second, gid->second, directory->second, results);
+      genSshConfigForUser(
+          uid->second, gid->second, directory->second, user_results[i]);
     }
+  });
+
+  for (auto& rows : user_results) {
+    results.insert(results.end(),
+                   std::make_move_iterator(rows.begin()),
+                   std::make_move_iterator(rows.end()));
   }
 
   if (isPlatform(PlatformType::TYPE_WINDOWS)) {
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+#include <osquery/tables/system/linux/package_cache.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+namespace tables {
+
+class PackageCacheTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    root_ = fs::temp_directory_path() /
+            fs::unique_path("osquery.package_cache.%%%%-%%%%");
+    fs::create_directories(root_ / "updates");
+    writeStatus("Package: one\n");
+  }
+
+  void TearDown() override {
+    fs::remove_all(root_);
+  }
+
+  void writeStatus(const std::string& content) {
+    std::ofstream status((root_ / "status").string(), std::ios::trunc);
+    status << content;
+  }
+
+  std::string stamp() const {
+    return PackageCache::stamp(
+        {(root_ / "status").string(), (root_ / "updates").string()});
+  }
+
+  fs::path root_;
+};
+
+TEST_F(PackageCacheTests, test_stamp_changes) {
+  auto first = stamp();
+  EXPECT_EQ(first, stamp());
+
+  writeStatus("Package: one\n\nPackage: two\n");
+  auto second = stamp();
+  EXPECT_NE(first, second);
+
+  // A journal entry in a stamped directory is a change.
+  std::ofstream((root_ / "updates" / "0001").string()) << "Package: three\n";
+  EXPECT_NE(second, stamp());
+
+  // Missing paths are stamped too.
+  auto missing = (root_ / "missing").string();
+  auto before = PackageCache::stamp({missing});
+  std::ofstream(missing) << "";
+  EXPECT_NE(before, PackageCache::stamp({missing}));
+}
+
+TEST_F(PackageCacheTests, test_lookup) {
+  PackageCache cache;
+  auto current = stamp();
+
+  QueryData results;
+  EXPECT_FALSE(cache.lookup("dpkg", current, {}, results));
+
+  QueryData rows = {
+      {{"name", "one"}, {"version", "1"}},
+      {{"name", "two"}, {"version", "2"}},
+      {{"name", "two"}, {"version", "2.1"}},
+  };
+  cache.update("dpkg", current, rows);
+
+  EXPECT_TRUE(cache.lookup("dpkg", current, {}, results));
+  EXPECT_EQ(results, rows);
+
+  results.clear();
+  EXPECT_TRUE(cache.lookup("dpkg", current, {"two", "none"}, results));
+  ASSERT_EQ(results.size(), 2U);
+  EXPECT_EQ(results[0].at("version"), "2");
+  EXPECT_EQ(results[1].at("version"), "2.1");
+
+  // Each database is cached independently.
+  results.clear();
+  EXPECT_FALSE(cache.lookup("other", current, {}, results));
+
+  // A changed database misses until it is updated.
+  writeStatus("Package: one\n\nPackage: two\n\nPackage: three\n");
+  EXPECT_FALSE(cache.lookup("dpkg", stamp(), {}, results));
+  EXPECT_TRUE(results.empty());
+}
+
+} // namespace tables
+} // namespace osquery
@@ -13,14 +13,17 @@
 #include <osquery/core/flags.h>
 #include <osquery/core/system.h>
 #include <osquery/core/tables.h>
+#include <osquery/database/database.h>
 #include <osquery/events/eventfactory.h>
 #include <osquery/events/eventpublisher.h>
 #include <osquery/events/eventsubscriber.h>
 #include <osquery/extensions/extensions.h>
+#include <osquery/extensions/native_modules.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
 #include <osquery/process/process.h>
 #include <osquery/registry/registry.h>
+#include <osquery/sql/query_profile.h>
 #include <osquery/sql/sql.h>
 #include <osquery/utils/info/platform_type.h>
 #include <osquery/utils/info/version.h>
@@ -85,6 +88,62 @@ QueryData genOsqueryEvents(QueryContext& context) {
   return results;
 }
 
+QueryData genOsqueryDatabaseStats(QueryContext& context) {
+  QueryData results;
+
+  PluginResponse stats;
+  auto status = getDatabaseStats(stats);
+  if (!status.ok()) {
+    VLOG(1) << "Cannot read database statistics: " << status.getMessage();
+    return results;
+  }
+
+  for (auto& domain_stats : stats) {
+    results.push_back(std::move(domain_stats));
+  }
+  return results;
+}
+
+QueryData genOsqueryQueryProfile(QueryContext& context) {
+  QueryData results;
+
+  for (const auto& query : QueryProfiles::get().snapshot()) {
+    const auto& profile = query.second.first;
+
+    Row r;
+    r["name"] = query.first;
+    r["wall_time_us"] = BIGINT(profile.micros);
+    r["statements"] = BIGINT(profile.statements);
+    r["vm_steps"] = BIGINT(profile.vm_steps);
+    r["fullscan_steps"] = BIGINT(profile.fullscan_steps);
+    r["sorts"] = BIGINT(profile.sorts);
+    r["autoindex_rows"] = BIGINT(profile.autoindex_rows);
+    r["memory_peak"] = BIGINT(profile.memory_peak);
+    r["last_executed"] = BIGINT(query.second.second);
+
+    // Report the query once even if it did not use any tables.
+    r["table_name"] = "";
+    r["filters"] = "0";
+    r["generate_time_us"] = "0";
+    r["rows_produced"] = "0";
+    r["rows_consumed"] = "0";
+    if (profile.tables.empty()) {
+      results.push_back(r);
+      continue;
+    }
+
+    for (const auto& table : profile.tables) {
+      r["table_name"] = table.first;
+      r["filters"] = BIGINT(table.second.filters);
+      r["generate_time_us"] = BIGINT(table.second.generate_micros);
+      r["rows_produced"] = BIGINT(table.second.rows_produced);
+      r["rows_consumed"] = BIGINT(table.second.rows_consumed);
+      results.push_back(r);
+    }
+  }
+  return results;
+}
+
 QueryData genOsqueryPacks(QueryContext& context) {
   QueryData results;
 
@@ -195,6 +254,16 @@ QueryData genOsqueryExtensions(QueryContext& context) {
     }
   }
 
+  // Native modules are loaded in-process and have no extension route.
+  for (const auto& module : getNativeModules()) {
+    Row r;
+    r["name"] = module.name;
+    r["version"] = module.version;
+    r["path"] = module.path;
+    r["type"] = "module";
+    results.push_back(r);
+  }
+
   return results;
 }
 
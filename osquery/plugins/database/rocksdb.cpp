@@ -11,7 +11,9 @@
 
 #include <rocksdb/db.h>
 #include <rocksdb/env.h>
+#include <rocksdb/filter_policy.h>
 #include <rocksdb/options.h>
+#include <rocksdb/table.h>
 
 #include <osquery/core/flags.h>
 #include <osquery/filesystem/fileops.h>
@@ -31,6 +33,11 @@ HIDDEN_FLAG(int32, rocksdb_merge_number, 4, "Min write buffer number to merge");
 HIDDEN_FLAG(int32, rocksdb_background_flushes, 4, "Max background flushes");
 HIDDEN_FLAG(int32, rocksdb_buffer_blocks, 256, "Write buffer blocks (4k)");
 
+HIDDEN_FLAG(bool,
+            rocksdb_domain_profiles,
+            true,
+            "Tune RocksDB column family options for each database domain");
+
 DECLARE_string(database_path);
 
 /**
@@ -123,15 +130,20 @@ Status RocksDBDatabasePlugin::setUp() {
     }
     options_.info_log = logger_;
 
+    // The handle used for kDomains[i] is handles_[i], which is the column
+    // family opened at position i (the default column family is first).
+    // Tune each column family for the domain that is stored within it.
     std::set<std::string> domain_set;
-    column_families_.push_back(rocksdb::ColumnFamilyDescriptor(
-        rocksdb::kDefaultColumnFamilyName, options_));
+    column_families_.push_back(
+        rocksdb::ColumnFamilyDescriptor(rocksdb::kDefaultColumnFamilyName,
+                                        getColumnFamilyOptions(kDomains[0])));
     domain_set.insert(rocksdb::kDefaultColumnFamilyName);
 
-    for (const auto& cf_name : kDomains) {
-      column_families_.push_back(
-          rocksdb::ColumnFamilyDescriptor(cf_name, options_));
-      domain_set.insert(cf_name);
+    for (size_t i = 0; i < kDomains.size(); i++) {
+      std::string stored = (i + 1 < kDomains.size()) ? kDomains[i + 1] : "";
+      column_families_.push_back(rocksdb::ColumnFamilyDescriptor(
+          kDomains[i], getColumnFamilyOptions(stored)));
+      domain_set.insert(kDomains[i]);
     }
 
     // To support osquery rollbacks, meaning running with a database
@@ -203,6 +215,38 @@ Status RocksDBDatabasePlugin::setUp() {
   return Status(0);
 }
 
+rocksdb::ColumnFamilyOptions RocksDBDatabasePlugin::getColumnFamilyOptions(
+    const std::string& domain) const {
+  rocksdb::ColumnFamilyOptions cf_options(options_);
+  if (!FLAGS_rocksdb_domain_profiles) {
+    return cf_options;
+  }
+
+  if (domain == kEvents) {
+    // Events are written in large batches and expired in whole time ranges.
+    // Universal compaction rewrites each record far fewer times than leveled
+    // compaction and larger memtables absorb bursts without stalling writers.
+    cf_options.compaction_style = rocksdb::kCompactionStyleUniversal;
+    cf_options.compaction_options_universal.allow_trivial_move = true;
+    cf_options.write_buffer_size = options_.write_buffer_size * 4;
+  } else if (domain == kQueries || domain == kPersistentSettings ||
+             domain == kQueryPerformance) {
+    // Point lookups by query name dominate, skip SST reads using filters.
+    rocksdb::BlockBasedTableOptions table_options;
+    table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10));
+    cf_options.table_factory.reset(
+        rocksdb::NewBlockBasedTableFactory(table_options));
+    cf_options.write_buffer_size = options_.write_buffer_size * 2;
+  } else if (domain == kLogs) {
+    // Buffered logs are short-lived: written, read back once, then deleted.
+    // Keep them in memory long enough for most deletes to never reach disk.
+    cf_options.write_buffer_size = options_.write_buffer_size * 2;
+    cf_options.level0_file_num_compaction_trigger = 8;
+  }
+
+  return cf_options;
+}
+
 Status RocksDBDatabasePlugin::compactFiles(const std::string& domain) {
   auto handle = getHandleForColumnFamily(domain);
   if (handle == nullptr) {
@@ -452,17 +496,70 @@ Status RocksDBDatabasePlugin::scan(const std::string& domain,
     return Status(1, "Could not get iterator for " + domain);
   }
 
+  // Keys are ordered bytewise so every key with the prefix is contiguous.
   size_t count = 0;
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
-    auto key = it->key().ToString();
-    if (key.find(prefix) == 0) {
-      results.push_back(std::move(key));
-      if (max > 0 && ++count >= max) {
-        break;
-      }
+  for (it->Seek(prefix); it->Valid(); it->Next()) {
+    if (!it->key().starts_with(prefix)) {
+      break;
+    }
+
+    results.push_back(it->key().ToString());
+    if (max > 0 && ++count >= max) {
+      break;
     }
   }
   delete it;
   return Status::success();
 }
+
+Status RocksDBDatabasePlugin::stats(PluginResponse& response) const {
+  if (getDB() == nullptr) {
+    return Status(1, "Database not opened");
+  }
+
+  static const std::vector<std::pair<std::string, std::string>> kProperties = {
+      {"estimate_num_keys", rocksdb::DB::Properties::kEstimateNumKeys},
+      {"estimate_live_data_size",
+       rocksdb::DB::Properties::kEstimateLiveDataSize},
+      {"total_sst_files_size", rocksdb::DB::Properties::kTotalSstFilesSize},
+      {"memtable_size", rocksdb::DB::Properties::kCurSizeAllMemTables},
+      {"immutable_memtables", rocksdb::DB::Properties::kNumImmutableMemTable},
+      {"compaction_pending", rocksdb::DB::Properties::kCompactionPending},
+      {"running_compactions", rocksdb::DB::Properties::kNumRunningCompactions},
+      {"pending_compaction_bytes",
+       rocksdb::DB::Properties::kEstimatePendingCompactionBytes},
+      {"delayed_write_rate", rocksdb::DB::Properties::kActualDelayedWriteRate},
+      {"write_stopped", rocksdb::DB::Properties::kIsWriteStopped},
+  };
+
+  for (const auto& domain : kDomains) {
+    auto cfh = getHandleForColumnFamily(domain);
+    if (cfh == nullptr) {
+      continue;
+    }
+
+    PluginResponse::value_type r;
+    r["domain"] = domain;
+    for (const auto& property : kProperties) {
+      uint64_t value = 0;
+      getDB()->GetIntProperty(cfh, property.second, &value);
+      r[property.first] = std::to_string(value);
+    }
+
+    rocksdb::ColumnFamilyDescriptor descriptor;
+    if (cfh->GetDescriptor(&descriptor).ok()) {
+      auto style = descriptor.options.compaction_style;
+      if (style == rocksdb::kCompactionStyleUniversal) {
+        r["compaction_style"] = "universal";
+      } else if (style == rocksdb::kCompactionStyleFIFO) {
+        r["compaction_style"] = "fifo";
+      } else {
+        r["compaction_style"] = "level";
+      }
+    }
+    response.push_back(std::move(r));
+  }
+
+  return Status::success();
+}
 } // namespace osquery
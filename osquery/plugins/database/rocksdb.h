@@ -71,6 +71,9 @@ class RocksDBDatabasePlugin : public DatabasePlugin {
               const std::string& prefix,
               uint64_t max) const override;
 
+  /// Report RocksDB properties for each domain's column family.
+  Status stats(PluginResponse& response) const override;
+
  public:
   /// Database workflow: open and setup.
   Status setUp() override;
@@ -102,6 +105,19 @@ class RocksDBDatabasePlugin : public DatabasePlugin {
    */
   rocksdb::DB* getDB() const;
 
+  /**
+   * @brief Build the column family options used to store a domain.
+   *
+   * Domains have very different access patterns, events are written in bulk
+   * and expired in ranges while queries are mostly point lookups. Each domain
+   * starts from the shared options_ and applies a tuning profile.
+   *
+   * @param domain The domain stored in the column family, may be empty.
+   * @return The column family options.
+   */
+  rocksdb::ColumnFamilyOptions getColumnFamilyOptions(
+      const std::string& domain) const;
+
   /// Request RocksDB compact each domain and level to that same level.
   Status compactFiles(const std::string& domain);
 
@@ -152,5 +168,6 @@ class RocksDBDatabasePlugin : public DatabasePlugin {
   friend class GlogRocksDBLogger;
   FRIEND_TEST(RocksDBDatabasePluginTests, test_corruption);
   FRIEND_TEST(RocksDBDatabasePluginTests, test_column_families_rollback);
+  FRIEND_TEST(RocksDBDatabasePluginTests, test_column_family_options);
 };
 } // namespace osquery
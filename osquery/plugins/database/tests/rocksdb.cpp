@@ -94,4 +94,36 @@ TEST_F(RocksDBDatabasePluginTests, test_column_families_rollback) {
   ASSERT_TRUE(s.ok()) << s.getMessage();
   db2.tearDown();
 }
+
+TEST_F(RocksDBDatabasePluginTests, test_column_family_options) {
+  auto db = RocksDBDatabasePlugin();
+
+  auto events = db.getColumnFamilyOptions(kEvents);
+  EXPECT_EQ(events.compaction_style, rocksdb::kCompactionStyleUniversal);
+  EXPECT_GT(events.write_buffer_size, db.options_.write_buffer_size);
+
+  auto queries = db.getColumnFamilyOptions(kQueries);
+  EXPECT_EQ(queries.compaction_style, rocksdb::kCompactionStyleLevel);
+  EXPECT_NE(queries.table_factory, db.options_.table_factory);
+
+  // Unknown column families keep the shared options.
+  auto unknown = db.getColumnFamilyOptions("");
+  EXPECT_EQ(unknown.write_buffer_size, db.options_.write_buffer_size);
+  EXPECT_EQ(unknown.compaction_style, db.options_.compaction_style);
+}
+
+TEST_F(RocksDBDatabasePluginTests, test_stats) {
+  PluginResponse stats;
+  auto s = getDatabaseStats(stats);
+  ASSERT_TRUE(s.ok()) << s.getMessage();
+  ASSERT_EQ(stats.size(), kDomains.size());
+
+  for (const auto& domain_stats : stats) {
+    EXPECT_EQ(domain_stats.count("domain"), 1U);
+    EXPECT_EQ(domain_stats.count("estimate_num_keys"), 1U);
+    if (domain_stats.at("domain") == kEvents) {
+      EXPECT_EQ(domain_stats.at("compaction_style"), "universal");
+    }
+  }
+}
 } // namespace osquery
@@ -20,6 +20,9 @@
 #include <unistd.h>
 #endif
 
+#include <iostream>
+#include <set>
+
 #include <boost/algorithm/string/find.hpp>
 
 #include <osquery/config/config.h>
@@ -27,6 +30,8 @@
 #include <osquery/core/flags.h>
 #include <osquery/core/system.h>
 #include <osquery/dispatcher/dispatcher.h>
+#include <osquery/logger/data_logger.h>
+#include <osquery/numeric_monitoring/numeric_monitoring.h>
 #include <osquery/registry/registry_factory.h>
 #include <osquery/utils/json/json.h>
 
@@ -53,11 +58,58 @@ FLAG(string,
      "all",
      "The number of acknowledgments the leader has to receive (0, 1, 'all')");
 
-FLAG(
-    string,
-    logger_kafka_compression,
-    "none",
-    "Compression codec to use for compressing message sets ('none' or 'gzip')");
+FLAG(string,
+     logger_kafka_compression,
+     "none",
+     "Compression codec to use for compressing message sets ('none', 'gzip', "
+     "'snappy', 'lz4' or 'zstd', snappy is not available on Windows)");
+
+namespace {
+
+/// The codecs the vendored librdkafka is built with.
+#ifdef _WIN32
+const std::set<std::string> kKafkaCompressionCodecs = {
+    "none", "gzip", "lz4", "zstd"};
+#else
+const std::set<std::string> kKafkaCompressionCodecs = {
+    "none", "gzip", "snappy", "lz4", "zstd"};
+#endif
+
+bool validateKafkaCompression(const char* flagname, const std::string& value) {
+  if (kKafkaCompressionCodecs.count(value) > 0) {
+    return true;
+  }
+
+  auto message = "Kafka compression codec '" + value +
+                 "' is not available on this platform";
+  osquery::systemLog(message);
+  std::cerr << message << std::endl;
+  return false;
+}
+
+} // namespace
+
+DEFINE_validator(logger_kafka_compression, &validateKafkaCompression);
+
+FLAG(uint64,
+     logger_kafka_linger_ms,
+     5,
+     "Milliseconds to wait for more messages before sending a batch");
+
+FLAG(uint64,
+     logger_kafka_batch_messages,
+     10000,
+     "Maximum number of messages batched in one message set");
+
+FLAG(uint64,
+     logger_kafka_batch_bytes,
+     1000000,
+     "Maximum size in bytes of a batch sent to a partition");
+
+FLAG(string,
+     logger_kafka_partition_key,
+     "host",
+     "Message key used to select partitions ('host', 'query' or 'none')");
 
 /// How often to poll Kafka broker for publish results.
 const std::chrono::seconds kKafkaPollDuration = std::chrono::seconds(5);
@@ -136,15 +188,22 @@ inline std::string getMsgName(const std::string& payload) {
 /**
  * @brief callback for status of message delivery
  *
- * Logs an error message for failed deliveries; does nothing if successful.
- * Callback is invoked by rd_kafka_poll.
+ * Counts delivered and failed messages and logs an error message for failed
+ * deliveries. Callback is invoked by rd_kafka_poll.
  */
 void onMsgDelivery(rd_kafka_t* rk,
                    const rd_kafka_message_t* rkmessage,
                    void* opaque) {
+  auto* plugin = static_cast<KafkaProducerPlugin*>(opaque);
   if (rkmessage->err != RD_KAFKA_RESP_ERR_NO_ERROR) {
+    if (plugin != nullptr) {
+      plugin->deliveryFailed_++;
+    }
     LOG(ERROR) << "Kafka message delivery failed: "
                << rd_kafka_err2str(rkmessage->err);
+  } else if (plugin != nullptr) {
+    plugin->delivered_++;
+    plugin->deliveredBytes_ += rkmessage->len;
   }
 }
 
@@ -158,6 +217,28 @@ void KafkaProducerPlugin::pollKafka() {
   rd_kafka_poll(producer_.get(), 0 /*non-blocking*/);
 }
 
+void KafkaProducerPlugin::recordMetrics() {
+  monitoring::record("logger.kafka.delivered",
+                     delivered_.exchange(0),
+                     monitoring::PreAggregationType::Sum);
+  monitoring::record("logger.kafka.delivered_bytes",
+                     deliveredBytes_.exchange(0),
+                     monitoring::PreAggregationType::Sum);
+  monitoring::record("logger.kafka.delivery_failed",
+                     deliveryFailed_.exchange(0),
+                     monitoring::PreAggregationType::Sum);
+  monitoring::record("logger.kafka.produce_failed",
+                     produceFailed_.exchange(0),
+                     monitoring::PreAggregationType::Sum);
+
+  WriteLock lock(producerMutex_);
+  if (producer_ != nullptr) {
+    monitoring::record("logger.kafka.queue_length",
+                       rd_kafka_outq_len(producer_.get()),
+                       monitoring::PreAggregationType::Max);
+  }
+}
+
 void KafkaProducerPlugin::start() {
   while (!interrupted() && running_.load()) {
     pause(std::chrono::milliseconds(kKafkaPollDuration));
@@ -165,6 +246,7 @@ void KafkaProducerPlugin::start() {
       return;
     }
     pollKafka();
+    recordMetrics();
   }
 }
 
@@ -207,12 +289,29 @@ void KafkaProducerPlugin::init(const std::string& name,
 
   if (!setConf(conf, "client.id", hostname) ||
       !setConf(conf, "bootstrap.servers", FLAGS_logger_kafka_brokers) ||
-      !setConf(conf, "compression.codec", FLAGS_logger_kafka_compression)) {
+      !setConf(conf, "compression.codec", FLAGS_logger_kafka_compression) ||
+      !setConf(conf,
+               "linger.ms",
+               std::to_string(FLAGS_logger_kafka_linger_ms)) ||
+      !setConf(conf,
+               "batch.num.messages",
+               std::to_string(FLAGS_logger_kafka_batch_messages)) ||
+      !setConf(conf,
+               "batch.size",
+               std::to_string(FLAGS_logger_kafka_batch_bytes))) {
     return;
   }
 
-  // Register send callback.
+  if (FLAGS_logger_kafka_partition_key != "host" &&
+      FLAGS_logger_kafka_partition_key != "query" &&
+      FLAGS_logger_kafka_partition_key != "none") {
+    LOG(WARNING) << "Unknown Kafka partition key '"
+                 << FLAGS_logger_kafka_partition_key << "', using 'host'";
+  }
+
+  // Register send callback, the plugin receives the delivery counts.
   rd_kafka_conf_set_dr_msg_cb(conf, onMsgDelivery);
+  rd_kafka_conf_set_opaque(conf, this);
 
   // Create producer handle.
   char errstr[512] = {0};
@@ -265,8 +364,9 @@ Status KafkaProducerPlugin::logString(const std::string& payload) {
     return Status(2, errMsg);
   }
 
-  Status status = publishMsg(topic, payload);
+  Status status = publishMsg(topic, payload, getMsgKey(name));
   if (!status.ok()) {
+    produceFailed_++;
     LOG(ERROR) << "Could not publish message: " << status.getMessage();
   }
 
@@ -276,15 +376,27 @@ Status KafkaProducerPlugin::logString(const std::string& payload) {
   return status;
 }
 
+std::string KafkaProducerPlugin::getMsgKey(const std::string& name) const {
+  if (FLAGS_logger_kafka_partition_key == "query") {
+    // Results of the same query are kept in order within one partition.
+    return name;
+  } else if (FLAGS_logger_kafka_partition_key == "none") {
+    // Without a key the partitioner can fill larger batches.
+    return "";
+  }
+  return msgKey_;
+}
+
 Status KafkaProducerPlugin::publishMsg(rd_kafka_topic_t* topic,
-                                       const std::string& payload) {
+                                       const std::string& payload,
+                                       const std::string& key) {
   if (rd_kafka_produce(topic,
                        RD_KAFKA_PARTITION_UA,
                        RD_KAFKA_MSG_F_COPY,
                        (char*)payload.c_str(),
                        payload.length(),
-                       msgKey_.c_str(), // Optional key
-                       msgKey_.length(), // key length
+                       key.empty() ? nullptr : key.c_str(), // Optional key
+                       key.length(), // key length
                        nullptr) == -1) {
     return Status(1,
                   "Failed to produce on Kafka topic " +
@@ -27,6 +27,11 @@ extern const std::string kKafkaBaseTopic;
 /// Retrieves log payload field "name".
 std::string getMsgName(const std::string& payload);
 
+/// Delivery report callback, the opaque is the KafkaProducerPlugin.
+void onMsgDelivery(rd_kafka_t* rk,
+                   const rd_kafka_message_t* rkmessage,
+                   void* opaque);
+
 class KafkaProducerPlugin : public LoggerPlugin, public InternalRunnable {
  public:
   /*
@@ -72,12 +77,26 @@ class KafkaProducerPlugin : public LoggerPlugin, public InternalRunnable {
    * @brief Publishes message to Kafka topic.
    *
    * @param topic Kafka topic to publish to
-   * @param msg message body
+   * @param payload message body
+   * @param key message key used for partitioning, may be empty
    *
    * @return Status of publish attempt
    */
   virtual Status publishMsg(rd_kafka_topic_t* topic,
-                            const std::string& payload);
+                            const std::string& payload,
+                            const std::string& key);
+
+  /**
+   * @brief Select the message key for a log line.
+   *
+   * The key selects the partition. See --logger_kafka_partition_key.
+   *
+   * @param name The query name of the log line.
+   */
+  std::string getMsgKey(const std::string& name) const;
+
+  /// Report and reset the delivery counters as numeric monitoring points.
+  void recordMetrics();
 
   /**
    * @brief Flushes all buffered messages to Kafka, waiting for a maximum of 3
@@ -97,6 +116,21 @@ class KafkaProducerPlugin : public LoggerPlugin, public InternalRunnable {
   /// Map of query names to Kafka topic.
   std::map<std::string, rd_kafka_topic_t*> queryToTopics_;
 
+  /// OS hostname and binary name interpolated as the Kafka message key.
+  std::string msgKey_;
+
+  /// Messages acknowledged by the brokers since the last metrics report.
+  std::atomic<uint64_t> delivered_{0};
+
+  /// Payload bytes acknowledged by the brokers.
+  std::atomic<uint64_t> deliveredBytes_{0};
+
+  /// Messages that failed delivery after retries.
+  std::atomic<uint64_t> deliveryFailed_{0};
+
+  /// Messages librdkafka refused to enqueue, e.g., the queue was full.
+  std::atomic<uint64_t> produceFailed_{0};
+
  private:
   /// Configures Kafka topics accordingly.
   bool configureTopics();
@@ -112,13 +146,14 @@ class KafkaProducerPlugin : public LoggerPlugin, public InternalRunnable {
       std::unique_ptr<rd_kafka_topic_t, std::function<void(rd_kafka_topic_t*)>>>
       topics_;
 
-  /// OS hostname and binary name interpolated as the Kafka message key.
-  std::string msgKey_;
-
   /// Mutex for managing access to the producer_ pointer.
   Mutex producerMutex_;
 
   /// Flag to ensure shutdown method is called only once
   static std::once_flag shutdownFlag_;
+
+  friend void onMsgDelivery(rd_kafka_t* rk,
+                            const rd_kafka_message_t* rkmessage,
+                            void* opaque);
 };
 } // namespace osquery
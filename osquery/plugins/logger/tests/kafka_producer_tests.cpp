@@ -20,6 +20,7 @@
 #include <boost/chrono.hpp>
 
 #include <osquery/core/core.h>
+#include <osquery/core/flags.h>
 #include <osquery/core/system.h>
 #include <osquery/database/database.h>
 #include <osquery/registry/registry_interface.h>
@@ -29,6 +30,9 @@
 
 namespace osquery {
 
+DECLARE_string(logger_kafka_compression);
+DECLARE_string(logger_kafka_partition_key);
+
 class MockKafkaProducerPlugin : public KafkaProducerPlugin {
  public:
   MockKafkaProducerPlugin() : timesFlushed_(0), timesPolled_(0) {
@@ -43,15 +47,37 @@ class MockKafkaProducerPlugin : public KafkaProducerPlugin {
     queryToTopics_ = m;
   }
 
+  void setMsgKey(const std::string& key) {
+    msgKey_ = key;
+  }
+
+  uint64_t delivered() const {
+    return delivered_;
+  }
+
+  uint64_t deliveredBytes() const {
+    return deliveredBytes_;
+  }
+
+  uint64_t deliveryFailed() const {
+    return deliveryFailed_;
+  }
+
+  void resetMetrics() {
+    recordMetrics();
+  }
+
  protected:
   Status publishMsg(rd_kafka_topic_t* topic,
-                    const std::string& payload) override {
+                    const std::string& payload,
+                    const std::string& key) override {
     if (publishedMsgs_.find(topic) == publishedMsgs_.end()) {
       std::vector<std::string> msgs;
       publishedMsgs_[topic] = msgs;
     }
 
     publishedMsgs_[topic].push_back(payload);
+    publishedKeys_.push_back(key);
 
     return Status(0, "OK");
   }
@@ -67,6 +93,8 @@ class MockKafkaProducerPlugin : public KafkaProducerPlugin {
  public:
   std::map<rd_kafka_topic_t*, std::vector<std::string>> publishedMsgs_;
 
+  std::vector<std::string> publishedKeys_;
+
   std::atomic<int> timesFlushed_;
 
   std::atomic<int> timesPolled_;
@@ -355,6 +383,66 @@ TEST_F(KafkaProducerPluginTest, logString_multi_topic_happy_path) {
   EXPECT_TRUE(mkpp.timesPolled_.load() == 8);
 }
 
+TEST_F(KafkaProducerPluginTest, logString_partition_keys) {
+  MockKafkaProducerPlugin mkpp;
+  mkpp.setMsgKey("host_kafka_producer");
+
+  rd_kafka_topic_t* topic = reinterpret_cast<rd_kafka_topic_t*>(0x692870);
+  mkpp.setQueryToTopics({{kKafkaBaseTopic, topic}});
+
+  auto partition_key = FLAGS_logger_kafka_partition_key;
+  for (const auto& key : {"host", "query", "none"}) {
+    FLAGS_logger_kafka_partition_key = key;
+    EXPECT_TRUE(mkpp.logString("{\"name\": \"test1\"}").ok());
+  }
+  FLAGS_logger_kafka_partition_key = partition_key;
+
+  std::vector<std::string> expected = {"host_kafka_producer", "test1", ""};
+  EXPECT_EQ(expected, mkpp.publishedKeys_);
+}
+
+TEST_F(KafkaProducerPluginTest, compression_codecs) {
+  auto compression = FLAGS_logger_kafka_compression;
+  Flag::updateValue("logger_kafka_compression", "zstd");
+  EXPECT_EQ(FLAGS_logger_kafka_compression, "zstd");
+
+  // Codecs librdkafka is not built with are rejected.
+  Flag::updateValue("logger_kafka_compression", "brotli");
+  EXPECT_EQ(FLAGS_logger_kafka_compression, "zstd");
+
+  Flag::updateValue("logger_kafka_compression", "snappy");
+#ifdef _WIN32
+  EXPECT_EQ(FLAGS_logger_kafka_compression, "zstd");
+#else
+  EXPECT_EQ(FLAGS_logger_kafka_compression, "snappy");
+#endif
+
+  Flag::updateValue("logger_kafka_compression", compression);
+}
+
+TEST_F(KafkaProducerPluginTest, delivery_metrics) {
+  MockKafkaProducerPlugin mkpp;
+
+  rd_kafka_message_t message{};
+  message.len = 10;
+  message.err = RD_KAFKA_RESP_ERR_NO_ERROR;
+  onMsgDelivery(nullptr, &message, &mkpp);
+  onMsgDelivery(nullptr, &message, &mkpp);
+
+  message.err = RD_KAFKA_RESP_ERR__MSG_TIMED_OUT;
+  onMsgDelivery(nullptr, &message, &mkpp);
+
+  EXPECT_EQ(2U, mkpp.delivered());
+  EXPECT_EQ(20U, mkpp.deliveredBytes());
+  EXPECT_EQ(1U, mkpp.deliveryFailed());
+
+  // Reporting the metrics resets the counters.
+  mkpp.resetMetrics();
+  EXPECT_EQ(0U, mkpp.delivered());
+  EXPECT_EQ(0U, mkpp.deliveredBytes());
+  EXPECT_EQ(0U, mkpp.deliveryFailed());
+}
+
 TEST_F(KafkaProducerPluginTest, flush_on_stop) {
   MockKafkaProducerPlugin mkpp;
 
@@ -13,7 +13,10 @@
 #include <osquery/core/system.h>
 #include <osquery/database/database.h>
 #include <osquery/registry/registry_interface.h>
+#include <osquery/remote/requests.h>
+#include <osquery/remote/serializers/json.h>
 #include <osquery/remote/tests/test_utils.h>
+#include <osquery/remote/transports/tls.h>
 
 #include "plugins/logger/tls_logger.h"
 
@@ -32,6 +35,18 @@ class TLSLoggerTests : public testing::Test {
   void runCheck(const std::shared_ptr<TLSLogForwarder>& runner) {
     runner->check();
   }
+
+  /// Read the summary of log requests received by the test server.
+  JSON readLogRequests() {
+    auto uri = "https://" + Flag::getValue("tls_hostname") + "/test_read_logs";
+    Request<TLSTransport, JSONSerializer> request(uri);
+    request.setOption("hostname", Flag::getValue("tls_hostname"));
+
+    JSON response;
+    EXPECT_TRUE(request.call(JSON()).ok());
+    EXPECT_TRUE(request.getResponse(response).ok());
+    return response;
+  }
 };
 
 TEST_F(TLSLoggerTests, test_database) {
@@ -83,4 +98,85 @@ TEST_F(TLSLoggerTests, test_send) {
   TLSServerRunner::unsetClientConfig();
   TLSServerRunner::stop();
 }
+
+TEST_F(TLSLoggerTests, test_send_pipelined) {
+  ASSERT_TRUE(TLSServerRunner::start());
+  TLSServerRunner::setClientConfig();
+
+  auto endpoint = Flag::getValue("logger_tls_endpoint");
+  auto max_lines = Flag::getValue("logger_tls_max_lines");
+  auto max_inflight = Flag::getValue("logger_tls_max_inflight");
+  auto compress = Flag::getValue("logger_tls_compress");
+  Flag::updateValue("logger_tls_endpoint", "/log");
+  Flag::updateValue("logger_tls_max_lines", "5");
+  Flag::updateValue("logger_tls_max_inflight", "4");
+  Flag::updateValue("logger_tls_compress", "true");
+
+  // One check reads 20 lines and sends them as 4 concurrent batches.
+  auto forwarder = std::make_shared<TLSLogForwarder>();
+  for (size_t i = 0; i < 30; i++) {
+    forwarder->logString("{\"line\": " + std::to_string(i) + "}");
+  }
+  runCheck(forwarder);
+
+  std::vector<std::string> indexes;
+  scanDatabaseKeys(kLogs, indexes);
+  EXPECT_EQ(10U, indexes.size());
+
+  runCheck(forwarder);
+  indexes.clear();
+  scanDatabaseKeys(kLogs, indexes);
+  EXPECT_TRUE(indexes.empty());
+
+  auto requests = readLogRequests();
+  ASSERT_TRUE(requests.doc().IsArray());
+  EXPECT_EQ(6U, requests.doc().Size());
+
+  size_t lines = 0;
+  for (const auto& request : requests.doc().GetArray()) {
+    EXPECT_EQ("gzip", std::string(request["encoding"].GetString()));
+    EXPECT_EQ(5, request["lines"].GetInt());
+    lines += request["lines"].GetInt();
+  }
+  EXPECT_EQ(30U, lines);
+
+  Flag::updateValue("logger_tls_endpoint", endpoint);
+  Flag::updateValue("logger_tls_max_lines", max_lines);
+  Flag::updateValue("logger_tls_max_inflight", max_inflight);
+  Flag::updateValue("logger_tls_compress", compress);
+
+  TLSServerRunner::unsetClientConfig();
+  TLSServerRunner::stop();
+}
+
+TEST_F(TLSLoggerTests, test_send_zstd) {
+  ASSERT_TRUE(TLSServerRunner::start());
+  TLSServerRunner::setClientConfig();
+
+  auto endpoint = Flag::getValue("logger_tls_endpoint");
+  auto compress = Flag::getValue("logger_tls_compress");
+  auto compression = Flag::getValue("logger_tls_compression");
+  Flag::updateValue("logger_tls_endpoint", "/log");
+  Flag::updateValue("logger_tls_compress", "true");
+  Flag::updateValue("logger_tls_compression", "zstd");
+
+  auto forwarder = std::make_shared<TLSLogForwarder>();
+  forwarder->logString("{\"zstd\": true}");
+  runCheck(forwarder);
+
+  // The server decodes the body only if it has a Zstandard module.
+  auto requests = readLogRequests();
+  ASSERT_TRUE(requests.doc().IsArray());
+  ASSERT_EQ(1U, requests.doc().Size());
+  const auto& request = requests.doc()[0];
+  EXPECT_EQ("zstd", std::string(request["encoding"].GetString()));
+  EXPECT_NE(0, request["lines"].GetInt());
+
+  Flag::updateValue("logger_tls_endpoint", endpoint);
+  Flag::updateValue("logger_tls_compress", compress);
+  Flag::updateValue("logger_tls_compression", compression);
+
+  TLSServerRunner::unsetClientConfig();
+  TLSServerRunner::stop();
+}
 } // namespace osquery
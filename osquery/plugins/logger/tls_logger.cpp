@@ -15,11 +15,15 @@
 
 #include "tls_logger.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include <boost/property_tree/ptree.hpp>
 
 #include <osquery/remote/enroll/enroll.h>
 #include <osquery/core/flags.h>
 #include <osquery/core/flagalias.h>
+#include <osquery/numeric_monitoring/numeric_monitoring.h>
 #include <osquery/registry/registry.h>
 
 #include <osquery/remote/serializers/json.h>
@@ -60,13 +64,65 @@ FLAG_ALIAS(google::uint64, logger_tls_max, logger_tls_max_linesize);
 
 FLAG(bool, logger_tls_compress, false, "GZip compress TLS/HTTPS request body");
 
+FLAG(string,
+     logger_tls_compression,
+     "gzip",
+     "Compression used when logger_tls_compress is set (gzip, zstd)");
+
+FLAG(string,
+     logger_tls_compression_dictionary,
+     "",
+     "Path to a Zstandard dictionary used to compress TLS/HTTPS logs");
+
+FLAG(uint64,
+     logger_tls_max_inflight,
+     1,
+     "Max number of concurrent TLS/HTTPS log requests, each of up to "
+     "logger_tls_max_lines lines");
+
 REGISTER(TLSLoggerPlugin, "logger", "tls");
 
+namespace {
+
+/// Each check reads enough lines to fill every in-flight request.
+uint64_t getMaxLogLines() {
+  return FLAGS_logger_tls_max_lines *
+         std::max<uint64_t>(FLAGS_logger_tls_max_inflight, 1);
+}
+
+/// Record numeric monitoring points for the uploads of one send.
+void recordUpload(size_t batches,
+                  size_t failed,
+                  size_t lines,
+                  size_t bytes,
+                  int64_t elapsed_ms) {
+  monitoring::record("logger.tls.upload.batches",
+                     batches,
+                     monitoring::PreAggregationType::Sum);
+  monitoring::record("logger.tls.upload.failed",
+                     failed,
+                     monitoring::PreAggregationType::Sum);
+  monitoring::record(
+      "logger.tls.upload.lines", lines, monitoring::PreAggregationType::Sum);
+  monitoring::record(
+      "logger.tls.upload.bytes", bytes, monitoring::PreAggregationType::Sum);
+  monitoring::record("logger.tls.upload.duration_ms",
+                     elapsed_ms,
+                     monitoring::PreAggregationType::Max);
+  if (failed == 0 && elapsed_ms > 0) {
+    monitoring::record("logger.tls.upload.bytes_per_second",
+                       bytes * 1000 / elapsed_ms,
+                       monitoring::PreAggregationType::Avg);
+  }
+}
+
+} // namespace
+
 TLSLogForwarder::TLSLogForwarder()
     : BufferedLogForwarder("TLSLogForwarder",
                            "tls",
                            std::chrono::seconds(FLAGS_logger_tls_period),
-                           FLAGS_logger_tls_max_lines,
+                           getMaxLogLines(),
                            std::chrono::seconds(FLAGS_logger_tls_backoff_max)) {
   uri_ = TLSRequestHelper::makeURI(FLAGS_logger_tls_endpoint);
 }
@@ -88,6 +144,21 @@ Status TLSLoggerPlugin::setUp() {
     return s;
   }
 
+  if (FLAGS_logger_tls_compression != "gzip" &&
+      FLAGS_logger_tls_compression != "zstd") {
+    s = Status::failure("Unknown TLS logger compression: " +
+                        FLAGS_logger_tls_compression);
+    LOG(ERROR) << "Error initializing TLS logger: " << s.getMessage();
+    return s;
+  }
+
+  if (!FLAGS_logger_tls_compression_dictionary.empty()) {
+    s = loadZstdDictionary(FLAGS_logger_tls_compression_dictionary);
+    if (!s.ok()) {
+      LOG(WARNING) << s.getMessage() << ", compressing without a dictionary";
+    }
+  }
+
   auto node_key = getNodeKey("tls");
   if (!FLAGS_disable_enrollment && node_key.size() == 0) {
     // Could not generate a node key, continue logging to stderr.
@@ -113,12 +184,16 @@ void TLSLoggerPlugin::configure() {
         TLSRequestHelper::makeURI(FLAGS_logger_tls_endpoint);
     forwarder_->updated_log_period =
         std::chrono::seconds(FLAGS_logger_tls_period);
-    forwarder_->updated_max_log_lines = FLAGS_logger_tls_max_lines;
+    forwarder_->updated_max_log_lines = getMaxLogLines();
     forwarder_->updated_max_backoff_period =
         std::chrono::seconds(FLAGS_logger_tls_backoff_max);
   }
 }
 
+void TLSLogForwarder::stop() {
+  uploaders_.stop();
+}
+
 Status TLSLogForwarder::send(std::vector<std::string>& log_data,
                              const std::string& log_type) {
   // Skip sending status logs to remote server if disabled
@@ -126,15 +201,58 @@ Status TLSLogForwarder::send(std::vector<std::string>& log_data,
     return Status::success();
   }
 
+  // Split the lines into batches of up to logger_tls_max_lines, one request
+  // per batch.
+  auto batch_lines = std::max<uint64_t>(FLAGS_logger_tls_max_lines, 1);
+  auto node_key = getNodeKey("tls");
+  size_t bytes = 0;
+  std::vector<JSON> batches;
+  for (size_t start = 0; start < log_data.size(); start += batch_lines) {
+    auto first = log_data.begin() + start;
+    auto last = log_data.begin() +
+                std::min<size_t>(start + batch_lines, log_data.size());
+    std::vector<std::string> lines(std::make_move_iterator(first),
+                                   std::make_move_iterator(last));
+    batches.push_back(makeBatch(lines, log_type, node_key, bytes));
+  }
+
+  if (batches.empty()) {
+    return Status::success();
+  }
+
+  // Keep up to logger_tls_max_inflight requests open. The first uploader is
+  // this thread, the others are persistent uploader threads; each keeps
+  // reusing its TLS session across checks.
+  auto uri = uri_;
+  auto inflight = std::min<size_t>(
+      std::max<uint64_t>(FLAGS_logger_tls_max_inflight, 1), batches.size());
+  auto started = std::chrono::steady_clock::now();
+  Status error = Status::success();
+  auto failed = uploaders_.upload(uri, batches, inflight, error);
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - started)
+                     .count();
+  recordUpload(batches.size(), failed, log_data.size(), bytes, elapsed);
+
+  // A partial failure resends every line of this check, as a failure did
+  // before; the receiver must tolerate duplicates either way.
+  return error;
+}
+
+JSON TLSLogForwarder::makeBatch(std::vector<std::string>& log_data,
+                                const std::string& log_type,
+                                const std::string& node_key,
+                                size_t& bytes) {
   JSON params;
-  params.add("node_key", getNodeKey("tls"));
+  params.add("node_key", node_key);
   params.add("log_type", log_type);
 
   {
     // Read each logged line into JSON and populate a list of lines.
     // The result list will use the 'data' key.
     auto children = params.newArray();
-    iterate(log_data, ([&params, &children](std::string& item) {
+    iterate(log_data, ([&params, &children, &bytes](std::string& item) {
               // Enforce a max log line size for TLS logging.
               if (item.size() > FLAGS_logger_tls_max_linesize) {
                 LOG(WARNING)
@@ -148,19 +266,117 @@ Status TLSLogForwarder::send(std::vector<std::string>& log_data,
                 // The log line entered was not valid JSON, skip it.
                 return;
               }
+              bytes += item.size();
               std::string().swap(item);
               params.push(child.doc(), children.doc());
             }));
     params.add("data", children.doc());
   }
 
-  // The response body is ignored (status is set appropriately by
-  // TLSRequestHelper::go())
-  std::string response;
-  if (FLAGS_logger_tls_compress) {
+  if (FLAGS_logger_tls_compress && FLAGS_logger_tls_compression == "zstd") {
+    params.add("_compress", "zstd");
+    if (!FLAGS_logger_tls_compression_dictionary.empty()) {
+      params.add("_compression_dictionary",
+                 FLAGS_logger_tls_compression_dictionary);
+    }
+  } else if (FLAGS_logger_tls_compress) {
     params.add("_compress", true);
   }
-  return TLSRequestHelper::go<JSONSerializer>(uri_, params, response);
+  return params;
+}
+
+TLSLogUploaders::~TLSLogUploaders() {
+  stop();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+size_t TLSLogUploaders::upload(const std::string& uri,
+                               std::vector<JSON>& batches,
+                               size_t count,
+                               Status& error) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uri_ = &uri;
+    batches_ = &batches;
+    next_ = 0;
+    failed_ = 0;
+    error_ = Status::success();
+
+    helpers_ = (stopping_ || count == 0) ? 0 : count - 1;
+    while (threads_.size() < helpers_) {
+      auto index = threads_.size();
+      threads_.emplace_back([this, index]() { run(index); });
+    }
+
+    if (helpers_ > 0) {
+      round_++;
+      open_ = true;
+    }
+  }
+  start_.notify_all();
+
+  uploadBatches();
+
+  // Helpers that did not join yet find the round closed, wait for the others.
+  std::unique_lock<std::mutex> lock(mutex_);
+  open_ = false;
+  done_.wait(lock, [this]() { return active_ == 0; });
+
+  uri_ = nullptr;
+  batches_ = nullptr;
+  error = error_;
+  return failed_;
+}
+
+void TLSLogUploaders::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  start_.notify_all();
+}
+
+void TLSLogUploaders::run(size_t index) {
+  uint64_t round = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    start_.wait(lock, [this, index, round]() {
+      return stopping_ || (open_ && round_ != round && index < helpers_);
+    });
+    if (stopping_) {
+      return;
+    }
+
+    round = round_;
+    active_++;
+    lock.unlock();
+    uploadBatches();
+    lock.lock();
+    active_--;
+    done_.notify_all();
+  }
+}
+
+void TLSLogUploaders::uploadBatches() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (next_ < batches_->size()) {
+    auto& batch = (*batches_)[next_++];
+    const auto& uri = *uri_;
+    lock.unlock();
+
+    // The response body is ignored (status is set appropriately by
+    // TLSRequestHelper::go())
+    std::string response;
+    auto status = TLSRequestHelper::go<JSONSerializer>(uri, batch, response);
+
+    lock.lock();
+    if (!status.ok()) {
+      failed_++;
+      error_ = status;
+    }
+  }
 }
 
 void TLSLogForwarder::applyNewConfiguration() {
@@ -9,13 +9,84 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
 #include "plugins/logger/buffered.h"
 
 #include <osquery/core/plugins/logger.h>
 #include <osquery/dispatcher/dispatcher.h>
+#include <osquery/utils/json/json.h>
 
 namespace osquery {
 
+/**
+ * @brief Persistent threads sharing the uploads of a log check.
+ *
+ * The threads live as long as the forwarder, so each keeps its thread_local
+ * TLS session and Zstandard context between checks. The calling thread takes
+ * part in every round of uploads.
+ */
+class TLSLogUploaders : private boost::noncopyable {
+ public:
+  ~TLSLogUploaders();
+
+  /**
+   * @brief Send every batch to uri using up to count threads.
+   *
+   * The count includes the calling thread, threads are started on demand.
+   * Returns the number of failed batches, error is set to the last failure.
+   */
+  size_t upload(const std::string& uri,
+                std::vector<JSON>& batches,
+                size_t count,
+                Status& error);
+
+  /// Let the threads exit, the caller uploads alone from then on.
+  void stop();
+
+ private:
+  /// Wait for rounds and take part in those meant for this thread.
+  void run(size_t index);
+
+  /// Send batches until none are left in the current round.
+  void uploadBatches();
+
+ private:
+  std::mutex mutex_;
+
+  /// Signals a new round, or stopping, to the threads.
+  std::condition_variable start_;
+
+  /// Signals the end of a thread's part in a round.
+  std::condition_variable done_;
+
+  std::vector<std::thread> threads_;
+
+  /// The current round, threads only join it while it is open.
+  uint64_t round_{0};
+  bool open_{false};
+  bool stopping_{false};
+
+  /// Threads with an index below helpers_ take part in the current round.
+  size_t helpers_{0};
+
+  /// Threads working on the current round.
+  size_t active_{0};
+
+  const std::string* uri_{nullptr};
+  std::vector<JSON>* batches_{nullptr};
+  size_t next_{0};
+  size_t failed_{0};
+  Status error_;
+};
+
 /**
  * @brief A log forwarder thread flushing database-buffered logs.
  *
@@ -37,15 +108,33 @@ class TLSLogForwarder : public BufferedLogForwarder {
   std::chrono::seconds updated_max_backoff_period;
   uint64_t updated_max_log_lines;
 
+  /// Stop the uploader threads along with the forwarder.
+  void stop() override;
+
  protected:
   Status send(std::vector<std::string>& log_data,
               const std::string& log_type) override;
 
   void applyNewConfiguration() override;
 
+  /**
+   * @brief Build the request parameters of one batch of lines.
+   *
+   * The lines are moved into the request. The size of the lines that were
+   * added is accumulated in bytes.
+   */
+  JSON makeBatch(std::vector<std::string>& log_data,
+                 const std::string& log_type,
+                 const std::string& node_key,
+                 size_t& bytes);
+
   /// Endpoint URI
   std::string uri_;
 
+ private:
+  /// Threads sending the batches of a check beyond the first.
+  TLSLogUploaders uploaders_;
+
  private:
   friend class TLSLoggerTests;
 };
@@ -26,6 +26,8 @@ TEST_F(deviceFile, test_sanity) {
   // 1. Query data
   auto const data = execute_query(
       "select * from device_file where device = '' and partition = ''");
+  // A device alone walks every partition of the device.
+  execute_query("select * from device_file where device = ''");
   // 2. Check size before validation
   // ASSERT_GE(data.size(), 0ul);
   // ASSERT_EQ(data.size(), 1ul);
@@ -100,6 +100,8 @@ TABLE_ATTRIBUTES = {
     "user_data": "USER_BASED",
     "cacheable": "CACHEABLE",
     "utility": "UTILITY",
+    "expensive": "EXPENSIVE",
+    "time_ordered": "TIME_ORDERED",
     "kernel_required": "KERNEL_REQUIRED", # Deprecated
 }
 
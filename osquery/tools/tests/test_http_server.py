@@ -17,11 +17,17 @@ import string
 import sys
 import _thread
 import threading
+import zlib
 
 # Create a simple TLS/HTTP server.
-from http.server import BaseHTTPRequestHandler, HTTPServer
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
 from urllib.parse import parse_qs
 
+try:
+    import zstandard
+except ImportError:
+    zstandard = None
+
 # Script run directory, used for default values
 SCRIPT_DIR = os.path.dirname(os.path.realpath(__file__))
 
@@ -120,9 +126,14 @@ FAILED_ENROLL_RESPONSE = {"node_invalid": True}
 
 ENROLL_RESPONSE = {"node_key": "this_is_a_node_secret"}
 
+# Requests are served on concurrent threads, shared state is guarded by locks.
 RECEIVED_REQUESTS = []
+RECEIVED_REQUESTS_LOCK = threading.Lock()
+RECEIVED_LOGS = []
+RECEIVED_LOGS_LOCK = threading.Lock()
 FILE_CARVE_DIR = "/tmp/"
 FILE_CARVE_MAP = {}
+FILE_CARVE_LOCK = threading.Lock()
 
 
 def debug(response):
@@ -169,6 +180,16 @@ class RealSimpleHandler(BaseHTTPRequestHandler):
         content_len = int(self.headers.get("content-length", 0))
 
         body = self.rfile.read(content_len)
+        encoding = self.headers.get("content-encoding", "identity")
+        if encoding == "gzip":
+            body = zlib.decompress(body, 16 + zlib.MAX_WBITS)
+        elif encoding == "zstd":
+            if zstandard is None:
+                # Without the module the body is accepted but not inspected.
+                self._record_log(encoding, None)
+                self._reply({})
+                return
+            body = zstandard.ZstdDecompressor().decompress(body)
         request = json.loads(body)
 
         # This contains a base64 encoded block of a file printing to the screen
@@ -188,6 +209,8 @@ class RealSimpleHandler(BaseHTTPRequestHandler):
             self.distributed_write(request)
         elif self.path == "/test_read_requests":
             self.test_read_requests()
+        elif self.path == "/test_read_logs":
+            self.test_read_logs()
         elif self.path == "/carve_init":
             self.start_carve(request)
         elif self.path == "/carve_block":
@@ -257,13 +280,31 @@ class RealSimpleHandler(BaseHTTPRequestHandler):
         self._reply({})
 
     def log(self, request):
+        self._record_log(self.headers.get("content-encoding", "identity"), request)
         self._reply({})
 
+    def _record_log(self, encoding, request):
+        # Summarize each log request so unit tests can verify batching and
+        # compression without holding every line.
+        with RECEIVED_LOGS_LOCK:
+            RECEIVED_LOGS.append(
+                {
+                    "encoding": encoding,
+                    "lines": len(request["data"]) if request else -1,
+                }
+            )
+
     def test_read_requests(self):
         # call made by unit tests to retrieve the entire history of requests
         # made by code under test. Used by unit tests to verify that the code
         # under test made the expected calls to the TLS backend
-        self._reply(RECEIVED_REQUESTS)
+        with RECEIVED_REQUESTS_LOCK:
+            self._reply(RECEIVED_REQUESTS)
+
+    def test_read_logs(self):
+        # call made by unit tests to retrieve a summary of the log requests
+        with RECEIVED_LOGS_LOCK:
+            self._reply(RECEIVED_LOGS)
 
     # Initial endpoint, used to start a carve request
     def start_carve(self, request):
@@ -280,13 +321,14 @@ class RealSimpleHandler(BaseHTTPRequestHandler):
         # to identify this specific carve. We check all of these numbers
         # against predefined maximums to ensure that agents aren't able
         # to DOS our endpoints, and that carves are a reasonable size.
-        FILE_CARVE_MAP[sid] = {
-            "block_count": int(request["block_count"]),
-            "block_size": int(request["block_size"]),
-            "blocks_received": {},
-            "carve_size": int(request["carve_size"]),
-            "carve_guid": request["carve_id"],
-        }
+        with FILE_CARVE_LOCK:
+            FILE_CARVE_MAP[sid] = {
+                "block_count": int(request["block_count"]),
+                "block_size": int(request["block_size"]),
+                "blocks_received": {},
+                "carve_size": int(request["carve_size"]),
+                "carve_guid": request["carve_id"],
+            }
 
         # Lastly we let the agent know that the carve is good to start,
         # and send the session id back
@@ -295,6 +337,11 @@ class RealSimpleHandler(BaseHTTPRequestHandler):
     # Endpoint where the blocks of the carve are received, and
     # susequently reassembled.
     def continue_carve(self, request):
+        # Blocks of a carve may arrive concurrently, store them one at a time
+        with FILE_CARVE_LOCK:
+            self._continue_carve(request)
+
+    def _continue_carve(self, request):
         # First check if we have already received this block
         if (
             request["block_id"]
@@ -345,7 +392,8 @@ class RealSimpleHandler(BaseHTTPRequestHandler):
         # Archive the http command and the request body so that unit tests
         # can retrieve it later for verification purposes
         request["command"] = command
-        RECEIVED_REQUESTS.append(request)
+        with RECEIVED_REQUESTS_LOCK:
+            RECEIVED_REQUESTS.append(request)
 
     def _reply(self, response):
         debug("Replying: %s" % (str(response)))
@@ -390,7 +438,8 @@ def run_http_server(bind_port=80, **kwargs):
 
     reset_timeout()
 
-    httpd = HTTPServer(("localhost", bind_port), RealSimpleHandler)
+    # Serve requests concurrently, clients may pipeline uploads.
+    httpd = ThreadingHTTPServer(("localhost", bind_port), RealSimpleHandler)
     if ARGS["tls"]:
         context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
         context.load_cert_chain(certfile=ARGS["cert"], keyfile=ARGS["key"])